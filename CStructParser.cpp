@@ -0,0 +1,597 @@
+#include "CStructParser.h"
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+struct Token {
+    enum Kind { Ident, Number, Punct, Pragma, End } kind = End;
+    QString text;            // For a Pragma: "push", "pop" or "set"
+    qint64 value = 0;        // A number's value, the packing a "set" pragma sets (0 for none)
+    bool lineStart = false;  // First on its line: ends a declaration that lacks its ';'
+};
+
+int primitiveSize(const QString &type) {
+    if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
+    if (type == "int16_t" || type == "uint16_t") return 2;
+    if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
+    if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
+    return 0;
+}
+
+qint64 roundUp(qint64 value, qint64 align) {
+    return align > 1 ? (value + align - 1) / align * align : value;
+}
+
+void readPragma(const QString &line, QVector<Token> &tokens, QHash<QString, qint64> &constants) {
+    static const QRegularExpression packRe(R"(^#\s*pragma\s+pack\s*\(([^)]*)\))");
+    static const QRegularExpression defineRe(R"(^#\s*define\s+(\w+)\s+\(?\s*(0[xX][0-9a-fA-F]+|\d+)[uUlL]*\s*\)?\s*$)");
+    QRegularExpressionMatch match = packRe.match(line);
+    if (match.hasMatch()) {
+        QStringList args = match.captured(1).split(',');
+        if (args.size() == 1 && args[0].trimmed().isEmpty()) args[0] = "0"; // pack(): back to natural alignment
+        for (QString arg : args) {
+            arg = arg.trimmed();
+            if (arg.isEmpty()) continue;
+            Token t;
+            t.kind = Token::Pragma;
+            bool isNumber = false;
+            t.value = arg.toLongLong(&isNumber, 0);
+            if (arg == "push" || arg == "pop") t.text = arg;
+            else if (isNumber) t.text = "set";
+            else continue; // A push label
+            tokens.append(t);
+        }
+        return;
+    }
+    match = defineRe.match(line);
+    if (match.hasMatch()) constants[match.captured(1)] = match.captured(2).toLongLong(nullptr, 0);
+}
+
+QVector<Token> tokenize(const QString &text, QHash<QString, qint64> &constants) {
+    QVector<Token> tokens;
+    bool lineStart = true;
+    int i = 0;
+    const int n = text.size();
+    while (i < n) {
+        QChar c = text[i];
+        if (c == '\n') {
+            lineStart = true;
+            ++i;
+        } else if (c.isSpace()) {
+            ++i;
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '/') {
+            while (i < n && text[i] != '\n') ++i;
+        } else if (c == '/' && i + 1 < n && text[i + 1] == '*') {
+            int close = text.indexOf("*/", i + 2);
+            if (close < 0) break;
+            int newline = text.indexOf('\n', i);
+            if (newline >= 0 && newline < close) lineStart = true;
+            i = close + 2;
+        } else if (c == '#' && lineStart) {
+            // A directive, with its continuation lines
+            QString line;
+            while (i < n && text[i] != '\n') {
+                if (text[i] == '\\' && i + 1 < n && text[i + 1] == '\n') i += 2;
+                else line += text[i++];
+            }
+            readPragma(line, tokens, constants);
+        } else {
+            Token t;
+            t.lineStart = lineStart;
+            lineStart = false;
+            int start = i;
+            if (c.isLetter() || c == '_') {
+                while (i < n && (text[i].isLetterOrNumber() || text[i] == '_')) ++i;
+                t.kind = Token::Ident;
+            } else if (c.isDigit()) {
+                while (i < n && (text[i].isLetterOrNumber() || text[i] == '.')) ++i;
+                t.kind = Token::Number;
+                QString digits = text.mid(start, i - start);
+                while (digits.size() > 1 && QString("uUlL").contains(digits.back())) digits.chop(1);
+                t.value = digits.toLongLong(nullptr, 0);
+            } else {
+                ++i;
+                t.kind = Token::Punct;
+            }
+            t.text = text.mid(start, i - start);
+            tokens.append(t);
+        }
+    }
+    return tokens;
+}
+
+struct TypeInfo {
+    QString scalar;         // The primitive of a scalar or an enum (or the unknown name); empty for a struct
+    QString declared;       // How it was written, where that isn't scalar: "enum Mode", "unsigned int"
+    int size = 0;           // 0 for a type we don't know
+    int align = 1;
+    int elements = 1;       // Of an array typedef
+    bool isStruct = false;
+    bool anonymous = false; // A struct or union without a tag
+    QList<FieldDef> fields; // A struct's, with offsets from its start
+};
+
+struct Member {
+    TypeInfo type;
+    QString name;       // Empty for an unnamed bitfield or an anonymous struct
+    int count = 1;      // Array elements, all dimensions
+    int bitWidth = -1;  // -1 unless a bitfield
+    int pack = 0;       // #pragma pack (or packed attribute) in effect, 0 for none
+};
+
+class Parser {
+public:
+    Parser(const QString &text) { tokens = tokenize(text, constants); }
+
+    QList<FieldDef> parse() {
+        QVector<Member> loose;
+        while (peek().kind != Token::End) {
+            if (acceptPragma() || accept(";") || accept("{") || accept("}")) continue;
+            if (accept("typedef")) {
+                parseTypedef();
+                continue;
+            }
+            TypeInfo type;
+            if (!parseTypeSpec(type)) {
+                skipStatement();
+                continue;
+            }
+            if (accept(";")) continue; // Only defines a type
+            if (type.isStruct && definedBody) {
+                skipStatement(); // `struct Packet {...} packet;`: the struct is the packet
+                continue;
+            }
+            parseDeclarators(type, loose);
+        }
+        // Bare members are the struct; otherwise the last struct defined is
+        if (!loose.isEmpty()) return layout(loose, false, false).fields;
+        return lastStruct.fields;
+    }
+
+private:
+    const Token &peek(int ahead = 0) const {
+        static const Token end;
+        return pos + ahead < tokens.size() ? tokens[pos + ahead] : end;
+    }
+    bool is(const char *text, int ahead = 0) const {
+        const Token &t = peek(ahead);
+        return (t.kind == Token::Ident || t.kind == Token::Punct) && t.text == QLatin1String(text);
+    }
+    bool accept(const char *text) {
+        if (!is(text)) return false;
+        ++pos;
+        return true;
+    }
+    bool acceptPragma() {
+        if (peek().kind != Token::Pragma) return false;
+        const Token &t = tokens[pos++];
+        if (t.text == "push") packStack.append(pack);
+        else if (t.text == "pop") pack = packStack.isEmpty() ? 0 : packStack.takeLast();
+        else pack = static_cast<int>(t.value);
+        return true;
+    }
+
+    // Up to and including the next ';' outside braces, or up to an unmatched '}'
+    void skipStatement() {
+        int depth = 0;
+        while (peek().kind != Token::End) {
+            if (is("}") && depth == 0) return;
+            if (is("{")) depth++;
+            else if (is("}")) depth--;
+            else if (is(";") && depth == 0) {
+                ++pos;
+                return;
+            }
+            ++pos;
+        }
+    }
+
+    // __attribute__((...)) and the like; notes whether one packs
+    void skipAttributes(bool *packed = nullptr) {
+        while (true) {
+            if (accept("__packed")) {
+                if (packed) *packed = true;
+            } else if (is("__attribute__") || is("__attribute") || is("__declspec") || is("alignas") || is("_Alignas")) {
+                ++pos;
+                if (!accept("(")) continue;
+                for (int depth = 1; depth > 0 && peek().kind != Token::End; ++pos) {
+                    if (is("(")) depth++;
+                    else if (is(")")) depth--;
+                    else if (packed && (is("packed") || is("__packed__"))) *packed = true;
+                }
+            } else {
+                return;
+            }
+        }
+    }
+
+    // A constant expression: numbers, #define constants and enumerators with + - * / and parentheses
+    qint64 parsePrimary() {
+        if (accept("(")) {
+            qint64 v = parseExpression();
+            accept(")");
+            return v;
+        }
+        if (accept("-")) return -parsePrimary();
+        const Token &t = peek();
+        if (t.kind == Token::Number) {
+            ++pos;
+            return t.value;
+        }
+        if (t.kind == Token::Ident) {
+            ++pos;
+            return constants.value(t.text, 0);
+        }
+        return 0;
+    }
+    qint64 parseTerm() {
+        qint64 v = parsePrimary();
+        while (is("*") || is("/")) {
+            bool multiply = is("*");
+            ++pos;
+            qint64 rhs = parsePrimary();
+            v = multiply ? v * rhs : (rhs != 0 ? v / rhs : 0);
+        }
+        return v;
+    }
+    qint64 parseExpression() {
+        qint64 v = parseTerm();
+        while (is("+") || is("-")) {
+            bool add = is("+");
+            ++pos;
+            qint64 rhs = parseTerm();
+            v = add ? v + rhs : v - rhs;
+        }
+        return v;
+    }
+
+    // A C integer type spelled with keywords ("unsigned short int"), or a primitive name
+    bool parsePrimitive(TypeInfo &type) {
+        static const QStringList fixed = {"int8_t", "uint8_t", "int16_t", "uint16_t", "int32_t", "uint32_t",
+                                          "int64_t", "uint64_t", "float", "double"};
+        const QString &word = peek().text;
+        if (peek().kind != Token::Ident) return false;
+        if (fixed.contains(word)) {
+            type.scalar = word;
+        } else if (word == "bool" || word == "_Bool") {
+            type.scalar = "uint8_t";
+            type.declared = word;
+        } else {
+            int isUnsigned = 0, isSigned = 0, shorts = 0, longs = 0, chars = 0, ints = 0;
+            QStringList words;
+            while (peek().kind == Token::Ident) {
+                const QString &w = peek().text;
+                if (w == "unsigned") isUnsigned++;
+                else if (w == "signed") isSigned++;
+                else if (w == "short") shorts++;
+                else if (w == "long") longs++;
+                else if (w == "char") chars++;
+                else if (w == "int") ints++;
+                else break;
+                words << w;
+                ++pos;
+            }
+            if (words.isEmpty()) return false;
+            QString prefix = isUnsigned ? "uint" : "int";
+            if (chars) type.scalar = isUnsigned ? "uint8_t" : isSigned ? "int8_t" : "char";
+            else if (shorts) type.scalar = prefix + "16_t";
+            else if (longs >= 2) type.scalar = prefix + "64_t";
+            else type.scalar = prefix + "32_t"; // int, and long as on 32-bit targets
+            type.declared = words.join(' ');
+            if (type.declared == type.scalar) type.declared.clear();
+            type.size = type.align = primitiveSize(type.scalar);
+            return true;
+        }
+        ++pos;
+        type.size = type.align = primitiveSize(type.scalar);
+        return true;
+    }
+
+    // Enumerators become constants (for array sizes); the values themselves aren't needed
+    void parseEnumBody() {
+        qint64 next = 0;
+        while (peek().kind != Token::End && !accept("}")) {
+            if (peek().kind != Token::Ident) {
+                ++pos;
+                continue;
+            }
+            QString name = tokens[pos++].text;
+            if (accept("=")) next = parseExpression();
+            constants[name] = next++;
+            while (peek().kind != Token::End && !is(",") && !is("}")) ++pos; // What we can't evaluate
+            accept(",");
+        }
+    }
+
+    // A type, defining any struct, union or enum written out in it. definedBody tells whether
+    // it was, for the caller to tell a definition from a use.
+    bool parseTypeSpec(TypeInfo &type) {
+        definedBody = false;
+        while (accept("const") || accept("volatile") || accept("__extension__")) {}
+        bool packed = false;
+        skipAttributes(&packed);
+        if (is("struct") || is("union")) {
+            QString keyword = tokens[pos++].text;
+            skipAttributes(&packed);
+            QString tag;
+            if (peek().kind == Token::Ident) tag = tokens[pos++].text;
+            skipAttributes(&packed);
+            if (accept("{")) {
+                QVector<Member> members = parseMembers();
+                accept("}");
+                skipAttributes(&packed);
+                type = layout(members, keyword == "union", packed);
+                type.declared = tag.isEmpty() ? keyword : keyword + " " + tag;
+                type.anonymous = tag.isEmpty();
+                if (!tag.isEmpty()) types[keyword + " " + tag] = type;
+                if (depth == 0) lastStruct = type;
+                definedBody = true;
+                return true;
+            }
+            if (tag.isEmpty()) return false;
+            type = types.value(keyword + " " + tag);
+            if (!type.isStruct) type.scalar = keyword + " " + tag; // Not defined (yet): unknown
+            type.anonymous = false;
+            return true;
+        }
+        if (accept("enum")) {
+            skipAttributes();
+            QString tag;
+            if (peek().kind == Token::Ident) tag = tokens[pos++].text;
+            TypeInfo underlying;
+            if (!accept(":") || !parsePrimitive(underlying)) {
+                underlying = types.value("enum " + tag);
+                if (underlying.scalar.isEmpty()) {
+                    underlying.scalar = "int32_t";
+                    underlying.size = underlying.align = 4;
+                }
+            }
+            if (accept("{")) {
+                parseEnumBody();
+                definedBody = true;
+            }
+            skipAttributes();
+            type = underlying;
+            type.declared = tag.isEmpty() ? QString("enum") : "enum " + tag;
+            if (!tag.isEmpty()) types["enum " + tag] = type;
+            return true;
+        }
+        if (parsePrimitive(type)) return true;
+        if (peek().kind != Token::Ident) return false;
+        QString name = tokens[pos++].text;
+        if (types.contains(name)) {
+            type = types.value(name);
+            type.anonymous = false;
+        } else {
+            type.scalar = name; // Unknown: no size
+        }
+        return true;
+    }
+
+    void parseTypedef() {
+        TypeInfo type;
+        if (!parseTypeSpec(type)) {
+            skipStatement();
+            return;
+        }
+        do {
+            skipAttributes();
+            TypeInfo alias = type;
+            if (accept("*")) pointerType(alias);
+            while (accept("*")) {}
+            if (peek().kind != Token::Ident) break;
+            QString name = tokens[pos++].text;
+            while (accept("[")) {
+                alias.elements *= static_cast<int>(qMax<qint64>(0, parseExpression()));
+                accept("]");
+            }
+            skipAttributes();
+            if (!alias.isStruct) alias.declared = name;
+            alias.anonymous = false;
+            types[name] = alias;
+            if (alias.isStruct && depth == 0) lastStruct = alias;
+        } while (accept(","));
+        if (!accept(";")) skipStatement();
+    }
+
+    static void pointerType(TypeInfo &type) {
+        QString pointee = type.declared.isEmpty() ? type.scalar : type.declared;
+        type = TypeInfo();
+        type.scalar = "uint32_t";
+        type.declared = pointee + "*";
+        type.size = type.align = 4;
+    }
+
+    QVector<Member> parseMembers() {
+        QVector<Member> members;
+        depth++;
+        while (peek().kind != Token::End && !is("}")) {
+            if (acceptPragma() || accept(";")) continue;
+            TypeInfo type;
+            if (!parseTypeSpec(type)) {
+                skipStatement();
+                continue;
+            }
+            if (accept(";")) {
+                // An anonymous struct or union member: its fields are the enclosing struct's
+                if (type.isStruct && type.anonymous) {
+                    Member member;
+                    member.type = type;
+                    member.pack = pack;
+                    members.append(member);
+                }
+                continue;
+            }
+            parseDeclarators(type, members);
+        }
+        depth--;
+        return members;
+    }
+
+    void parseDeclarators(const TypeInfo &type, QVector<Member> &members) {
+        do {
+            Member member;
+            member.type = type;
+            member.pack = pack;
+            bool packed = false;
+            skipAttributes(&packed);
+            if (accept("*")) pointerType(member.type);
+            while (accept("*")) {}
+            if (peek().kind == Token::Ident && !is("__attribute__")) member.name = tokens[pos++].text;
+            while (accept("[")) {
+                member.count *= static_cast<int>(qMax<qint64>(0, parseExpression()));
+                accept("]");
+            }
+            if (accept(":")) member.bitWidth = static_cast<int>(qMax<qint64>(0, parseExpression()));
+            skipAttributes(&packed);
+            if (packed) member.pack = 1;
+            if (accept("=")) {
+                while (peek().kind != Token::End && !is(",") && !is(";") && !is("}")) ++pos;
+            }
+            if (!member.name.isEmpty() || member.bitWidth >= 0) members.append(member);
+        } while (accept(","));
+        // A missing ';' is fine at the end of a line
+        if (!accept(";") && !peek().lineStart && !is("}")) skipStatement();
+    }
+
+    // Members placed one after the other (all at 0 in a union), each aligned to its type's
+    // alignment capped by the packing in effect where it was declared (1 for a packed
+    // struct), bitfields packed into units of their type
+    TypeInfo layout(const QVector<Member> &members, bool isUnion, bool packed) const {
+        TypeInfo result;
+        result.isStruct = true;
+        QList<FieldDef> &out = result.fields;
+        qint64 bit = 0, endBit = 0;
+        int maxAlign = 1;
+        auto effective = [&](const Member &m, int align) {
+            int p = packed ? 1 : m.pack;
+            return p > 0 ? qMax(1, qMin(align, p)) : qMax(1, align);
+        };
+        for (const Member &m : members) {
+            if (isUnion) bit = 0;
+            const TypeInfo &t = m.type;
+            if (m.bitWidth >= 0) {
+                if (t.isStruct || t.size == 0 || t.scalar == "float" || t.scalar == "double") continue; // Not an integer
+                const int unitBits = t.size * 8;
+                const int width = qMin(m.bitWidth, unitBits);
+                const int align = effective(m, t.align);
+                if (width == 0) {
+                    // To the type's own alignment, packed or not
+                    bit = roundUp(bit, qint64(t.align) * 8);
+                    continue;
+                }
+                QString unitType = t.scalar;
+                qint64 unit;
+                int shift;
+                if (align < t.size || packed || m.pack == 1) {
+                    // Packed: straight after the previous bits, which may straddle units of
+                    // the type. Read from the byte they start in, as an integer wide enough.
+                    if (bit % 8 + width > 64) bit = roundUp(bit, 8);
+                    unit = bit / 8;
+                    shift = static_cast<int>(bit % 8);
+                    int bytes = 1;
+                    while (bytes * 8 < shift + width) bytes *= 2;
+                    bool isSigned = t.scalar.startsWith("int");
+                    unitType = QString("%1%2_t").arg(isSigned ? "int" : "uint").arg(bytes * 8);
+                } else {
+                    // Not straddling a boundary of its type's size
+                    if (bit % unitBits + width > unitBits) bit = roundUp(bit, unitBits);
+                    unit = bit / unitBits * t.size;
+                    shift = static_cast<int>(bit % unitBits);
+                }
+                if (!m.name.isEmpty()) {
+                    FieldDef f;
+                    f.type = unitType;
+                    f.name = m.name;
+                    f.count = 1;
+                    f.offset = static_cast<int>(unit);
+                    f.align = align;
+                    f.bitOffset = shift;
+                    f.bitWidth = width;
+                    f.declaredType = QString("%1 : %2").arg(t.declared.isEmpty() ? t.scalar : t.declared).arg(width);
+                    out.append(f);
+                    maxAlign = qMax(maxAlign, align); // Unnamed bitfields don't align the struct
+                }
+                bit += width;
+                endBit = qMax(endBit, bit);
+                continue;
+            }
+            const int align = effective(m, t.align);
+            bit = roundUp(bit, qint64(align) * 8);
+            const qint64 base = bit / 8;
+            const int count = m.count * t.elements;
+            if (t.isStruct) {
+                for (int e = 0; e < count; ++e) {
+                    QString prefix;
+                    if (!m.name.isEmpty()) prefix = count > 1 ? QString("%1[%2].").arg(m.name).arg(e) : m.name + ".";
+                    for (FieldDef f : t.fields) {
+                        f.name = prefix + f.name;
+                        f.offset += static_cast<int>(base + qint64(e) * t.size);
+                        f.align = effective(m, f.align);
+                        f.tail = 0;
+                        out.append(f);
+                    }
+                }
+            } else if (!m.name.isEmpty()) {
+                FieldDef f;
+                f.type = t.scalar;
+                f.name = m.name;
+                f.count = count;
+                f.offset = static_cast<int>(base);
+                f.align = align;
+                f.declaredType = t.declared;
+                out.append(f);
+            }
+            maxAlign = qMax(maxAlign, align);
+            bit += qint64(t.size) * 8 * count;
+            endBit = qMax(endBit, bit);
+        }
+        const qint64 size = roundUp((endBit + 7) / 8, maxAlign);
+        for (FieldDef &f : out) {
+            // A packed bitfield's unit reaching past the struct: the unit ending with it
+            // holds the same bits (counted from the least significant, little-endian)
+            int unitSize = primitiveSize(f.type);
+            int over = static_cast<int>(f.offset + unitSize - size);
+            if (f.bitWidth > 0 && over > 0 && f.offset >= over) {
+                f.offset -= over;
+                f.bitOffset += 8 * over;
+            }
+        }
+        if (!out.isEmpty()) {
+            FieldDef &last = out.last();
+            int bytes = primitiveSize(last.type) * (last.bitWidth > 0 ? 1 : last.count);
+            last.tail = qMax(0, static_cast<int>(size) - (last.offset + bytes));
+        }
+        result.size = static_cast<int>(size);
+        result.align = maxAlign;
+        return result;
+    }
+
+    QVector<Token> tokens;
+    int pos = 0;
+    QHash<QString, qint64> constants;  // #define and enumerator values
+    QHash<QString, TypeInfo> types;    // "struct Tag", "union Tag", "enum Tag" and typedef names
+    QVector<int> packStack;
+    int pack = 0;                      // #pragma pack in effect, 0 for none
+    int depth = 0;                     // Of struct bodies being parsed
+    bool definedBody = false;
+    TypeInfo lastStruct;               // The last struct defined at the top level
+};
+
+} // namespace
+
+QList<FieldDef> parseCStruct(const QString &structText) {
+    QList<FieldDef> fields = Parser(structText).parse();
+#ifdef ENABLE_DEBUG
+    for (const FieldDef &field : fields) {
+        qDebug() << "[parseCStruct] Found field:" << field.type << field.name << "count:" << field.count
+                 << "offset:" << field.offset << "bits:" << field.bitOffset << field.bitWidth;
+    }
+#endif
+    return fields;
+}
@@ -0,0 +1,30 @@
+#ifndef CSTRUCTPARSER_H
+#define CSTRUCTPARSER_H
+
+#include <QString>
+#include <QList>
+#include "FieldDef.h"
+
+// Parses the C declarations of a packet struct into its fields, each placed (offset, bitfield
+// position, alignment) the way GCC and Clang lay it out for a little-endian target.
+//
+// The text is either bare member declarations, one struct's worth, or type definitions of
+// which the last struct is the packet (e.g. a header struct, a status enum, then the packet
+// typedef'd struct using both). Understood:
+// - the fixed-width types, float, double, char, bool and the C integer types (`unsigned
+//   short`, `long long`...); long and pointers are taken as 4 bytes, as on 32-bit firmware
+// - arrays, multi-dimensional ones flattened, with sizes from numbers, #define constants or
+//   enumerators
+// - nested structs and unions, named or anonymous, and arrays of them: their members become
+//   fields of their own, qualified like "header.seq" or "points[2].x"
+// - enums, as their underlying type (`enum Mode : uint8_t`), int by default
+// - bitfields, packed into units of their type without straddling one; unnamed ones and
+//   `: 0` only move the position
+// - #pragma pack(n), push and pop, and __attribute__((packed)) on a struct or a member. Packed
+//   bitfields follow on bit by bit; one straddling units of its type gets a wider integer
+//   type, its storage unit being the bytes it spans
+// Anything else is skipped up to the next ';'. A member of a type it doesn't know is kept
+// with no size, as its values can't be read.
+QList<FieldDef> parseCStruct(const QString &structText);
+
+#endif // CSTRUCTPARSER_H
@@ -0,0 +1,379 @@
+#include "CaptureBackend.h"
+#include "PacketMmapBackend.h"
+#include "XdpBackend.h"
+#include <arpa/inet.h>
+#include <linux/sock_diag.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#ifndef SO_BUSY_POLL
+#define SO_BUSY_POLL 46
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SO_MEMINFO
+#define SO_MEMINFO 55
+#endif
+
+namespace {
+// Room for the receive timestamp, the socket drop count and, with UDP_GRO, the segment size
+constexpr size_t CONTROL_SIZE = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(int));
+
+// SO_RXQ_OVFL: the socket's running count of datagrams dropped for a full receive buffer,
+// attached to every datagram once it is non-zero (not by every kernel's UDP; see pollKernelDrops)
+void recordKernelDrops(const msghdr& msg, CaptureStats& stats) {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops;
+            memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            stats.raiseKernelDrops(drops);
+            return;
+        }
+    }
+}
+
+// gso_size of a UDP_GRO read, or 0 if the kernel did not coalesce it
+size_t groSegmentSize(const msghdr& msg) {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int size;
+            memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+            return size > 0 ? static_cast<size_t>(size) : 0;
+        }
+    }
+    return 0;
+}
+
+uint64_t senderOf(const sockaddr_in& addr) {
+    return sourceId(ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port));
+}
+}
+
+int64_t realtimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t kernelTimestampNs(const msghdr& msg) {
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec stamp;
+            memcpy(&stamp, CMSG_DATA(cmsg), sizeof(stamp));
+            return static_cast<int64_t>(stamp.tv_sec) * 1000000000LL + stamp.tv_nsec;
+        }
+    }
+    return 0;
+}
+
+void readSocketDrops(int fd, CaptureStats& stats) {
+    uint32_t meminfo[SK_MEMINFO_VARS] = {};
+    socklen_t length = sizeof(meminfo);
+    if (getsockopt(fd, SOL_SOCKET, SO_MEMINFO, meminfo, &length) == 0 && length > SK_MEMINFO_DROPS * sizeof(uint32_t)) {
+        stats.raiseKernelDrops(meminfo[SK_MEMINFO_DROPS]);
+    }
+}
+
+void recordSocketLatency(int fd, LatencyStats& stats) {
+    timespec stamp;
+    if (ioctl(fd, SIOCGSTAMPNS, &stamp) != 0) return; // ENOENT until the first stamped datagram
+    int64_t ns = realtimeNs() - (static_cast<int64_t>(stamp.tv_sec) * 1000000000LL + stamp.tv_nsec);
+    if (ns >= 0) stats.record(ns);
+}
+
+bool udpPayload(const uint8_t* ip, size_t& length, uint16_t port, const uint8_t*& payload,
+                uint64_t* source) {
+    if (length < 28 || (ip[0] >> 4) != 4 || ip[9] != IPPROTO_UDP) return false;
+    size_t ipHeader = (ip[0] & 0x0f) * 4;
+    // Fragments are left to the kernel's reassembly on the socket path
+    if (ipHeader < 20 || (((ip[6] << 8) | ip[7]) & 0x3fff) != 0) return false;
+    if (length < ipHeader + 8) return false;
+    const uint8_t* udp = ip + ipHeader;
+    if (((udp[2] << 8) | udp[3]) != port) return false;
+    size_t udpLength = (udp[4] << 8) | udp[5];
+    if (udpLength < 8) return false;
+    payload = udp + 8;
+    length = std::min(udpLength - 8, length - ipHeader - 8);
+    if (source) {
+        uint32_t address = (uint32_t(ip[12]) << 24) | (ip[13] << 16) | (ip[14] << 8) | ip[15];
+        *source = sourceId(address, static_cast<uint16_t>((udp[0] << 8) | udp[1]));
+    }
+    return true;
+}
+
+void CaptureBackend::releaseConsumed() {
+    uint64_t consumed = ring.consumed();
+    while (!held.empty() && held.front().first <= consumed) {
+        releaseBuffer(held.front().second);
+        held.pop_front();
+    }
+}
+
+void CaptureBackend::releaseAll() {
+    for (const auto& entry : held) releaseBuffer(entry.second);
+    held.clear();
+}
+
+std::unique_ptr<CaptureBackend> createCaptureBackend(CaptureBackend::Kind kind, PacketRing& ring, CaptureStats& stats) {
+    switch (kind) {
+    case CaptureBackend::Kind::PacketMmap:
+        return std::make_unique<PacketMmapBackend>(ring, stats);
+    case CaptureBackend::Kind::Xdp:
+        return std::make_unique<XdpBackend>(ring, stats);
+    case CaptureBackend::Kind::Socket:
+        break;
+    }
+    return std::make_unique<SocketBackend>(ring, stats);
+}
+
+SocketBackend::SocketBackend(PacketRing& ring, CaptureStats& stats) : CaptureBackend(ring, stats) {
+    headers.resize(BATCH_SIZE);
+    iovecs.resize(2 * BATCH_SIZE);
+    senders.resize(BATCH_SIZE);
+    reserved.resize(BATCH_SIZE);
+    datagrams.resize(BATCH_SIZE);
+    scratch.reset(new char[BATCH_SIZE * ring.maxPacketSize()]);
+    control = std::make_unique<char[]>(BATCH_SIZE * CONTROL_SIZE);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        headers[i] = mmsghdr{};
+        headers[i].msg_hdr.msg_iov = &iovecs[2 * i];
+        headers[i].msg_hdr.msg_name = &senders[i];
+    }
+}
+
+SocketBackend::~SocketBackend() {
+    close();
+}
+
+bool SocketBackend::open(const CaptureConfig& config, std::string& error) {
+    if (sockFd >= 0) return true;
+    sockFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockFd < 0) {
+        error = std::string("Failed to create UDP socket: ") + strerror(errno);
+        return false;
+    }
+    // Try to force past rmem_max first (needs CAP_NET_ADMIN), then fall back to the normal option
+    int bufSize = 64 * 1024 * 1024;
+    if (setsockopt(sockFd, SOL_SOCKET, SO_RCVBUFFORCE, &bufSize, sizeof(bufSize)) != 0) {
+        setsockopt(sockFd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof(bufSize));
+    }
+
+    // Kernel receive timestamps arrive with each datagram as SCM_TIMESTAMPNS control data
+    int one = 1;
+    setsockopt(sockFd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+    // ... and, once the receive buffer has overflowed, the socket's drop count (SO_RXQ_OVFL)
+    setsockopt(sockFd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+
+    if (config.gro) {
+        if (setsockopt(sockFd, SOL_UDP, UDP_GRO, &one, sizeof(one)) != 0) {
+            error = std::string("UDP_GRO not supported (needs Linux 5.0+): ") + strerror(errno);
+            close();
+            return false;
+        }
+        groBuffers = std::make_unique<char[]>(GRO_BATCH * GRO_BUFFER_SIZE);
+    }
+
+    if (config.reusePort) {
+        if (setsockopt(sockFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) {
+            error = std::string("SO_REUSEPORT failed: ") + strerror(errno);
+            close();
+            return false;
+        }
+    }
+
+    ip_mreqn membership{};
+    if (!config.multicastGroup.empty()) {
+        if (inet_pton(AF_INET, config.multicastGroup.c_str(), &membership.imr_multiaddr) != 1
+            || !IN_MULTICAST(ntohl(membership.imr_multiaddr.s_addr))) {
+            error = "Not an IPv4 multicast group: " + config.multicastGroup;
+            close();
+            return false;
+        }
+        if (!config.interfaceName.empty()) {
+            membership.imr_ifindex = if_nametoindex(config.interfaceName.c_str());
+            if (membership.imr_ifindex == 0) {
+                error = "Unknown interface " + config.interfaceName;
+                close();
+                return false;
+            }
+        }
+        // Other subscribers of the group on this host may bind the same port
+        setsockopt(sockFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(config.port);
+    if (::bind(sockFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = "Failed to bind UDP socket on port " + std::to_string(config.port) + ": " + strerror(errno);
+        close();
+        return false;
+    }
+    if (!config.multicastGroup.empty()) {
+        if (setsockopt(sockFd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+            error = "Failed to join " + config.multicastGroup + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        // Without this, a socket bound to INADDR_ANY also gets every other joined group on the port
+        int zero = 0;
+        setsockopt(sockFd, IPPROTO_IP, IP_MULTICAST_ALL, &zero, sizeof(zero));
+    }
+    return true;
+}
+
+void SocketBackend::close() {
+    if (sockFd >= 0) {
+        ::close(sockFd);
+        sockFd = -1;
+    }
+    groBuffers.reset();
+}
+
+void SocketBackend::enableBusyPoll(int us) {
+    // Not fatal when refused (raising it above net.core.busy_read needs CAP_NET_ADMIN)
+    setsockopt(sockFd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+}
+
+int SocketBackend::receiveBatch(bool& drained) {
+    if (groBuffers) return receiveGroBatch(drained);
+
+    // Point the iovecs at ring regions sized for the datagrams seen so far, with the rest of
+    // a larger datagram spilling into scratch. Beyond the free space, all of it lands in scratch.
+    int nReserved = ring.reserve(reserved.data(), BATCH_SIZE);
+    size_t regionSize = ring.reserveSize();
+    size_t maxSize = ring.maxPacketSize();
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        char* spill = scratch.get() + i * maxSize;
+        if (i < nReserved) {
+            iovecs[2 * i] = {reserved[i], regionSize};
+            iovecs[2 * i + 1] = {spill, maxSize - regionSize};
+            headers[i].msg_hdr.msg_iovlen = 2;
+        } else {
+            iovecs[2 * i] = {spill, maxSize};
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        // recvmmsg shrinks msg_controllen to what was used, so reset it every batch
+        headers[i].msg_hdr.msg_control = control.get() + i * CONTROL_SIZE;
+        headers[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+        headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+    int n = recvmmsg(sockFd, headers.data(), BATCH_SIZE, MSG_DONTWAIT, nullptr);
+    drained = n < BATCH_SIZE; // Short batch means the queue is empty
+    if (n <= 0) return 0; // EAGAIN: socket drained
+
+    // One clock read per batch: latency of the newest datagram, and the fallback stamp
+    // for any datagram the kernel did not timestamp
+    int64_t nowNs = realtimeNs();
+    int64_t newestNs = kernelTimestampNs(headers[n - 1].msg_hdr);
+    if (newestNs > 0 && nowNs >= newestNs) stats.latency.record(nowNs - newestNs);
+    recordKernelDrops(headers[n - 1].msg_hdr, stats);
+
+    // Hand the batch to the parser in place, then publish the regions. From the first datagram
+    // that spilled or found no region on, datagrams are joined in scratch and copied in, which
+    // keeps ring order and lets the copies use space freed since the reserve.
+    int count = 0;
+    int slotIndex[BATCH_SIZE];
+    int firstCopied = BATCH_SIZE;
+    size_t largest = 0;
+    for (int i = 0; i < n; ++i) {
+        if (headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            stats.truncated.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        size_t length = headers[i].msg_len;
+        char* spill = scratch.get() + i * maxSize;
+        char* data = i < nReserved ? reserved[i] : spill;
+        if ((i >= nReserved || length > regionSize) && firstCopied == BATCH_SIZE) firstCopied = count;
+        if (count >= firstCopied && i < nReserved) {
+            size_t inRegion = std::min(length, regionSize);
+            memmove(spill + inRegion, spill, length - inRegion);
+            memcpy(spill, data, inRegion);
+            data = spill;
+        }
+        largest = std::max(largest, length);
+        int64_t stampNs = kernelTimestampNs(headers[i].msg_hdr);
+        datagrams[count] = {data, length, stampNs > 0 ? stampNs : nowNs, senderOf(senders[i])};
+        slotIndex[count] = i;
+        count++;
+    }
+    if (count > 0 && batchHandler) batchHandler(datagrams.data(), count);
+    for (int k = 0; k < count; ++k) {
+        const Datagram& d = datagrams[k];
+        if (k < firstCopied) {
+            ring.commit(slotIndex[k], d.size, d.timestampNs, d.source);
+        } else if (!ring.push(d.data, d.size, d.timestampNs, d.source)) {
+            stats.ringDrops.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (largest > regionSize) ring.growReserveSize(largest);
+    return n;
+}
+
+int SocketBackend::receiveGroBatch(bool& drained) {
+    for (int i = 0; i < GRO_BATCH; ++i) {
+        iovecs[2 * i] = {groBuffers.get() + i * GRO_BUFFER_SIZE, GRO_BUFFER_SIZE};
+        headers[i].msg_hdr.msg_iovlen = 1;
+        headers[i].msg_hdr.msg_control = control.get() + i * CONTROL_SIZE;
+        headers[i].msg_hdr.msg_controllen = CONTROL_SIZE;
+        headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+    int n = recvmmsg(sockFd, headers.data(), GRO_BATCH, MSG_DONTWAIT, nullptr);
+    drained = n < GRO_BATCH;
+    if (n <= 0) return 0;
+
+    int64_t nowNs = realtimeNs();
+    int64_t newestNs = kernelTimestampNs(headers[n - 1].msg_hdr);
+    if (newestNs > 0 && nowNs >= newestNs) stats.latency.record(nowNs - newestNs);
+    recordKernelDrops(headers[n - 1].msg_hdr, stats);
+
+    int received = 0;
+    int count = 0;
+    auto publish = [&]() {
+        if (count > 0 && batchHandler) batchHandler(datagrams.data(), count);
+        for (int k = 0; k < count; ++k) {
+            const Datagram& d = datagrams[k];
+            if (d.size > ring.maxPacketSize()) {
+                stats.truncated.fetch_add(1, std::memory_order_relaxed);
+            } else if (!ring.push(d.data, d.size, d.timestampNs, d.source)) {
+                stats.ringDrops.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        count = 0;
+    };
+    for (int i = 0; i < n; ++i) {
+        const msghdr& msg = headers[i].msg_hdr;
+        if (msg.msg_flags & MSG_TRUNC) {
+            stats.truncated.fetch_add(1, std::memory_order_relaxed);
+            received++;
+            continue;
+        }
+        // All segments of one read share the coalesced packet's timestamp
+        int64_t stampNs = kernelTimestampNs(msg);
+        if (stampNs <= 0) stampNs = nowNs;
+        uint64_t source = senderOf(senders[i]);
+        char* data = static_cast<char*>(iovecs[2 * i].iov_base);
+        size_t length = headers[i].msg_len;
+        size_t segment = groSegmentSize(msg);
+        if (segment == 0) segment = length;
+        size_t offset = 0;
+        do {
+            datagrams[count++] = {data + offset, std::min(segment, length - offset), stampNs, source};
+            received++;
+            if (count == BATCH_SIZE) publish();
+            offset += segment;
+        } while (offset < length);
+    }
+    publish();
+    return received;
+}
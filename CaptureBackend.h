@@ -0,0 +1,141 @@
+#ifndef CAPTUREBACKEND_H
+#define CAPTUREBACKEND_H
+
+#include "CaptureStats.h"
+#include "PacketRing.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Reads the socket's drop count (SO_MEMINFO) into stats.kernelDrops, for sockets read without
+// SO_RXQ_OVFL control messages (QUdpSocket, and kernels whose UDP does not send them)
+void readSocketDrops(int fd, CaptureStats& stats);
+
+// Records now - (kernel receive time of the last datagram read from fd), via SIOCGSTAMPNS
+void recordSocketLatency(int fd, LatencyStats& stats);
+
+// Kernel receive time of a datagram from its SCM_TIMESTAMPNS control message, or 0 if absent
+int64_t kernelTimestampNs(const msghdr& msg);
+
+// CLOCK_REALTIME in ns, the clock kernel receive timestamps are taken against
+int64_t realtimeNs();
+
+// Payload of an IPv4/UDP packet for `port` starting at `ip`, or false if it is something else.
+// `length` is the number of captured bytes on input and the payload size on output.
+// `source`, if given, receives the sender's sourceId().
+bool udpPayload(const uint8_t* ip, size_t& length, uint16_t port, const uint8_t*& payload,
+                uint64_t* source = nullptr);
+
+struct CaptureConfig {
+    uint16_t port = 0;
+    std::string interfaceName;  // AF_PACKET: empty captures on all interfaces; AF_XDP: required
+    bool reusePort = false;     // Socket: share the port with other sockets (SO_REUSEPORT sharding)
+    std::string multicastGroup; // Socket: IPv4 group to join (on interfaceName if set), empty for unicast
+    bool gro = false;           // Socket: UDP_GRO, the kernel coalesces same-flow datagrams into one read
+};
+
+// Receive side of a ReceiveEngine: where datagrams come from and how they reach the ring.
+// A backend hands each batch to the handler in place, then publishes it to the ring.
+class CaptureBackend {
+public:
+    enum class Kind {
+        Socket,      // UDP socket read with recvmmsg straight into the ring
+        PacketMmap,  // AF_PACKET TPACKET_V3 block ring shared with the kernel (root)
+        Xdp          // AF_XDP socket in generic (SKB, copy) mode (root)
+    };
+
+    struct Datagram {
+        char* data;
+        size_t size;
+        int64_t timestampNs; // Kernel receive time where the backend has one, wall-clock ns
+        uint64_t source = 0; // Sender, see sourceId()
+    };
+    // Called once per batch, with the datagrams still in their unpublished buffers
+    using BatchHandler = std::function<void(const Datagram* datagrams, int count)>;
+
+    static constexpr int BATCH_SIZE = 64;
+
+    CaptureBackend(PacketRing& ring, CaptureStats& stats) : ring(ring), stats(stats) {}
+    virtual ~CaptureBackend() = default;
+
+    virtual bool open(const CaptureConfig& config, std::string& error) = 0;
+    virtual void close() = 0;
+    virtual int fd() const = 0; // Pollable for readability
+
+    // Non-blocking: receive what is pending (up to one batch or block), hand it to the handler
+    // and publish it. Sets drained once nothing more is queued.
+    virtual int receiveBatch(bool& drained) = 0;
+
+    // Ask the kernel to busy-poll the device queue on blocking reads (where supported)
+    virtual void enableBusyPoll(int /*us*/) {}
+
+    // Refresh stats.kernelDrops where the kernel does not report it alongside the data.
+    // Called by the stats timer, possibly from another thread than receiveBatch().
+    virtual void pollKernelDrops() {}
+
+    // True when published ring packets can point into backend memory. Such packets are
+    // only valid while the backend is open; the consumer must be stopped before close().
+    virtual bool lendsBuffers() const { return false; }
+
+    void setBatchHandler(BatchHandler onBatch) { batchHandler = std::move(onBatch); }
+
+protected:
+    // Zero-copy publishing: a kernel buffer that backs published ring packets is held until
+    // the ring consumer has popped its last packet, then returned through releaseBuffer()
+    void holdUntilConsumed(uint64_t token) { held.emplace_back(ring.published(), token); }
+    void releaseConsumed();
+    void releaseAll();
+    size_t heldCount() const { return held.size(); }
+    virtual void releaseBuffer(uint64_t /*token*/) {}
+
+    PacketRing& ring;
+    CaptureStats& stats;
+    BatchHandler batchHandler;
+
+private:
+    std::deque<std::pair<uint64_t, uint64_t>> held; // (ring packets published, token)
+};
+
+std::unique_ptr<CaptureBackend> createCaptureBackend(CaptureBackend::Kind kind, PacketRing& ring, CaptureStats& stats);
+
+// Plain UDP socket, read with recvmmsg straight into reserved ring regions
+class SocketBackend : public CaptureBackend {
+public:
+    SocketBackend(PacketRing& ring, CaptureStats& stats);
+    ~SocketBackend() override;
+
+    bool open(const CaptureConfig& config, std::string& error) override;
+    void close() override;
+    int fd() const override { return sockFd; }
+    int receiveBatch(bool& drained) override;
+    void enableBusyPoll(int us) override;
+    void pollKernelDrops() override { readSocketDrops(sockFd, stats); }
+
+    // UDP_GRO reads: a few large buffers, each holding up to 64 KiB of coalesced datagrams
+    static constexpr int GRO_BATCH = 16;
+    static constexpr size_t GRO_BUFFER_SIZE = 65536;
+
+private:
+    // Splits each coalesced read on its gso_size boundaries; segments are copied into the ring
+    int receiveGroBatch(bool& drained);
+
+    int sockFd = -1;
+    std::unique_ptr<char[]> groBuffers; // Only allocated with UDP_GRO
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> iovecs; // Two per message: ring region, then spill into scratch
+    std::vector<sockaddr_in> senders;
+    std::unique_ptr<char[]> control; // Per-message cmsg space for the receive timestamps
+    std::vector<char*> reserved;
+    std::vector<Datagram> datagrams;
+    std::unique_ptr<char[]> scratch; // Discard buffers for whatever does not fit in the ring
+};
+
+#endif // CAPTUREBACKEND_H
@@ -0,0 +1,65 @@
+#ifndef CAPTURESTATS_H
+#define CAPTURESTATS_H
+
+#include <atomic>
+#include <initializer_list>
+#include <cstdint>
+
+// Kernel-to-user latency, sampled from the socket's last receive timestamp.
+// Written by the receive thread, read and reset once per second by the stats timer.
+struct LatencyStats {
+    std::atomic<int64_t> sumNs{0};
+    std::atomic<int64_t> maxNs{0};
+    std::atomic<int64_t> samples{0};
+
+    void record(int64_t ns) {
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        int64_t prev = maxNs.load(std::memory_order_relaxed);
+        while (ns > prev && !maxNs.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+    }
+    // Average and maximum in microseconds since the last call
+    void take(double& avgUs, double& maxUs) {
+        int64_t n = samples.exchange(0, std::memory_order_relaxed);
+        int64_t sum = sumNs.exchange(0, std::memory_order_relaxed);
+        int64_t mx = maxNs.exchange(0, std::memory_order_relaxed);
+        avgUs = n > 0 ? sum / 1000.0 / n : 0.0;
+        maxUs = mx / 1000.0;
+    }
+};
+
+// Where datagrams were lost on the way in, one counter per pipeline stage, and the
+// receive latency. Shared by every receive path (capture backends and the QUdpSocket
+// path); written by the receive thread, read by the stats timer.
+struct CaptureStats {
+    std::atomic<uint64_t> kernelDrops{0}; // Dropped before we could read them: socket buffer or capture ring full
+    std::atomic<uint64_t> ringDrops{0};   // Datagrams that found the ring full
+    std::atomic<uint64_t> truncated{0};   // Datagrams larger than a ring slot or capture frame
+    std::atomic<uint64_t> shortReads{0};  // Reads that returned less than the datagram's size
+    LatencyStats latency;
+
+    // For running totals kept by the kernel, which may be read through more than one channel
+    void raiseKernelDrops(uint64_t total) {
+        uint64_t prev = kernelDrops.load(std::memory_order_relaxed);
+        while (total > prev && !kernelDrops.compare_exchange_weak(prev, total, std::memory_order_relaxed)) {}
+    }
+
+    // Totals of the four drop counters, for summing over shards and streams
+    struct Drops {
+        uint64_t kernel = 0;
+        uint64_t ringFull = 0;
+        uint64_t oversized = 0;
+        uint64_t shortReads = 0;
+    };
+    void resetDrops() {
+        for (auto* counter : {&kernelDrops, &ringDrops, &truncated, &shortReads}) counter->store(0, std::memory_order_relaxed);
+    }
+    void addDropsTo(Drops& drops) const {
+        drops.kernel += kernelDrops.load(std::memory_order_relaxed);
+        drops.ringFull += ringDrops.load(std::memory_order_relaxed);
+        drops.oversized += truncated.load(std::memory_order_relaxed);
+        drops.shortReads += shortReads.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // CAPTURESTATS_H
@@ -0,0 +1,168 @@
+#include "ChannelProgram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Each instruction is one of these loops over a block; d may be a or b (in place)
+template <typename F>
+inline void unary(float* d, const float* a, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) d[i] = f(a[i]);
+}
+
+template <typename F>
+inline void binary(float* d, const float* a, const float* b, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) d[i] = f(a[i], b[i]);
+}
+
+float interpolate(float x, const float* points, uint32_t count) {
+    // points: x0, y0, x1, y1... with increasing x
+    if (!(x > points[0])) return points[1];
+    if (x >= points[2 * (count - 1)]) return points[2 * count - 1];
+    uint32_t lo = 0, hi = count - 1; // points[2*lo] < x <= points[2*hi]
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (points[2 * mid] < x) lo = mid;
+        else hi = mid;
+    }
+    float x0 = points[2 * lo], y0 = points[2 * lo + 1];
+    float x1 = points[2 * hi], y1 = points[2 * hi + 1];
+    return y0 + (x - x0) * (y1 - y0) / (x1 - x0);
+}
+
+} // namespace
+
+int ChannelProgram::addInput(int field, int element) {
+    for (size_t i = 0; i < inputList.size(); ++i) {
+        if (inputList[i].first == field && inputList[i].second == element) return static_cast<int>(i);
+    }
+    if (inputList.size() >= MAX_INPUTS) return -1;
+    inputList.emplace_back(field, element);
+    return static_cast<int>(inputList.size() - 1);
+}
+
+uint32_t ChannelProgram::addTable(const std::vector<float>& values) {
+    uint32_t index = static_cast<uint32_t>(table.size());
+    table.insert(table.end(), values.begin(), values.end());
+    return index;
+}
+
+bool ChannelProgram::emit(const Instruction& instruction) {
+    int pops = 0, pushes = 1;
+    switch (instruction.op) {
+    case Op::Input: case Op::Const: break;
+    case Op::Add: case Op::Sub: case Op::Mul: case Op::Div: case Op::Pow: case Op::Min: case Op::Max: case Op::Atan2:
+        pops = 2;
+        break;
+    default:
+        pops = 1;
+        break;
+    }
+    if (depth < pops || depth - pops + pushes > MAX_STACK) return false;
+    depth += pushes - pops;
+    // x*a followed by +b or -b: one multiply-add
+    if (!code.empty() && code.back().op == Op::MulC && (instruction.op == Op::AddC || instruction.op == Op::SubC)) {
+        code.back().op = Op::Affine;
+        code.back().b = instruction.op == Op::AddC ? instruction.a : -instruction.a;
+        return true;
+    }
+    code.push_back(instruction);
+    return true;
+}
+
+void ChannelProgram::evaluate(const float* const* inputs, size_t rows, float* out) const {
+    // The bottom slot is the output itself; an input is read where it is, not copied
+    float scratch[MAX_STACK][BLOCK];
+    const float* slot[MAX_STACK];
+    for (size_t first = 0; first < rows; first += BLOCK) {
+        const size_t n = std::min(BLOCK, rows - first);
+        float* buffer[MAX_STACK];
+        buffer[0] = out + first;
+        for (int s = 1; s < MAX_STACK; ++s) buffer[s] = scratch[s];
+        int top = -1;
+        for (const Instruction& in : code) {
+            const float a = in.a, b = in.b;
+            switch (in.op) {
+            case Op::Input:
+                slot[++top] = inputs[in.index] + first;
+                continue;
+            case Op::Const:
+                std::fill(buffer[top + 1], buffer[top + 1] + n, a);
+                slot[top + 1] = buffer[top + 1];
+                ++top;
+                continue;
+            default:
+                break;
+            }
+            if (in.op <= Op::Atan2) {
+                // Two operands: the result replaces the lower one
+                float* d = buffer[top - 1];
+                const float* x = slot[top - 1];
+                const float* y = slot[top];
+                switch (in.op) {
+                case Op::Add: binary(d, x, y, n, [](float p, float q) { return p + q; }); break;
+                case Op::Sub: binary(d, x, y, n, [](float p, float q) { return p - q; }); break;
+                case Op::Mul: binary(d, x, y, n, [](float p, float q) { return p * q; }); break;
+                case Op::Div: binary(d, x, y, n, [](float p, float q) { return p / q; }); break;
+                case Op::Pow: binary(d, x, y, n, [](float p, float q) { return std::pow(p, q); }); break;
+                case Op::Min: binary(d, x, y, n, [](float p, float q) { return q < p ? q : p; }); break;
+                case Op::Max: binary(d, x, y, n, [](float p, float q) { return p < q ? q : p; }); break;
+                case Op::Atan2: binary(d, x, y, n, [](float p, float q) { return std::atan2(p, q); }); break;
+                default: break;
+                }
+                slot[--top] = d;
+                continue;
+            }
+            float* d = buffer[top];
+            const float* x = slot[top];
+            switch (in.op) {
+            case Op::AddC: unary(d, x, n, [a](float p) { return p + a; }); break;
+            case Op::SubC: unary(d, x, n, [a](float p) { return p - a; }); break;
+            case Op::RSubC: unary(d, x, n, [a](float p) { return a - p; }); break;
+            case Op::MulC: unary(d, x, n, [a](float p) { return p * a; }); break;
+            case Op::DivC: unary(d, x, n, [a](float p) { return p / a; }); break;
+            case Op::RDivC: unary(d, x, n, [a](float p) { return a / p; }); break;
+            case Op::PowC:
+                if (a == 2) unary(d, x, n, [](float p) { return p * p; });
+                else if (a == 0.5f) unary(d, x, n, [](float p) { return std::sqrt(p); });
+                else unary(d, x, n, [a](float p) { return std::pow(p, a); });
+                break;
+            case Op::MinC: unary(d, x, n, [a](float p) { return a < p ? a : p; }); break;
+            case Op::MaxC: unary(d, x, n, [a](float p) { return p < a ? a : p; }); break;
+            case Op::Affine: unary(d, x, n, [a, b](float p) { return p * a + b; }); break;
+            case Op::Neg: unary(d, x, n, [](float p) { return -p; }); break;
+            case Op::Abs: unary(d, x, n, [](float p) { return std::fabs(p); }); break;
+            case Op::Sqrt: unary(d, x, n, [](float p) { return std::sqrt(p); }); break;
+            case Op::Exp: unary(d, x, n, [](float p) { return std::exp(p); }); break;
+            case Op::Log: unary(d, x, n, [](float p) { return std::log(p); }); break;
+            case Op::Log10: unary(d, x, n, [](float p) { return std::log10(p); }); break;
+            case Op::Sin: unary(d, x, n, [](float p) { return std::sin(p); }); break;
+            case Op::Cos: unary(d, x, n, [](float p) { return std::cos(p); }); break;
+            case Op::Tan: unary(d, x, n, [](float p) { return std::tan(p); }); break;
+            case Op::Floor: unary(d, x, n, [](float p) { return std::floor(p); }); break;
+            case Op::Ceil: unary(d, x, n, [](float p) { return std::ceil(p); }); break;
+            case Op::Poly: {
+                const float* c = table.data() + in.index;
+                const uint32_t count = in.count;
+                unary(d, x, n, [c, count](float p) {
+                    float v = c[count - 1];
+                    for (uint32_t k = count - 1; k > 0; --k) v = v * p + c[k - 1];
+                    return v;
+                });
+                break;
+            }
+            case Op::Lut: {
+                const float* points = table.data() + in.index;
+                const uint32_t count = in.count;
+                unary(d, x, n, [points, count](float p) { return interpolate(p, points, count); });
+                break;
+            }
+            default: break;
+            }
+            slot[top] = d;
+        }
+        // A bare input, or a result left in another slot, still has to reach out
+        if (top == 0 && slot[0] != buffer[0]) memcpy(buffer[0], slot[0], n * sizeof(float));
+    }
+}
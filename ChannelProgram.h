@@ -0,0 +1,61 @@
+#ifndef CHANNELPROGRAM_H
+#define CHANNELPROGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A derived channel's expression compiled to code for a stack machine whose slots are blocks
+// of rows: each instruction runs over a block of up to BLOCK rows before the next one starts,
+// so a datagram's worth of structs is computed in a few tight loops per instruction, which
+// the compiler vectorizes, instead of walking the expression once per value. Built by
+// parseDerivedChannels(); run by ExtractionPlan::decode() on the decoded columns.
+class ChannelProgram {
+public:
+    enum class Op : uint8_t {
+        Input,                 // Push input `index`
+        Const,                 // Push a
+        Add, Sub, Mul, Div, Pow, Min, Max, Atan2, // Pop two, push the result
+        AddC, SubC, RSubC, MulC, DivC, RDivC, PowC, MinC, MaxC, // The top with the constant a: x+a, x-a, a-x, x*a...
+        Affine,                // x*a + b
+        Neg, Abs, Sqrt, Exp, Log, Log10, Sin, Cos, Tan, Floor, Ceil,
+        Poly,                  // Horner over count coefficients from table[index], constant term first
+        Lut,                   // Linear interpolation over count (x, y) points from table[index], clamped at the ends
+    };
+    struct Instruction {
+        Op op;
+        uint32_t index = 0;
+        uint32_t count = 0;
+        float a = 0;
+        float b = 0;
+    };
+
+    static constexpr size_t BLOCK = 256;
+    static constexpr int MAX_STACK = 16;
+    static constexpr int MAX_INPUTS = 32;
+
+    // What the inputs are: (field, array element) of the plan's columns, a field past the
+    // struct's fields being a derived channel
+    const std::vector<std::pair<int, int>>& inputs() const { return inputList; }
+    int addInput(int field, int element);
+
+    // Appends an instruction in postfix order; false if the stack would overflow or underflow
+    bool emit(const Instruction& instruction);
+    // Constants for Poly and Lut, returning the index of the first
+    uint32_t addTable(const std::vector<float>& values);
+    // Code ends with exactly one value on the stack
+    bool complete() const { return depth == 1 && !code.empty(); }
+    size_t size() const { return code.size(); }
+
+    // out[r] for r < rows, from inputs[i][r] for each input
+    void evaluate(const float* const* inputs, size_t rows, float* out) const;
+
+private:
+    std::vector<Instruction> code;
+    std::vector<float> table;
+    std::vector<std::pair<int, int>> inputList;
+    int depth = 0;
+};
+
+#endif // CHANNELPROGRAM_H
@@ -0,0 +1,237 @@
+#include "CompiledLayout.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+bool scalarTypeOf(const QString& type, ScalarType& out) {
+    if (type == "int8_t") out = ScalarType::Int8;
+    else if (type == "uint8_t" || type == "char") out = ScalarType::UInt8;
+    else if (type == "int16_t") out = ScalarType::Int16;
+    else if (type == "uint16_t") out = ScalarType::UInt16;
+    else if (type == "int32_t") out = ScalarType::Int32;
+    else if (type == "uint32_t") out = ScalarType::UInt32;
+    else if (type == "int64_t") out = ScalarType::Int64;
+    else if (type == "uint64_t") out = ScalarType::UInt64;
+    else if (type == "float") out = ScalarType::Float32;
+    else if (type == "double") out = ScalarType::Float64;
+    else return false;
+    return true;
+}
+
+template <typename T>
+T load(const char* p, bool swap) {
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, p, sizeof(T));
+    if (swap) std::reverse(bytes, bytes + sizeof(T));
+    T v;
+    memcpy(&v, bytes, sizeof(T));
+    return v;
+}
+
+CompiledLayout::Value read(const char* p, ScalarType type, bool swap) {
+    CompiledLayout::Value v;
+    v.type = type;
+    v.valid = true;
+    switch (type) {
+    case ScalarType::Int8: v.i = load<int8_t>(p, false); break;
+    case ScalarType::UInt8: v.u = load<uint8_t>(p, false); break;
+    case ScalarType::Int16: v.i = load<int16_t>(p, swap); break;
+    case ScalarType::UInt16: v.u = load<uint16_t>(p, swap); break;
+    case ScalarType::Int32: v.i = load<int32_t>(p, swap); break;
+    case ScalarType::UInt32: v.u = load<uint32_t>(p, swap); break;
+    case ScalarType::Int64: v.i = load<int64_t>(p, swap); break;
+    case ScalarType::UInt64: v.u = load<uint64_t>(p, swap); break;
+    case ScalarType::Float32: v.f = load<float>(p, swap); break;
+    case ScalarType::Float64: v.d = load<double>(p, swap); break;
+    }
+    return v;
+}
+
+// A bitfield: its unit read like a field of the type, then shifted and masked
+CompiledLayout::Value readBitfield(const char* p, const CompiledLayout::Field& field, bool swap) {
+    CompiledLayout::Value v = read(p, field.type, swap);
+    bool isSigned = field.bits.sign != 0;
+    uint64_t bits = extractBits(isSigned ? static_cast<uint64_t>(v.i) : v.u, field.bits);
+    if (isSigned) v.i = static_cast<int64_t>(bits);
+    else v.u = bits;
+    return v;
+}
+
+CompiledLayout::Value readField(const char* p, const CompiledLayout::Field& field, bool swap) {
+    return field.bitWidth ? readBitfield(p, field, swap) : read(p, field.type, swap);
+}
+
+constexpr size_t MAX_VALUE_CHARS = CompiledLayout::MAX_VALUE_CHARS;
+
+template <typename T>
+char* formatFloat(char* out, T v) {
+#if defined(__cpp_lib_to_chars)
+    // Shortest text that reads back to the same value, as QString::number gave
+    return std::to_chars(out, out + MAX_VALUE_CHARS, v).ptr;
+#else
+    int n = snprintf(out, MAX_VALUE_CHARS + 1, sizeof(T) == 4 ? "%.9g" : "%.17g", double(v));
+    return out + std::min<size_t>(n > 0 ? size_t(n) : 0, MAX_VALUE_CHARS);
+#endif
+}
+
+char* format(char* out, const CompiledLayout::Value& v) {
+    if (!v.valid) return out;
+    switch (v.type) {
+    case ScalarType::Int8: case ScalarType::Int16: case ScalarType::Int32: case ScalarType::Int64:
+        return std::to_chars(out, out + MAX_VALUE_CHARS, v.i).ptr;
+    case ScalarType::UInt8: case ScalarType::UInt16: case ScalarType::UInt32: case ScalarType::UInt64:
+        return std::to_chars(out, out + MAX_VALUE_CHARS, v.u).ptr;
+    case ScalarType::Float32: return formatFloat(out, v.f);
+    case ScalarType::Float64: return formatFloat(out, v.d);
+    }
+    return out;
+}
+
+} // namespace
+
+CompiledLayout::CompiledLayout(const QList<FieldDef>& fields) {
+    uint32_t end = 0; // Past the furthest field so far
+    uint32_t maxAlign = 1;
+    for (const FieldDef& def : fields) {
+        Field field;
+        field.known = scalarTypeOf(def.type, field.type);
+        if (!field.known) field.type = ScalarType::UInt8;
+        field.stride = field.known ? static_cast<uint32_t>(scalarSize(field.type)) : 0;
+        field.count = static_cast<uint32_t>(std::max(0, def.count));
+        field.bitShift = 0;
+        field.bitWidth = 0;
+        if (def.bitWidth > 0 && field.known && field.type != ScalarType::Float32 && field.type != ScalarType::Float64
+            && def.bitOffset >= 0 && def.bitOffset + def.bitWidth <= static_cast<int>(field.stride) * 8) {
+            field.bitShift = static_cast<uint8_t>(def.bitOffset);
+            field.bitWidth = static_cast<uint8_t>(def.bitWidth);
+            field.bits = bitfieldMask(field.type, field.bitShift, field.bitWidth);
+            field.count = 1;
+        }
+        // Where the parser put it, or at its natural alignment after the previous field
+        uint32_t align = def.align > 0 ? static_cast<uint32_t>(def.align) : std::max<uint32_t>(field.stride, 1);
+        if (def.offset >= 0) field.offset = static_cast<uint32_t>(def.offset);
+        else field.offset = end + (align - end % align) % align;
+        maxAlign = std::max(maxAlign, align);
+        end = std::max(end, field.offset + field.stride * field.count + static_cast<uint32_t>(std::max(0, def.tail)));
+        values += static_cast<int>(field.count);
+        fieldList.push_back(field);
+    }
+    // Trailing padding, so consecutive structs keep their fields aligned
+    end += (maxAlign - end % maxAlign) % maxAlign;
+    structSize = static_cast<int>(end);
+}
+
+bool CompiledLayout::isSequenceCandidate(int f) const {
+    if (f < 0 || f >= fieldCount()) return false;
+    const Field& field = fieldList[f];
+    return field.known && field.count == 1 && field.bitWidth == 0 && field.type != ScalarType::Float32
+           && field.type != ScalarType::Float64;
+}
+
+uint64_t CompiledLayout::hash() const {
+    // FNV-1a over the fields' layout, byte by byte
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](uint64_t v, int bytes) {
+        for (int b = 0; b < bytes; ++b, v >>= 8) h = (h ^ (v & 0xff)) * 0x100000001b3ull;
+    };
+    mix(static_cast<uint32_t>(structSize), 4);
+    mix(fieldList.size(), 4);
+    for (const Field& field : fieldList) {
+        mix(static_cast<uint8_t>(field.type), 1);
+        mix(field.known, 1);
+        mix(field.offset, 4);
+        mix(field.stride, 4);
+        mix(field.count, 4);
+        mix(field.bitShift, 1);
+        mix(field.bitWidth, 1);
+    }
+    return h;
+}
+
+bool CompiledLayout::setPlugin(const DecoderPlugin* plugin) {
+    if (plugin && (plugin->abi != DECODER_PLUGIN_ABI || plugin->layoutHash != hash()
+                   || plugin->structSize != static_cast<uint32_t>(structSize)
+                   || plugin->fieldCount != fieldList.size())) {
+        plugin = nullptr;
+    }
+    decoderPlugin = plugin;
+    return plugin != nullptr;
+}
+
+int CompiledLayout::extract(const char* data, size_t available, bool swapBytes, Value* out) const {
+    Value* v = out;
+    for (const Field& field : fieldList) {
+        for (uint32_t e = 0; e < field.count; ++e, ++v) {
+            size_t at = field.offset + size_t(e) * field.stride;
+            if (!field.known || at + field.stride > available) {
+                v->type = field.type;
+                v->valid = false;
+                continue;
+            }
+            *v = readField(data + at, field, swapBytes);
+        }
+    }
+    return static_cast<int>(v - out);
+}
+
+size_t CompiledLayout::maxCsvRowBytes() const {
+    return size_t(values) * (MAX_VALUE_CHARS + 1);
+}
+
+size_t CompiledLayout::formatValue(char* out, float v) {
+    return static_cast<size_t>(formatFloat(out, v) - out);
+}
+
+size_t CompiledLayout::formatCsvRow(const char* data, size_t available, bool swapBytes, char* out) const {
+    if (decoderPlugin) return decoderPlugin->formatCsvRow(data, available, swapBytes, out);
+    char* p = out;
+    bool first = true;
+    for (const Field& field : fieldList) {
+        for (uint32_t e = 0; e < field.count; ++e) {
+            if (!first) *p++ = ',';
+            first = false;
+            size_t at = field.offset + size_t(e) * field.stride;
+            if (field.known && at + field.stride <= available) p = format(p, readField(data + at, field, swapBytes));
+        }
+    }
+    return static_cast<size_t>(p - out);
+}
+
+ExtractionPlan CompiledLayout::plan(const QVector<QPair<int, int>>& selection, bool swapBytes) const {
+    std::vector<ExtractionPlan::Column> columns;
+    auto add = [&](int f, int element) {
+        if (f < 0 || f >= fieldCount() || !fieldList[f].known) return;
+        const Field& field = fieldList[f];
+        if (element < -1 || element >= static_cast<int>(field.count)) return;
+        if (element == -1 && field.bitWidth) element = 0; // A bitfield is its own only element
+        if (element == -1 && field.bitWidth == 0) {
+            columns.push_back({field.offset, field.type, f, -1, field.count});
+            return;
+        }
+        columns.push_back({field.offset + static_cast<uint32_t>(element) * field.stride, field.type, f, element, 1,
+                           field.bitShift, field.bitWidth});
+    };
+    if (selection.isEmpty()) {
+        for (int f = 0; f < fieldCount(); ++f) {
+            for (uint32_t e = 0; e < fieldList[f].count; ++e) add(f, static_cast<int>(e));
+        }
+    } else {
+        for (const auto& pick : selection) add(pick.first, pick.second);
+    }
+    ExtractionPlan plan(std::move(columns), static_cast<size_t>(structSize), swapBytes);
+    if (decoderPlugin) {
+        // Its fixed shifts and masks, and frames unrolled over their constant count, beat the
+        // generic kernels; a single value is gathered as fast by the vector kernels
+        const bool vectorKernels = detectDecodeIsa() != DecodeIsa::Scalar;
+        for (size_t c = 0; c < plan.columnCount(); ++c) {
+            const ExtractionPlan::Column& column = plan.column(c);
+            if (vectorKernels && column.bitWidth == 0 && column.count == 1) continue;
+            size_t k = 2 * static_cast<size_t>(column.field) + (swapBytes ? 1 : 0);
+            plan.setPluginKernel(c, column.element < 0 ? decoderPlugin->frameKernels[k] : decoderPlugin->elementKernels[k]);
+        }
+    }
+    return plan;
+}
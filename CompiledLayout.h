@@ -0,0 +1,91 @@
+#ifndef COMPILEDLAYOUT_H
+#define COMPILEDLAYOUT_H
+
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FieldDef.h"
+#include "DecodeKernels.h"
+#include "ExtractionPlan.h"
+#include "DecoderPluginApi.h"
+
+// The byte layout of a parsed struct, worked out once from parseCStruct() output: each
+// field's type as a tag, its offset and element stride, bitfields' shift and mask, and the
+// struct's size. parseCStruct() places the fields as a C compiler would (#pragma pack,
+// bitfields and nested structs included); fields it didn't place are aligned to their own
+// size. size() is the struct's sizeof and the stride between structs in a datagram. The
+// packet length, the receive path's plan, the sequence field and the logger's CSV rows all
+// come from the same layout.
+class CompiledLayout {
+public:
+    struct Field {
+        ScalarType type;
+        bool known;      // A type the parser doesn't know takes no bytes and yields empty values
+        uint32_t offset; // Of the first element, within the struct
+        uint32_t stride; // Bytes between elements: the type's size, 0 when unknown
+        uint32_t count;  // Elements, 1 for a scalar
+        uint8_t bitShift; // A bitfield: bitWidth bits from bitShift of the stride-byte unit at offset
+        uint8_t bitWidth; // 0 for a whole value
+        BitfieldMask bits;
+    };
+    // One element's value, read with its own type
+    struct Value {
+        ScalarType type;
+        bool valid; // False for an unknown type, or past the end of the data
+        union {
+            int64_t i; // Signed integers
+            uint64_t u; // Unsigned integers
+            float f;
+            double d;
+        };
+    };
+
+    CompiledLayout() = default;
+    explicit CompiledLayout(const QList<FieldDef>& fields);
+
+    int size() const { return structSize; }
+    int fieldCount() const { return static_cast<int>(fieldList.size()); }
+    const Field& field(int f) const { return fieldList[f]; }
+    // Elements of every field, in order: the values extract() writes and the cells of a CSV row
+    int valueCount() const { return values; }
+    // A scalar integer field (not a bitfield), which can number packets
+    bool isSequenceCandidate(int f) const;
+    // Of what decoding depends on (size, and each field's type, place and bits, not its
+    // name): the key a decoder plugin generated for this layout is found by
+    uint64_t hash() const;
+
+    // Decode through a plugin generated for this layout: plan() takes its kernels for
+    // bitfields and sample frames (for every column without vector kernels), formatCsvRow()
+    // its formatter. One of another layout or ABI is refused; null drops it.
+    bool setPlugin(const DecoderPlugin* plugin);
+    const DecoderPlugin* plugin() const { return decoderPlugin; }
+
+    // Read the value of each element of each field of the struct at data, of which available
+    // bytes are there, into out (valueCount() entries); returns the number written
+    int extract(const char* data, size_t available, bool swapBytes, Value* out) const;
+
+    // The same values as text, comma separated with no line end, into out, which holds
+    // at least maxCsvRowBytes(); returns the length. Unknown and missing values are empty.
+    size_t maxCsvRowBytes() const;
+    size_t formatCsvRow(const char* data, size_t available, bool swapBytes, char* out) const;
+    // Longest text of one value: "-2.2250738585072014e-308", and 20 digits for 64-bit integers
+    static constexpr size_t MAX_VALUE_CHARS = 24;
+    // A float as formatCsvRow() writes it, into out; returns the length
+    static size_t formatValue(char* out, float v);
+
+    // A plan over structs of size() bytes for the (field, array element) pairs in selection.
+    // An empty selection takes every element of every field; an element of -1 takes a whole
+    // array field as one sample frame column. Unknown types and out-of-range pairs are left out.
+    ExtractionPlan plan(const QVector<QPair<int, int>>& selection, bool swapBytes) const;
+
+private:
+    std::vector<Field> fieldList;
+    int structSize = 0;
+    int values = 0;
+    const DecoderPlugin* decoderPlugin = nullptr;
+};
+
+#endif // COMPILEDLAYOUT_H
@@ -0,0 +1,403 @@
+#include "DecodeKernels.h"
+#include <climits>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DECODE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Kernels for instruction sets above the compiler's baseline are built per function, so the
+// rest of the program keeps running on older CPUs; MSVC needs no flag for the intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define DECODE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DECODE_TARGET(isa)
+#endif
+
+namespace {
+
+template <size_t Size> struct UIntOf;
+template <> struct UIntOf<1> { using type = uint8_t; };
+template <> struct UIntOf<2> { using type = uint16_t; };
+template <> struct UIntOf<4> { using type = uint32_t; };
+template <> struct UIntOf<8> { using type = uint64_t; };
+
+// Written out so that compilers turn them into bswap (and vectorize them) on any toolchain
+inline uint8_t byteSwap(uint8_t v) { return v; }
+inline uint16_t byteSwap(uint16_t v) { return static_cast<uint16_t>((v >> 8) | (v << 8)); }
+inline uint32_t byteSwap(uint32_t v) {
+    return ((v & 0xffu) << 24) | ((v & 0xff00u) << 8) | ((v >> 8) & 0xff00u) | (v >> 24);
+}
+inline uint64_t byteSwap(uint64_t v) {
+    return (static_cast<uint64_t>(byteSwap(static_cast<uint32_t>(v))) << 32) | byteSwap(static_cast<uint32_t>(v >> 32));
+}
+
+// Unaligned load of a T, byte-swapped when Swap
+template <typename T, bool Swap>
+inline T load(const char* p) {
+    using U = typename UIntOf<sizeof(T)>::type;
+    U bits;
+    memcpy(&bits, p, sizeof(bits));
+    if (Swap) bits = byteSwap(bits);
+    T value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// The scalar kernels: one instantiation per (type, byte order), the strided loop free of branches
+template <typename T, bool Swap>
+void decodeStrided(const char* data, size_t stride, size_t count, float* out) {
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * stride));
+}
+
+// Structs that are a single scalar: a dense array, which the compiler vectorizes
+template <typename T, bool Swap>
+void decodeDense(const char* data, size_t, size_t count, float* out) {
+    for (size_t i = 0; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * sizeof(T)));
+}
+
+// Bitfields: the unit loaded like a field of its type, then shifted and masked
+template <typename T, bool Swap>
+void decodeBitfield(const char* data, size_t stride, size_t count, const BitfieldMask& bits, float* out) {
+    using U = typename UIntOf<sizeof(T)>::type;
+    const BitfieldMask b = bits;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t v = extractBits(load<U, Swap>(data + i * stride), b);
+        out[i] = std::is_signed<T>::value ? static_cast<float>(static_cast<int64_t>(v)) : static_cast<float>(v);
+    }
+}
+
+template <typename T>
+BitfieldKernel bitfieldKernelOf(bool swap) {
+    return swap && sizeof(T) > 1 ? &decodeBitfield<T, true> : &decodeBitfield<T, false>;
+}
+
+#ifdef DECODE_X86
+// Fields narrower than 4 bytes are read as 32-bit lanes, so the vector loops stop one struct
+// early for them (and need stride + size >= 4) to stay inside the buffer. Lane offsets are
+// 32-bit, which bounds the stride.
+constexpr size_t MAX_GATHER_STRIDE = INT_MAX / 8;
+
+inline uint32_t load32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+inline uint64_t load64(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// SSE4.1: loads gathered into a register four at a time
+
+// 32-bit lanes holding T (or T widened to 32 bits) to float
+template <typename T>
+DECODE_TARGET("sse4.1") inline __m128 wideToFloat(__m128i v) {
+    if constexpr (std::is_same<T, float>::value) return _mm_castsi128_ps(v);
+    if constexpr (std::is_same<T, uint32_t>::value) {
+        // No unsigned convert: both 16-bit halves convert exactly, and the sum rounds once
+        __m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 16)), _mm_set1_ps(65536.0f));
+        return _mm_add_ps(high, _mm_cvtepi32_ps(_mm_and_si128(v, _mm_set1_epi32(0xffff))));
+    }
+    return _mm_cvtepi32_ps(v);
+}
+
+// A field of up to 4 bytes at the bottom of each 32-bit lane to float
+template <typename T, bool Swap>
+DECODE_TARGET("sse4.1") inline __m128 lanesToFloat(__m128i v) {
+    if constexpr (sizeof(T) == 1) {
+        v = std::is_signed<T>::value ? _mm_srai_epi32(_mm_slli_epi32(v, 24), 24) : _mm_and_si128(v, _mm_set1_epi32(0xff));
+    } else if constexpr (sizeof(T) == 2) {
+        if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1));
+        if constexpr (std::is_signed<T>::value) v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+        else if constexpr (!Swap) v = _mm_and_si128(v, _mm_set1_epi32(0xffff));
+    } else {
+        if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    }
+    return wideToFloat<T>(v);
+}
+
+template <typename T, bool Swap>
+DECODE_TARGET("sse4.1") void gatherSse41(const char* data, size_t stride, size_t count, float* out) {
+    size_t i = 0;
+    if constexpr (sizeof(T) <= 4) {
+        const size_t spare = sizeof(T) < 4 ? 1 : 0;
+        for (; i + 4 + spare <= count; i += 4) {
+            const char* p = data + i * stride;
+            __m128i v = _mm_setr_epi32(static_cast<int>(load32(p)), static_cast<int>(load32(p + stride)),
+                                       static_cast<int>(load32(p + 2 * stride)), static_cast<int>(load32(p + 3 * stride)));
+            _mm_storeu_ps(out + i, lanesToFloat<T, Swap>(v));
+        }
+    } else {
+        for (; i + 2 <= count; i += 2) {
+            const char* p = data + i * stride;
+            __m128i v = _mm_set_epi64x(static_cast<long long>(load64(p + stride)), static_cast<long long>(load64(p)));
+            if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+            if constexpr (std::is_same<T, double>::value) {
+                _mm_storel_pi(reinterpret_cast<__m64*>(out + i), _mm_cvtpd_ps(_mm_castsi128_pd(v)));
+            } else {
+                // No 64-bit integer convert below AVX-512: the lanes are converted one by one
+                T lanes[2];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), v);
+                out[i] = static_cast<float>(lanes[0]);
+                out[i + 1] = static_cast<float>(lanes[1]);
+            }
+        }
+    }
+    for (; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * stride));
+}
+
+// AVX2: the same with vpgather, eight 32-bit or four 64-bit lanes at a time
+
+template <typename T>
+DECODE_TARGET("avx2") inline __m256 wideToFloat8(__m256i v) {
+    if constexpr (std::is_same<T, float>::value) return _mm256_castsi256_ps(v);
+    if constexpr (std::is_same<T, uint32_t>::value) {
+        __m256 high = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 16)), _mm256_set1_ps(65536.0f));
+        return _mm256_add_ps(high, _mm256_cvtepi32_ps(_mm256_and_si256(v, _mm256_set1_epi32(0xffff))));
+    }
+    return _mm256_cvtepi32_ps(v);
+}
+
+template <typename T, bool Swap>
+DECODE_TARGET("avx2") inline __m256 lanesToFloat8(__m256i v) {
+    if constexpr (sizeof(T) == 1) {
+        v = std::is_signed<T>::value ? _mm256_srai_epi32(_mm256_slli_epi32(v, 24), 24)
+                                     : _mm256_and_si256(v, _mm256_set1_epi32(0xff));
+    } else if constexpr (sizeof(T) == 2) {
+        if (Swap) {
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1,
+                                                        1, 0, -1, -1, 5, 4, -1, -1, 9, 8, -1, -1, 13, 12, -1, -1));
+        }
+        if constexpr (std::is_signed<T>::value) v = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+        else if constexpr (!Swap) v = _mm256_and_si256(v, _mm256_set1_epi32(0xffff));
+    } else {
+        if (Swap) {
+            v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+        }
+    }
+    return wideToFloat8<T>(v);
+}
+
+template <typename T, bool Swap>
+DECODE_TARGET("avx2") void gatherAvx2(const char* data, size_t stride, size_t count, float* out) {
+    size_t i = 0;
+    const int s = static_cast<int>(stride);
+    if constexpr (sizeof(T) <= 4) {
+        const size_t spare = sizeof(T) < 4 ? 1 : 0;
+        const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+        for (; i + 8 + spare <= count; i += 8) {
+            // Into a zeroed register: vpgather merges into its destination, which would
+            // otherwise tie every iteration to the previous one
+            __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(data + i * stride),
+                                                    offsets, _mm256_set1_epi32(-1), 1);
+            _mm256_storeu_ps(out + i, lanesToFloat8<T, Swap>(v));
+        }
+    } else {
+        const __m128i offsets = _mm_setr_epi32(0, s, 2 * s, 3 * s);
+        for (; i + 4 <= count; i += 4) {
+            __m256i v = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), reinterpret_cast<const long long*>(data + i * stride),
+                                                    offsets, _mm256_set1_epi64x(-1), 1);
+            if (Swap) {
+                v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+            }
+            if constexpr (std::is_same<T, double>::value) {
+                _mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_castsi256_pd(v)));
+            } else {
+                T lanes[4];
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), v);
+                for (int k = 0; k < 4; ++k) out[i + k] = static_cast<float>(lanes[k]);
+            }
+        }
+    }
+    for (; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * stride));
+}
+
+// Dense arrays (sample frames, single-scalar structs): plain vector loads, byte-swapped and
+// then widened to 32 bits with pmovsx/pmovzx. 64-bit integers are left to the tail loop.
+
+template <typename T, bool Swap>
+DECODE_TARGET("sse4.1") void denseSse41(const char* data, size_t, size_t count, float* out) {
+    size_t i = 0;
+    if constexpr (std::is_same<T, double>::value) {
+        for (; i + 2 <= count; i += 2) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * sizeof(T)));
+            if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+            _mm_storel_pi(reinterpret_cast<__m64*>(out + i), _mm_cvtpd_ps(_mm_castsi128_pd(v)));
+        }
+    } else if constexpr (sizeof(T) <= 4) {
+        for (; i + 4 <= count; i += 4) {
+            const char* p = data + i * sizeof(T);
+            __m128i v;
+            if constexpr (sizeof(T) == 1) {
+                v = _mm_cvtsi32_si128(static_cast<int>(load32(p)));
+                v = std::is_signed<T>::value ? _mm_cvtepi8_epi32(v) : _mm_cvtepu8_epi32(v);
+            } else if constexpr (sizeof(T) == 2) {
+                v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+                if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+                v = std::is_signed<T>::value ? _mm_cvtepi16_epi32(v) : _mm_cvtepu16_epi32(v);
+            } else {
+                v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (Swap) v = _mm_shuffle_epi8(v, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+            }
+            _mm_storeu_ps(out + i, wideToFloat<T>(v));
+        }
+    }
+    for (; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * sizeof(T)));
+}
+
+template <typename T, bool Swap>
+DECODE_TARGET("avx2") void denseAvx2(const char* data, size_t, size_t count, float* out) {
+    size_t i = 0;
+    if constexpr (std::is_same<T, double>::value) {
+        for (; i + 4 <= count; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * sizeof(T)));
+            if (Swap) {
+                v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                            7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+            }
+            _mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_castsi256_pd(v)));
+        }
+    } else if constexpr (sizeof(T) <= 4) {
+        for (; i + 8 <= count; i += 8) {
+            const char* p = data + i * sizeof(T);
+            __m256i v;
+            if constexpr (sizeof(T) == 1) {
+                __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+                v = std::is_signed<T>::value ? _mm256_cvtepi8_epi32(bytes) : _mm256_cvtepu8_epi32(bytes);
+            } else if constexpr (sizeof(T) == 2) {
+                __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                if (Swap) halves = _mm_shuffle_epi8(halves, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+                v = std::is_signed<T>::value ? _mm256_cvtepi16_epi32(halves) : _mm256_cvtepu16_epi32(halves);
+            } else {
+                v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                if (Swap) {
+                    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+                }
+            }
+            _mm256_storeu_ps(out + i, wideToFloat8<T>(v));
+        }
+    }
+    for (; i < count; ++i) out[i] = static_cast<float>(load<T, Swap>(data + i * sizeof(T)));
+}
+
+bool cpuHasSse41() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("sse4.1");
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    // AVX2 on the CPU, and the OS saving the YMM registers (OSXSAVE, then XCR0 bits 1 and 2)
+    int info[4];
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif // DECODE_X86
+
+template <typename T>
+DecodeKernel kernelOf(DecodeIsa isa, bool swap, bool dense) {
+#ifdef DECODE_X86
+    if (dense && isa == DecodeIsa::Avx2) return swap ? &denseAvx2<T, true> : &denseAvx2<T, false>;
+    if (dense && isa == DecodeIsa::Sse41) return swap ? &denseSse41<T, true> : &denseSse41<T, false>;
+#endif
+    if (dense) return swap ? &decodeDense<T, true> : &decodeDense<T, false>;
+#ifdef DECODE_X86
+    if (isa == DecodeIsa::Avx2) return swap ? &gatherAvx2<T, true> : &gatherAvx2<T, false>;
+    if (isa == DecodeIsa::Sse41) return swap ? &gatherSse41<T, true> : &gatherSse41<T, false>;
+#else
+    (void)isa;
+#endif
+    return swap ? &decodeStrided<T, true> : &decodeStrided<T, false>;
+}
+
+} // namespace
+
+DecodeIsa detectDecodeIsa() {
+#ifdef DECODE_X86
+    static const DecodeIsa isa = cpuHasAvx2() ? DecodeIsa::Avx2 : cpuHasSse41() ? DecodeIsa::Sse41 : DecodeIsa::Scalar;
+    return isa;
+#else
+    return DecodeIsa::Scalar;
+#endif
+}
+
+const char* decodeIsaName(DecodeIsa isa) {
+    switch (isa) {
+    case DecodeIsa::Sse41: return "SSE4.1";
+    case DecodeIsa::Avx2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+DecodeKernel decodeKernel(ScalarType type, bool swapBytes, size_t stride, DecodeIsa isa) {
+    size_t size = scalarSize(type);
+    bool dense = stride == size;
+#ifdef DECODE_X86
+    if (isa > detectDecodeIsa() || (!dense && (stride > MAX_GATHER_STRIDE || stride + size < 4))) isa = DecodeIsa::Scalar;
+    // Without a vector convert for them, 64-bit integers measured faster in the scalar loop
+    if (type == ScalarType::Int64 || type == ScalarType::UInt64) isa = DecodeIsa::Scalar;
+#endif
+    if (size == 1) swapBytes = false;
+    switch (type) {
+    case ScalarType::Int8: return kernelOf<int8_t>(isa, swapBytes, dense);
+    case ScalarType::UInt8: return kernelOf<uint8_t>(isa, swapBytes, dense);
+    case ScalarType::Int16: return kernelOf<int16_t>(isa, swapBytes, dense);
+    case ScalarType::UInt16: return kernelOf<uint16_t>(isa, swapBytes, dense);
+    case ScalarType::Int32: return kernelOf<int32_t>(isa, swapBytes, dense);
+    case ScalarType::UInt32: return kernelOf<uint32_t>(isa, swapBytes, dense);
+    case ScalarType::Int64: return kernelOf<int64_t>(isa, swapBytes, dense);
+    case ScalarType::UInt64: return kernelOf<uint64_t>(isa, swapBytes, dense);
+    case ScalarType::Float32: return kernelOf<float>(isa, swapBytes, dense);
+    case ScalarType::Float64: return kernelOf<double>(isa, swapBytes, dense);
+    }
+    return nullptr;
+}
+
+BitfieldMask bitfieldMask(ScalarType type, unsigned shift, unsigned width) {
+    BitfieldMask bits;
+    width = width < 64 ? width : 64;
+    bits.shift = static_cast<uint8_t>(shift < 64 ? shift : 63);
+    bits.mask = width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    bool isSigned = type == ScalarType::Int8 || type == ScalarType::Int16 || type == ScalarType::Int32
+                    || type == ScalarType::Int64;
+    bits.sign = isSigned && width > 0 ? uint64_t(1) << (width - 1) : 0;
+    return bits;
+}
+
+BitfieldKernel bitfieldKernel(ScalarType type, bool swapBytes) {
+    switch (type) {
+    case ScalarType::Int8: return bitfieldKernelOf<int8_t>(swapBytes);
+    case ScalarType::UInt8: return bitfieldKernelOf<uint8_t>(swapBytes);
+    case ScalarType::Int16: return bitfieldKernelOf<int16_t>(swapBytes);
+    case ScalarType::UInt16: return bitfieldKernelOf<uint16_t>(swapBytes);
+    case ScalarType::Int32: return bitfieldKernelOf<int32_t>(swapBytes);
+    case ScalarType::UInt32: return bitfieldKernelOf<uint32_t>(swapBytes);
+    case ScalarType::Int64: return bitfieldKernelOf<int64_t>(swapBytes);
+    case ScalarType::UInt64: return bitfieldKernelOf<uint64_t>(swapBytes);
+    default: return nullptr; // No floating-point bitfields
+    }
+}
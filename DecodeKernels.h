@@ -0,0 +1,63 @@
+#ifndef DECODEKERNELS_H
+#define DECODEKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Scalar types a struct field can have
+enum class ScalarType : uint8_t { Int8, UInt8, Int16, UInt16, Int32, UInt32, Int64, UInt64, Float32, Float64 };
+
+inline size_t scalarSize(ScalarType type) {
+    switch (type) {
+    case ScalarType::Int8: case ScalarType::UInt8: return 1;
+    case ScalarType::Int16: case ScalarType::UInt16: return 2;
+    case ScalarType::Int32: case ScalarType::UInt32: case ScalarType::Float32: return 4;
+    default: return 8;
+    }
+}
+
+// Converts count values of one field, stride bytes apart starting at data, to float
+using DecodeKernel = void (*)(const char* data, size_t stride, size_t count, float* out);
+
+// Instruction sets the decode kernels come in. Every one converts exactly like
+// static_cast<float> of the loaded value, so the choice only changes the speed.
+enum class DecodeIsa : uint8_t {
+    Scalar, // Templated loops, left to the compiler's baseline vectorizer
+    Sse41,  // 4 lanes: strided loads gathered into a register, dense ones widened with pmovsx/pmovzx; pshufb byte swap
+    Avx2,   // 8 lanes (4 for doubles): vpgather or a plain load, vpshufb, widening and convert
+};
+
+// The best set this CPU (and OS) supports, detected once
+DecodeIsa detectDecodeIsa();
+const char* decodeIsaName(DecodeIsa isa);
+
+// The kernel for a field of this type and byte order in structs of stride bytes, using isa
+// where it has one and the scalar kernel otherwise. A stride equal to the type's size is a
+// dense array: an array field read as a sample frame, or structs of a single scalar.
+// 64-bit integers always get the scalar kernel (there is no vector convert for them before
+// AVX-512). Kernels take any buffer, so the logger and the binary converter can call them.
+DecodeKernel decodeKernel(ScalarType type, bool swapBytes, size_t stride, DecodeIsa isa = detectDecodeIsa());
+
+// A bitfield's place in its storage unit (a value of the field's declared type): width bits
+// from bit shift, counted from the unit's least significant bit once it is in host order.
+// Worked out once per field, so extracting one is a shift, a mask and, for a signed type,
+// the xor-subtract that sign-extends it.
+struct BitfieldMask {
+    uint8_t shift = 0;
+    uint64_t mask = 0; // The field's width in low bits
+    uint64_t sign = 0; // Its top bit for a signed type, else 0
+};
+BitfieldMask bitfieldMask(ScalarType type, unsigned shift, unsigned width);
+
+// The field out of a unit, sign-extended to 64 bits for a signed type
+inline uint64_t extractBits(uint64_t unit, const BitfieldMask& bits) {
+    uint64_t v = (unit >> bits.shift) & bits.mask;
+    return (v ^ bits.sign) - bits.sign;
+}
+
+// Converts count bitfields, one per struct stride bytes apart, their units starting at data
+using BitfieldKernel = void (*)(const char* data, size_t stride, size_t count, const BitfieldMask& bits, float* out);
+// The kernel for bitfields of an integer type; scalar, a load, byte swap and extractBits per value
+BitfieldKernel bitfieldKernel(ScalarType type, bool swapBytes);
+
+#endif // DECODEKERNELS_H
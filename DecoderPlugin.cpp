@@ -0,0 +1,270 @@
+#include "DecoderPlugin.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QHash>
+#include <QLibrary>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+const char* typeName(ScalarType type) {
+    switch (type) {
+    case ScalarType::Int8: return "int8_t";
+    case ScalarType::UInt8: return "uint8_t";
+    case ScalarType::Int16: return "int16_t";
+    case ScalarType::UInt16: return "uint16_t";
+    case ScalarType::Int32: return "int32_t";
+    case ScalarType::UInt32: return "uint32_t";
+    case ScalarType::Int64: return "int64_t";
+    case ScalarType::UInt64: return "uint64_t";
+    case ScalarType::Float32: return "float";
+    case ScalarType::Float64: return "double";
+    }
+    return "uint8_t";
+}
+
+QString hexHash(const CompiledLayout& layout) {
+    return QString::number(static_cast<qulonglong>(layout.hash()), 16).rightJustified(16, '0');
+}
+
+// DecoderPluginApi.h, as each plugin declares it
+const char* const PLUGIN_API = R"(extern "C" {
+typedef void (*DecoderPluginKernel)(const char* data, size_t structs, uint32_t element, float* out);
+struct DecoderPlugin {
+    uint32_t abi;
+    uint64_t layoutHash;
+    uint32_t structSize;
+    uint32_t fieldCount;
+    const DecoderPluginKernel* elementKernels;
+    const DecoderPluginKernel* frameKernels;
+    size_t (*formatCsvRow)(const char* data, size_t available, bool swapBytes, char* out);
+};
+}
+)";
+
+// Loads, byte swaps, bitfields and CSV text, the same as DecodeKernels and CompiledLayout
+const char* const PLUGIN_HELPERS = R"(template <size_t Size> struct UIntOf;
+template <> struct UIntOf<1> { using type = uint8_t; };
+template <> struct UIntOf<2> { using type = uint16_t; };
+template <> struct UIntOf<4> { using type = uint32_t; };
+template <> struct UIntOf<8> { using type = uint64_t; };
+
+inline uint8_t byteSwap(uint8_t v) { return v; }
+inline uint16_t byteSwap(uint16_t v) { return static_cast<uint16_t>((v >> 8) | (v << 8)); }
+inline uint32_t byteSwap(uint32_t v) {
+    return ((v & 0xffu) << 24) | ((v & 0xff00u) << 8) | ((v >> 8) & 0xff00u) | (v >> 24);
+}
+inline uint64_t byteSwap(uint64_t v) {
+    return (static_cast<uint64_t>(byteSwap(static_cast<uint32_t>(v))) << 32) | byteSwap(static_cast<uint32_t>(v >> 32));
+}
+
+template <typename T, bool Swap>
+inline T load(const char* p) {
+    using U = typename UIntOf<sizeof(T)>::type;
+    U bits;
+    memcpy(&bits, p, sizeof(bits));
+    if (Swap) bits = byteSwap(bits);
+    T value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// A bitfield of type T: Width bits from bit Shift of its unit, sign-extended for a signed T
+template <typename T, bool Swap, unsigned Shift, unsigned Width>
+inline typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type bits(const char* p) {
+    constexpr uint64_t mask = Width >= 64 ? ~uint64_t(0) : (uint64_t(1) << (Width % 64)) - 1;
+    constexpr uint64_t sign = std::is_signed<T>::value ? uint64_t(1) << (Width - 1) : 0;
+    uint64_t v = (static_cast<uint64_t>(load<typename UIntOf<sizeof(T)>::type, Swap>(p)) >> Shift) & mask;
+    return static_cast<typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>((v ^ sign) - sign);
+}
+
+constexpr size_t MAX_VALUE_CHARS = 24;
+
+inline char* put(char* out, int64_t v) { return std::to_chars(out, out + MAX_VALUE_CHARS, v).ptr; }
+inline char* put(char* out, uint64_t v) { return std::to_chars(out, out + MAX_VALUE_CHARS, v).ptr; }
+
+template <typename T>
+inline char* putFloat(char* out, T v) {
+#if defined(__cpp_lib_to_chars)
+    return std::to_chars(out, out + MAX_VALUE_CHARS, v).ptr;
+#else
+    int n = snprintf(out, MAX_VALUE_CHARS + 1, sizeof(T) == 4 ? "%.9g" : "%.17g", double(v));
+    return out + (n <= 0 ? 0 : size_t(n) < MAX_VALUE_CHARS ? size_t(n) : MAX_VALUE_CHARS);
+#endif
+}
+inline char* put(char* out, float v) { return putFloat(out, v); }
+inline char* put(char* out, double v) { return putFloat(out, v); }
+
+// Integers widened to 64 bits, as the generic rows print them
+template <typename T, bool Swap>
+inline char* putValue(char* out, const char* p) {
+    T v = load<T, Swap>(p);
+    if constexpr (std::is_floating_point<T>::value) return put(out, v);
+    else if constexpr (std::is_signed<T>::value) return put(out, static_cast<int64_t>(v));
+    else return put(out, static_cast<uint64_t>(v));
+}
+)";
+
+} // namespace
+
+QString generateDecoderPlugin(const QList<FieldDef>& fields) {
+    CompiledLayout layout(fields);
+    const QString name = decoderPluginName(layout);
+    const QString size = QString::number(layout.size());
+    QString header;
+    QString kernels;
+    QString row;
+    QString elementTable;
+    QString frameTable;
+    bool firstValue = true;
+    // The separator before a value, none before the row's first
+    auto separate = [&row, &firstValue]() {
+        if (!firstValue) row += "    *p++ = ',';\n";
+        firstValue = false;
+    };
+
+    for (int f = 0; f < layout.fieldCount(); ++f) {
+        const CompiledLayout::Field& field = layout.field(f);
+        const QString n = QString::number(f);
+        const QString type = typeName(field.type);
+        const QString offset = QString::number(field.offset);
+        const QString stride = QString::number(field.stride);
+        const QString count = QString::number(field.count);
+        const QString fieldName = f < fields.size() ? fields[f].name : QString();
+        QString place = field.count > 1 ? QString("%1[%2] at %3").arg(type, count, offset) : QString("%1 at %2").arg(type, offset);
+        if (field.bitWidth > 1) place += QString(", bits %1-%2").arg(int(field.bitShift)).arg(field.bitShift + field.bitWidth - 1);
+        else if (field.bitWidth == 1) place += QString(", bit %1").arg(int(field.bitShift));
+        header += QString("//   %1: %2\n").arg(fieldName, field.known ? place : QString("unknown type, not decoded"));
+
+        if (!field.known || field.count == 0) {
+            // Empty cells, and no kernels
+            for (uint32_t e = 0; e < field.count; ++e) separate();
+            elementTable += "    nullptr, nullptr,\n";
+            frameTable += "    nullptr, nullptr,\n";
+            continue;
+        }
+
+        // The value at p, as the row prints it and as a float
+        QString read = field.bitWidth ? QString("bits<%1, Swap, %2, %3>(%4)").arg(type).arg(int(field.bitShift)).arg(int(field.bitWidth))
+                                      : QString("load<%1, Swap>(%2)").arg(type);
+        kernels += QString("// %1: %2\n").arg(fieldName, place);
+        kernels += QString("template <bool Swap>\nvoid element%1(const char* data, size_t structs, uint32_t%2, float* out) {\n")
+                       .arg(n, field.count > 1 ? QString(" element") : QString());
+        kernels += field.count > 1 ? QString("    const char* p = data + %1 + size_t(element) * %2;\n").arg(offset, stride)
+                                   : QString("    const char* p = data + %1;\n").arg(offset);
+        kernels += QString("    for (size_t s = 0; s < structs; ++s) out[s] = static_cast<float>(%1);\n}\n\n")
+                       .arg(read.arg("p + s * STRUCT_SIZE"));
+        if (field.count > 1) {
+            kernels += QString("template <bool Swap>\nvoid frame%1(const char* data, size_t structs, uint32_t, float* out) {\n"
+                               "    for (size_t s = 0; s < structs; ++s, data += STRUCT_SIZE, out += %2) {\n"
+                               "        for (size_t e = 0; e < %2; ++e) out[e] = static_cast<float>(%3);\n"
+                               "    }\n}\n\n")
+                           .arg(n, count, read.arg(QString("data + %1 + e * %2").arg(offset, stride)));
+        }
+        elementTable += QString("    element%1<false>, element%1<true>,\n").arg(n);
+        if (field.bitWidth) frameTable += "    nullptr, nullptr,\n";
+        else frameTable += QString("    %1%2<false>, %1%2<true>,\n").arg(QString(field.count > 1 ? "frame" : "element"), n);
+
+        QString put = field.bitWidth ? QString("put(p, %1)").arg(read.arg("data + " + offset))
+                                     : QString("putValue<%1, Swap>(p, data + %2)").arg(type, offset);
+        if (field.count == 1) {
+            separate();
+            row += QString("    if (available >= %1) p = %2;\n").arg(QString::number(field.offset + field.stride), put);
+        } else {
+            QString separator = firstValue ? QString("if (e > 0) *p++ = ',';") : QString("*p++ = ',';");
+            firstValue = false;
+            row += QString("    for (size_t e = 0; e < %1; ++e) {\n        %2\n"
+                           "        if (available >= %3 + e * %4) p = putValue<%5, Swap>(p, data + %6 + e * %4);\n    }\n")
+                       .arg(count, separator, QString::number(field.offset + field.stride), stride, type, offset);
+        }
+    }
+    if (layout.fieldCount() == 0) {
+        elementTable = "    nullptr,\n";
+        frameTable = "    nullptr,\n";
+    }
+
+    QString source;
+    source += QString("// SpectraDAQ decoder plugin for a %1-byte struct, layout %2, generated from:\n").arg(size, hexHash(layout));
+    source += header;
+    source += QString("//\n// Build it as a shared library in the decoders directory next to SpectraDAQ, with any\n"
+                      "// other optimization flags wanted (-march=native...):\n"
+                      "//   g++ -std=c++17 -O3 -shared -fPIC %1.cpp -o decoders/lib%1.so\n"
+                      "//   cl /std:c++17 /O2 /LD %1.cpp /Fe:decoders\\%1.dll\n").arg(name);
+    source += "#include <charconv>\n#include <cstddef>\n#include <cstdint>\n#include <cstdio>\n#include <cstring>\n"
+              "#include <type_traits>\n\n";
+    source += PLUGIN_API;
+    source += "\nnamespace {\n\n";
+    source += QString("constexpr size_t STRUCT_SIZE = %1;\n\n").arg(size);
+    source += PLUGIN_HELPERS;
+    source += "\n" + kernels;
+    source += "template <bool Swap>\nsize_t formatRow(const char* data, size_t available, char* out) {\n"
+              "    char* p = out;\n";
+    source += row.isEmpty() ? QString("    (void)data;\n    (void)available;\n") : row;
+    source += "    return static_cast<size_t>(p - out);\n}\n\n";
+    source += "size_t formatCsvRow(const char* data, size_t available, bool swapBytes, char* out) {\n"
+              "    return swapBytes ? formatRow<true>(data, available, out) : formatRow<false>(data, available, out);\n}\n\n";
+    source += "const DecoderPluginKernel ELEMENT_KERNELS[] = {\n" + elementTable + "};\n";
+    source += "const DecoderPluginKernel FRAME_KERNELS[] = {\n" + frameTable + "};\n\n";
+    source += "} // namespace\n\n";
+    source += "#ifdef _WIN32\n#define PLUGIN_EXPORT __declspec(dllexport)\n#else\n"
+              "#define PLUGIN_EXPORT __attribute__((visibility(\"default\")))\n#endif\n\n";
+    source += QString("extern \"C\" PLUGIN_EXPORT const DecoderPlugin* %1() {\n").arg(DECODER_PLUGIN_ENTRY);
+    source += QString("    static const DecoderPlugin plugin = {%1, 0x%2ull, %3, %4, ELEMENT_KERNELS, FRAME_KERNELS, formatCsvRow};\n")
+                  .arg(QString::number(DECODER_PLUGIN_ABI), hexHash(layout), size, QString::number(layout.fieldCount()));
+    source += "    return &plugin;\n}\n";
+    return source;
+}
+
+QString decoderPluginName(const CompiledLayout& layout) {
+    return "spectradaq_decoder_" + hexHash(layout);
+}
+
+QString decoderPluginDirectory() {
+    return QDir(QCoreApplication::applicationDirPath()).filePath("decoders");
+}
+
+const DecoderPlugin* loadDecoderPlugin(const QString& path, const CompiledLayout& layout, QString* error) {
+    static QMutex mutex;
+    static QHash<QString, const DecoderPlugin*> loaded; // By path, never unloaded
+    QMutexLocker lock(&mutex);
+    const DecoderPlugin* plugin = loaded.value(path, nullptr);
+    if (!plugin) {
+        QLibrary library(path);
+        if (!library.load()) {
+            if (error) *error = library.errorString();
+            return nullptr;
+        }
+        auto entry = reinterpret_cast<DecoderPluginEntry>(library.resolve(DECODER_PLUGIN_ENTRY));
+        if (!entry) {
+            if (error) *error = QString("%1 is not a decoder plugin").arg(library.fileName());
+            library.unload();
+            return nullptr;
+        }
+        plugin = entry();
+        loaded.insert(path, plugin);
+    }
+    CompiledLayout check = layout;
+    if (!plugin || !check.setPlugin(plugin)) {
+        if (error) {
+            *error = plugin && plugin->abi != DECODER_PLUGIN_ABI
+                         ? QString("%1 has plugin ABI %2, not %3").arg(path).arg(plugin->abi).arg(DECODER_PLUGIN_ABI)
+                         : QString("%1 was generated for another struct layout").arg(path);
+        }
+        return nullptr;
+    }
+    return plugin;
+}
+
+const DecoderPlugin* findDecoderPlugin(const CompiledLayout& layout) {
+    if (layout.size() == 0) return nullptr;
+    QString path = QDir(decoderPluginDirectory()).filePath(decoderPluginName(layout));
+    QString error;
+    const DecoderPlugin* plugin = loadDecoderPlugin(path, layout, &error);
+#ifdef ENABLE_DEBUG
+    if (plugin) qDebug() << "[DecoderPlugin] Loaded" << path;
+    else qDebug() << "[DecoderPlugin] None for this layout:" << error;
+#endif
+    return plugin;
+}
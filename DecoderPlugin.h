@@ -0,0 +1,32 @@
+#ifndef DECODERPLUGIN_H
+#define DECODERPLUGIN_H
+
+#include <QString>
+#include <QList>
+#include "FieldDef.h"
+#include "CompiledLayout.h"
+#include "DecoderPluginApi.h"
+
+// Decoder plugins: the layout of one struct compiled ahead of time into a shared library,
+// each field's offset, the struct stride and the byte swaps constants of its own loops, in
+// place of the generic kernels walking a CompiledLayout. A plugin is found by its layout's
+// hash, so it only ever decodes the layout it was generated from; without one, decoding
+// takes the generic path.
+
+// The C++ source of a plugin for the struct of these fields (parseCStruct() output): one
+// translation unit, needing nothing but a C++17 compiler, with its build command at the top
+QString generateDecoderPlugin(const QList<FieldDef>& fields);
+
+// The library name a plugin for layout goes by, without prefix or suffix:
+// "spectradaq_decoder_<hash>", built as libspectradaq_decoder_<hash>.so or ...dll
+QString decoderPluginName(const CompiledLayout& layout);
+// Where plugins are looked for: "decoders" next to the executable
+QString decoderPluginDirectory();
+
+// The plugin in the library at path, if it loads and was generated for layout; otherwise null
+// and, with error, why not. Libraries stay loaded, as plans hold their kernels.
+const DecoderPlugin* loadDecoderPlugin(const QString& path, const CompiledLayout& layout, QString* error = nullptr);
+// The plugin for layout in decoderPluginDirectory(), or null
+const DecoderPlugin* findDecoderPlugin(const CompiledLayout& layout);
+
+#endif // DECODERPLUGIN_H
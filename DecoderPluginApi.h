@@ -0,0 +1,39 @@
+#ifndef DECODERPLUGINAPI_H
+#define DECODERPLUGINAPI_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The C interface of a decoder plugin: a shared library generated for one struct layout by
+// generateDecoderPlugin(), with the layout's offsets, strides and byte swaps compiled in.
+// generateDecoderPlugin() writes these same declarations into every plugin it generates, so
+// a change here needs the same change there and a new DECODER_PLUGIN_ABI.
+#define DECODER_PLUGIN_ABI 1
+#define DECODER_PLUGIN_ENTRY "spectradaq_decoder_plugin"
+
+extern "C" {
+
+// Converts one value of every struct in data (structs of the layout's size, back to back) to
+// float: element `element` of its field, or for a frame kernel the field's whole array per
+// struct, count values a row
+typedef void (*DecoderPluginKernel)(const char* data, size_t structs, uint32_t element, float* out);
+
+struct DecoderPlugin {
+    uint32_t abi;        // DECODER_PLUGIN_ABI of the generator
+    uint64_t layoutHash; // CompiledLayout::hash() of the layout it was generated from
+    uint32_t structSize;
+    uint32_t fieldCount;
+    // Per field, native then swapped byte order (index 2 * field + swap); null for a field
+    // of unknown type, and frame kernels null for bitfields
+    const DecoderPluginKernel* elementKernels;
+    const DecoderPluginKernel* frameKernels;
+    // CompiledLayout::formatCsvRow() of the same layout, byte for byte
+    size_t (*formatCsvRow)(const char* data, size_t available, bool swapBytes, char* out);
+};
+
+// The function a plugin exports under DECODER_PLUGIN_ENTRY
+typedef const DecoderPlugin* (*DecoderPluginEntry)();
+
+}
+
+#endif // DECODERPLUGINAPI_H
@@ -0,0 +1,444 @@
+#include "DerivedChannel.h"
+#include <QHash>
+#include <QDebug>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+using Op = ChannelProgram::Op;
+
+// The expression as a tree, folded where it is constant before any code is emitted
+struct Node {
+    enum Kind { Constant, Input, Apply } kind = Constant;
+    double value = 0;          // Constant
+    int input = -1;            // Input: its index in the program
+    Op op = Op::Add;           // Apply: the two-operand or one-operand operator
+    std::vector<std::unique_ptr<Node>> args;
+    std::vector<float> table;  // Poly coefficients or Lut points
+};
+
+std::unique_ptr<Node> constant(double value) {
+    auto node = std::make_unique<Node>();
+    node->value = value;
+    return node;
+}
+
+bool isBinary(Op op) { return op >= Op::Add && op <= Op::Atan2; }
+
+double apply(Op op, double x, double y, const std::vector<float>& table) {
+    switch (op) {
+    case Op::Add: return x + y;
+    case Op::Sub: return x - y;
+    case Op::Mul: return x * y;
+    case Op::Div: return x / y;
+    case Op::Pow: return std::pow(x, y);
+    case Op::Min: return y < x ? y : x;
+    case Op::Max: return x < y ? y : x;
+    case Op::Atan2: return std::atan2(x, y);
+    case Op::Neg: return -x;
+    case Op::Abs: return std::fabs(x);
+    case Op::Sqrt: return std::sqrt(x);
+    case Op::Exp: return std::exp(x);
+    case Op::Log: return std::log(x);
+    case Op::Log10: return std::log10(x);
+    case Op::Sin: return std::sin(x);
+    case Op::Cos: return std::cos(x);
+    case Op::Tan: return std::tan(x);
+    case Op::Floor: return std::floor(x);
+    case Op::Ceil: return std::ceil(x);
+    case Op::Poly: {
+        double v = 0;
+        for (size_t k = table.size(); k > 0; --k) v = v * x + table[k - 1];
+        return v;
+    }
+    case Op::Lut: {
+        size_t count = table.size() / 2;
+        if (!(x > table[0])) return table[1];
+        if (x >= table[2 * (count - 1)]) return table[2 * count - 1];
+        size_t k = 1;
+        while (table[2 * k] < x) ++k;
+        double x0 = table[2 * k - 2], y0 = table[2 * k - 1], x1 = table[2 * k], y1 = table[2 * k + 1];
+        return y0 + (x - x0) * (y1 - y0) / (x1 - x0);
+    }
+    default: return 0;
+    }
+}
+
+// The two-operand operators with a constant right operand
+bool withConstant(Op op, Op& out) {
+    switch (op) {
+    case Op::Add: out = Op::AddC; return true;
+    case Op::Sub: out = Op::SubC; return true;
+    case Op::Mul: out = Op::MulC; return true;
+    case Op::Div: out = Op::DivC; return true;
+    case Op::Pow: out = Op::PowC; return true;
+    case Op::Min: out = Op::MinC; return true;
+    case Op::Max: out = Op::MaxC; return true;
+    default: return false;
+    }
+}
+
+// ... and with a constant left one
+bool withConstantLeft(Op op, Op& out) {
+    switch (op) {
+    case Op::Add: out = Op::AddC; return true;
+    case Op::Mul: out = Op::MulC; return true;
+    case Op::Min: out = Op::MinC; return true;
+    case Op::Max: out = Op::MaxC; return true;
+    case Op::Sub: out = Op::RSubC; return true;
+    case Op::Div: out = Op::RDivC; return true;
+    default: return false;
+    }
+}
+
+struct Function {
+    const char* name;
+    Op op;
+    int arguments; // -1: poly/lut, variable
+};
+
+const Function FUNCTIONS[] = {
+    {"abs", Op::Abs, 1},    {"sqrt", Op::Sqrt, 1},   {"exp", Op::Exp, 1},   {"log", Op::Log, 1},
+    {"log10", Op::Log10, 1}, {"sin", Op::Sin, 1},    {"cos", Op::Cos, 1},   {"tan", Op::Tan, 1},
+    {"floor", Op::Floor, 1}, {"ceil", Op::Ceil, 1},  {"min", Op::Min, 2},   {"max", Op::Max, 2},
+    {"pow", Op::Pow, 2},     {"atan2", Op::Atan2, 2}, {"poly", Op::Poly, -1}, {"lut", Op::Lut, -1},
+    {"clamp", Op::Min, 3}, // max(min(x, hi), lo)
+};
+
+// Recursive descent over one expression: expr := term (+|- term)*, term := unary (*|/ unary)*,
+// unary := -unary | +unary | power, power := primary (^ unary)?
+class Parser {
+public:
+    Parser(const QString& text, const QHash<QString, QPair<int, int>>& names, ChannelProgram& program)
+        : text(text), names(names), program(program) {}
+
+    std::unique_ptr<Node> parse() {
+        auto node = expression();
+        skipSpaces();
+        if (error.isEmpty() && pos < text.size()) fail(QString("unexpected '%1'").arg(text.mid(pos, 1)));
+        return error.isEmpty() ? std::move(node) : nullptr;
+    }
+    QString error;
+
+private:
+    const QString& text;
+    const QHash<QString, QPair<int, int>>& names;
+    ChannelProgram& program;
+    int pos = 0;
+
+    void fail(const QString& message) {
+        if (error.isEmpty()) error = message;
+    }
+    void skipSpaces() {
+        while (pos < text.size() && text[pos].isSpace()) ++pos;
+    }
+    bool accept(char c) {
+        skipSpaces();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    void expect(char c) {
+        if (!accept(c)) fail(QString("expected '%1' at %2").arg(QString(QChar(c))).arg(pos + 1));
+    }
+
+    static std::unique_ptr<Node> combine(Op op, std::unique_ptr<Node> x, std::unique_ptr<Node> y = nullptr) {
+        bool folded = x->kind == Node::Constant && (!y || y->kind == Node::Constant);
+        if (folded) return constant(apply(op, x->value, y ? y->value : 0, {}));
+        auto node = std::make_unique<Node>();
+        node->kind = Node::Apply;
+        node->op = op;
+        node->args.push_back(std::move(x));
+        if (y) node->args.push_back(std::move(y));
+        return node;
+    }
+
+    std::unique_ptr<Node> expression() {
+        auto node = term();
+        while (error.isEmpty()) {
+            if (accept('+')) node = combine(Op::Add, std::move(node), term());
+            else if (accept('-')) node = combine(Op::Sub, std::move(node), term());
+            else break;
+        }
+        return node;
+    }
+    std::unique_ptr<Node> term() {
+        auto node = unary();
+        while (error.isEmpty()) {
+            if (accept('*')) node = combine(Op::Mul, std::move(node), unary());
+            else if (accept('/')) node = combine(Op::Div, std::move(node), unary());
+            else break;
+        }
+        return node;
+    }
+    std::unique_ptr<Node> unary() {
+        if (accept('-')) return combine(Op::Neg, unary());
+        if (accept('+')) return unary();
+        auto node = primary();
+        if (error.isEmpty() && accept('^')) node = combine(Op::Pow, std::move(node), unary());
+        return node;
+    }
+
+    std::unique_ptr<Node> primary() {
+        skipSpaces();
+        if (pos >= text.size()) {
+            fail("unexpected end");
+            return constant(0);
+        }
+        if (accept('(')) {
+            auto node = expression();
+            expect(')');
+            return node;
+        }
+        QChar c = text[pos];
+        if (c.isDigit() || c == '.') return number();
+        if (c.isLetter() || c == '_') return name();
+        fail(QString("unexpected '%1'").arg(QString(c)));
+        return constant(0);
+    }
+
+    std::unique_ptr<Node> number() {
+        int start = pos;
+        while (pos < text.size() && (text[pos].isDigit() || text[pos] == '.')) ++pos;
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            int mark = pos++;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) ++pos;
+            if (pos < text.size() && text[pos].isDigit()) {
+                while (pos < text.size() && text[pos].isDigit()) ++pos;
+            } else {
+                pos = mark;
+            }
+        }
+        bool ok = false;
+        double value = text.mid(start, pos - start).toDouble(&ok);
+        if (!ok) fail(QString("bad number '%1'").arg(text.mid(start, pos - start)));
+        return constant(value);
+    }
+
+    // A field, array element or earlier channel ("hdr.seq", "samples[2]"), pi, or a call
+    std::unique_ptr<Node> name() {
+        QString word;
+        while (pos < text.size()) {
+            QChar c = text[pos];
+            if (c.isLetterOrNumber() || c == '_') {
+                word += c;
+                ++pos;
+            } else if (c == '.' && pos + 1 < text.size() && (text[pos + 1].isLetter() || text[pos + 1] == '_')) {
+                word += c;
+                ++pos;
+            } else if (c == '[') {
+                int close = text.indexOf(']', pos);
+                if (close < 0) break;
+                word += '[';
+                word += text.mid(pos + 1, close - pos - 1).trimmed();
+                word += ']';
+                pos = close + 1;
+            } else {
+                break;
+            }
+        }
+        if (accept('(')) return call(word);
+        if (word == "pi") return constant(M_PI);
+        auto found = names.find(word);
+        if (found == names.end()) {
+            fail(QString("unknown name '%1'").arg(word));
+            return constant(0);
+        }
+        if (found.value().second < 0) {
+            fail(QString("%1 is an array: pick an element, %1[0]").arg(word));
+            return constant(0);
+        }
+        auto node = std::make_unique<Node>();
+        node->kind = Node::Input;
+        node->input = program.addInput(found.value().first, found.value().second);
+        if (node->input < 0) fail(QString("more than %1 inputs").arg(ChannelProgram::MAX_INPUTS));
+        return node;
+    }
+
+    std::unique_ptr<Node> call(const QString& function) {
+        std::vector<std::unique_ptr<Node>> args;
+        if (!accept(')')) {
+            do {
+                args.push_back(expression());
+            } while (error.isEmpty() && accept(','));
+            expect(')');
+        }
+        if (!error.isEmpty()) return constant(0);
+        for (const Function& f : FUNCTIONS) {
+            if (function != f.name) continue;
+            if (f.arguments >= 0 && static_cast<int>(args.size()) != f.arguments) {
+                fail(QString("%1() takes %2 arguments").arg(function).arg(f.arguments));
+                return constant(0);
+            }
+            if (f.arguments == 1) return combine(f.op, std::move(args[0]));
+            if (f.arguments == 2) return combine(f.op, std::move(args[0]), std::move(args[1]));
+            if (f.arguments == 3) {
+                return combine(Op::Max, combine(Op::Min, std::move(args[0]), std::move(args[2])), std::move(args[1]));
+            }
+            return table(f.op, function, std::move(args));
+        }
+        fail(QString("unknown function %1()").arg(function));
+        return constant(0);
+    }
+
+    // poly() and lut(): x, then constants
+    std::unique_ptr<Node> table(Op op, const QString& function, std::vector<std::unique_ptr<Node>> args) {
+        auto node = std::make_unique<Node>();
+        node->kind = Node::Apply;
+        node->op = op;
+        for (size_t k = 1; k < args.size(); ++k) {
+            if (args[k]->kind != Node::Constant) {
+                fail(QString("%1() takes constants after x").arg(function));
+                return constant(0);
+            }
+            node->table.push_back(static_cast<float>(args[k]->value));
+        }
+        if (op == Op::Poly && node->table.empty()) {
+            fail("poly() needs a coefficient");
+            return constant(0);
+        }
+        if (op == Op::Lut) {
+            if (node->table.size() < 4 || node->table.size() % 2) {
+                fail("lut() needs x, y pairs, at least two");
+                return constant(0);
+            }
+            for (size_t k = 2; k < node->table.size(); k += 2) {
+                if (!(node->table[k] > node->table[k - 2])) {
+                    fail("lut() points need increasing x");
+                    return constant(0);
+                }
+            }
+        }
+        if (args.empty()) return constant(0);
+        if (args[0]->kind == Node::Constant) return constant(apply(op, args[0]->value, 0, node->table));
+        node->args.push_back(std::move(args[0]));
+        return node;
+    }
+};
+
+// Postfix code for the tree; false if the stack would overflow
+bool emitCode(const Node& node, ChannelProgram& program) {
+    ChannelProgram::Instruction in;
+    switch (node.kind) {
+    case Node::Constant:
+        in.op = Op::Const;
+        in.a = static_cast<float>(node.value);
+        return program.emit(in);
+    case Node::Input:
+        in.op = Op::Input;
+        in.index = static_cast<uint32_t>(node.input);
+        return program.emit(in);
+    case Node::Apply:
+        break;
+    }
+    if (isBinary(node.op)) {
+        const Node& x = *node.args[0];
+        const Node& y = *node.args[1];
+        // A constant operand goes in the instruction
+        if (y.kind == Node::Constant && withConstant(node.op, in.op)) {
+            in.a = static_cast<float>(y.value);
+            return emitCode(x, program) && program.emit(in);
+        }
+        if (x.kind == Node::Constant && withConstantLeft(node.op, in.op)) {
+            in.a = static_cast<float>(x.value);
+            return emitCode(y, program) && program.emit(in);
+        }
+        in.op = node.op;
+        return emitCode(x, program) && emitCode(y, program) && program.emit(in);
+    }
+    in.op = node.op;
+    if (node.op == Op::Poly || node.op == Op::Lut) {
+        in.index = program.addTable(node.table);
+        in.count = static_cast<uint32_t>(node.op == Op::Lut ? node.table.size() / 2 : node.table.size());
+    }
+    return emitCode(*node.args[0], program) && program.emit(in);
+}
+
+} // namespace
+
+QList<DerivedChannel> parseDerivedChannels(const QString& text, const QList<FieldDef>& fields) {
+    // Every name an expression can use: (field, element), element -1 for a whole array
+    QHash<QString, QPair<int, int>> names;
+    CompiledLayout layout(fields);
+    for (int f = 0; f < fields.size(); ++f) {
+        if (!layout.field(f).known) continue;
+        if (fields[f].count == 1) {
+            names.insert(fields[f].name, qMakePair(f, 0));
+            continue;
+        }
+        names.insert(fields[f].name, qMakePair(f, -1));
+        for (int e = 0; e < fields[f].count; ++e) names.insert(QString("%1[%2]").arg(fields[f].name).arg(e), qMakePair(f, e));
+    }
+
+    QList<DerivedChannel> channels;
+    for (QString line : text.split('\n')) {
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith("#") || line.startsWith("//")) continue;
+        if (line.endsWith(";")) line.chop(1);
+        DerivedChannel channel;
+        int equals = line.indexOf('=');
+        channel.name = equals > 0 ? line.left(equals).trimmed() : QString();
+        channel.expression = equals > 0 ? line.mid(equals + 1).trimmed() : line;
+        bool named = !channel.name.isEmpty() && (channel.name[0].isLetter() || channel.name[0] == '_');
+        for (int k = 0; named && k < channel.name.size(); ++k) {
+            named = channel.name[k].isLetterOrNumber() || channel.name[k] == '_' || channel.name[k] == '.';
+        }
+        if (!named) {
+            channel.error = "expected name = expression";
+        } else if (names.contains(channel.name)) {
+            channel.error = QString("%1 is already a field or channel").arg(channel.name);
+        } else {
+            auto program = std::make_shared<ChannelProgram>();
+            Parser parser(channel.expression, names, *program);
+            std::unique_ptr<Node> tree = parser.parse();
+            channel.error = parser.error;
+            if (channel.error.isEmpty() && program->inputs().empty()) channel.error = "uses no field";
+            if (channel.error.isEmpty() && (!emitCode(*tree, *program) || !program->complete())) {
+                channel.error = "too deeply nested";
+            }
+            if (channel.error.isEmpty()) {
+                channel.program = program;
+                // Later lines can use it
+                names.insert(channel.name, qMakePair(fields.size() + channels.size(), 0));
+            }
+        }
+#ifdef ENABLE_DEBUG
+        qDebug() << "[DerivedChannel]" << channel.name << "=" << channel.expression
+                 << (channel.error.isEmpty() ? QString("%1 instructions").arg(channel.program->size()) : channel.error);
+#endif
+        channels.append(channel);
+    }
+    return channels;
+}
+
+ExtractionPlan planChannels(const CompiledLayout& layout, const QList<DerivedChannel>& channels,
+                            const QVector<QPair<int, int>>& selection, bool swapBytes) {
+    const int fieldCount = layout.fieldCount();
+    QVector<QPair<int, int>> decoded;
+    std::vector<bool> needed(channels.size(), false);
+    for (const auto& pick : selection) {
+        int d = pick.first - fieldCount;
+        if (d < 0) decoded.append(pick);
+        else if (d < channels.size() && channels[d].program) needed[d] = true;
+    }
+    // Channels only use earlier ones, so going backwards finds everything a pick needs
+    for (int d = channels.size() - 1; d >= 0; --d) {
+        if (!needed[d]) continue;
+        for (const auto& input : channels[d].program->inputs()) {
+            int used = input.first - fieldCount;
+            if (used >= 0) {
+                if (used < d && channels[used].program) needed[used] = true;
+            } else if (!decoded.contains(qMakePair(input.first, input.second))) {
+                decoded.append(qMakePair(input.first, input.second));
+            }
+        }
+    }
+    ExtractionPlan plan = layout.plan(decoded, swapBytes);
+    for (int d = 0; d < channels.size(); ++d) {
+        if (needed[d]) plan.addDerived(fieldCount + d, channels[d].program);
+    }
+    return plan;
+}
@@ -0,0 +1,43 @@
+#ifndef DERIVEDCHANNEL_H
+#define DERIVEDCHANNEL_H
+
+#include <QString>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <memory>
+#include "FieldDef.h"
+#include "CompiledLayout.h"
+#include "ChannelProgram.h"
+
+// A virtual channel computed from the struct's fields, such as scaled ADC counts or the
+// magnitude of an I/Q pair; plotted and logged like a field. It comes after the struct's
+// fields: channel d is field fields.size() + d in a plan selection.
+struct DerivedChannel {
+    QString name;
+    QString expression;
+    QString error; // Why it didn't compile; empty if it did
+    std::shared_ptr<const ChannelProgram> program;
+};
+
+// Compiles "name = expression" lines against the struct's fields; blank lines and lines
+// starting with # or // are skipped. An expression is float arithmetic on:
+// - numbers, pi, field names ("raw", "hdr.seq") and array elements ("samples[2]"), the
+//   channels defined on earlier lines
+// - + - * / ^ (power) and parentheses
+// - abs sqrt exp log log10 sin cos tan floor ceil, min(a, b) max(a, b) pow(a, b)
+//   atan2(y, x) clamp(x, lo, hi)
+// - poly(x, c0, c1, ...): c0 + c1*x + c2*x^2... with constant coefficients
+// - lut(x, x0, y0, x1, y1, ...): linear interpolation between constant points of increasing
+//   x, held at the end values outside them
+// Constant parts are folded when compiled. A line that doesn't compile gives a channel with
+// an error and no program.
+QList<DerivedChannel> parseDerivedChannels(const QString& text, const QList<FieldDef>& fields);
+
+// CompiledLayout::plan() for a selection that may pick derived channels (field index
+// layout.fieldCount() + d, element 0): the fields they read are decoded too, then each
+// picked channel is computed from them, after the channels it uses
+ExtractionPlan planChannels(const CompiledLayout& layout, const QList<DerivedChannel>& channels,
+                            const QVector<QPair<int, int>>& selection, bool swapBytes);
+
+#endif // DERIVEDCHANNEL_H
@@ -0,0 +1,112 @@
+#include "ExtractionPlan.h"
+#include <algorithm>
+#include <cstring>
+
+void ColumnBuffers::reserve(const ExtractionPlan& plan, size_t rows) {
+    bool same = widths.size() == plan.columnCount();
+    for (size_t c = 0; same && c < widths.size(); ++c) same = widths[c] == plan.column(c).count;
+    if (same && rows <= rowCapacity) return;
+    size_t capacity = same ? std::max(rows, rowCapacity * 2) : rows;
+    std::vector<std::unique_ptr<float[]>> grown(plan.columnCount());
+    for (size_t c = 0; c < grown.size(); ++c) {
+        grown[c].reset(new float[capacity * plan.column(c).count]);
+        if (same && rowCount > 0) memcpy(grown[c].get(), columns[c].get(), size(c) * sizeof(float));
+    }
+    if (!same) {
+        // A different plan: nothing to keep
+        rowCount = 0;
+        widths.resize(plan.columnCount());
+        for (size_t c = 0; c < widths.size(); ++c) widths[c] = plan.column(c).count;
+    }
+    columns = std::move(grown);
+    rowCapacity = capacity;
+}
+
+ExtractionPlan::ExtractionPlan(std::vector<Column> columns, size_t stride, bool swapBytes, DecodeIsa isa)
+    : structStride(stride), swap(swapBytes) {
+    for (Column column : columns) {
+        if (column.count == 0 || column.offset + scalarSize(column.type) * column.count > stride) continue;
+        Bitfield bitfield;
+        if (column.bitWidth > 0) {
+            bitfield.kernel = bitfieldKernel(column.type, swap);
+            if (!bitfield.kernel) continue;
+            bitfield.bits = bitfieldMask(column.type, column.bitShift, column.bitWidth);
+            column.count = 1;
+        }
+        columnList.push_back(column);
+        bitfields.push_back(bitfield);
+        // A frame is a dense array inside each struct
+        size_t step = column.count > 1 ? scalarSize(column.type) : stride;
+        kernels.push_back(decodeKernel(column.type, swap, step, isa));
+        pluginKernels.push_back(nullptr);
+    }
+}
+
+int ExtractionPlan::find(int field, int element) const {
+    for (size_t c = 0; c < columnList.size(); ++c) {
+        if (columnList[c].field == field && columnList[c].element == element) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+bool ExtractionPlan::addDerived(int field, std::shared_ptr<const ChannelProgram> program) {
+    if (!program) return false;
+    Derived channel{columnList.size(), std::move(program), {}};
+    for (const auto& input : channel.program->inputs()) {
+        int c = find(input.first, input.second);
+        if (c < 0 || columnList[c].count != 1) return false;
+        channel.inputs.push_back(static_cast<size_t>(c));
+    }
+    columnList.push_back({0, ScalarType::Float32, field, 0, 1});
+    kernels.push_back(nullptr);
+    bitfields.emplace_back();
+    pluginKernels.push_back(nullptr);
+    derived.push_back(std::move(channel));
+    return true;
+}
+
+size_t ExtractionPlan::decode(const char* data, size_t size, ColumnBuffers& out) const {
+    if (empty()) return 0;
+    size_t structs = size / structStride;
+    if (structs == 0) return 0;
+    size_t first = out.rowCount;
+    out.reserve(*this, first + structs);
+    // Column by column, each kernel running over every struct of the datagram, or over
+    // each struct's array in turn for a frame
+    const size_t decoded = columnList.size() - derived.size();
+    for (size_t c = 0; c < decoded; ++c) {
+        const char* field = data + columnList[c].offset;
+        const size_t count = columnList[c].count;
+        float* column = out.columns[c].get();
+        if (pluginKernels[c]) {
+            // Offsets and stride compiled in: it takes the datagram itself
+            pluginKernels[c](data, structs, static_cast<uint32_t>(std::max(columnList[c].element, 0)), column + first * count);
+            continue;
+        }
+        if (bitfields[c].kernel) {
+            bitfields[c].kernel(field, structStride, structs, bitfields[c].bits, column + first);
+            continue;
+        }
+        if (count == 1) {
+            kernels[c](field, structStride, structs, column + first);
+            continue;
+        }
+        const size_t elementSize = scalarSize(columnList[c].type);
+        if (count * elementSize == structStride) {
+            // Structs that are just the array: one dense run over the datagram
+            kernels[c](field, elementSize, structs * count, column + first * count);
+            continue;
+        }
+        for (size_t s = 0; s < structs; ++s) {
+            kernels[c](field + s * structStride, elementSize, count, column + (first + s) * count);
+        }
+    }
+    // Then the derived columns, in order, so one can read another added before it
+    const float* inputs[ChannelProgram::MAX_INPUTS];
+    for (const Derived& channel : derived) {
+        for (size_t i = 0; i < channel.inputs.size(); ++i) inputs[i] = out.columns[channel.inputs[i]].get() + first;
+        channel.program->evaluate(inputs, structs, out.columns[channel.column].get() + first);
+    }
+    out.rowCount = first + structs;
+    return structs;
+}
@@ -0,0 +1,103 @@
+#ifndef EXTRACTIONPLAN_H
+#define EXTRACTIONPLAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "ChannelProgram.h"
+#include "DecodeKernels.h"
+#include "DecoderPluginApi.h"
+
+class ExtractionPlan;
+
+// Decoded values, one contiguous float array per plan column (structure of arrays), with a
+// row per struct; a sample frame column holds its whole array for each row. Filled batch
+// after batch by ExtractionPlan::decode(); clear() keeps the memory, so a buffer that has
+// seen its largest batch never allocates again.
+class ColumnBuffers {
+public:
+    size_t columnCount() const { return columns.size(); }
+    size_t rows() const { return rowCount; }
+    const float* column(size_t c) const { return columns[c].get(); }
+    // Values in column c: rows() times its width
+    size_t size(size_t c) const { return rowCount * widths[c]; }
+    void clear() { rowCount = 0; }
+    // Room for `rows` rows of plan's columns, keeping what is there if the columns match
+    void reserve(const ExtractionPlan& plan, size_t rows);
+
+private:
+    friend class ExtractionPlan;
+    std::vector<std::unique_ptr<float[]>> columns;
+    std::vector<size_t> widths;
+    size_t rowCount = 0;
+    size_t rowCapacity = 0;
+};
+
+// A compiled list of the values to pull out of every struct in a datagram: for each
+// column, its byte offset within the struct (array element included) and its type. The
+// struct stride and the byte order are fixed at compile time, and each column gets a decode
+// kernel instantiated for its (type, byte order) pair, so decoding a datagram is one call
+// per column over all its structs, with no per-value dispatch.
+class ExtractionPlan {
+public:
+    struct Column {
+        uint32_t offset;  // Within the struct
+        ScalarType type;
+        int field;        // Index of the source field, and the array element
+        int element;
+        uint32_t count = 1; // Elements from there on taken per struct: > 1 reads the array as a sample frame
+        uint8_t bitShift = 0; // A bitfield: bitWidth bits from bitShift of the type-sized unit at offset
+        uint8_t bitWidth = 0;
+    };
+    using Kernel = DecodeKernel;
+
+    ExtractionPlan() = default;
+    // Kernels of the given instruction set where it has them, by default the best available
+    ExtractionPlan(std::vector<Column> columns, size_t stride, bool swapBytes, DecodeIsa isa = detectDecodeIsa());
+
+    bool empty() const { return columnList.empty() || structStride == 0; }
+    size_t columnCount() const { return columnList.size(); }
+    const Column& column(size_t c) const { return columnList[c]; }
+    size_t stride() const { return structStride; }
+    bool swapsBytes() const { return swap; }
+    // Column of a field's element, or -1
+    int find(int field, int element) const;
+    // Decode column c with a decoder plugin's kernel for its field (an element kernel, or a
+    // frame kernel for a frame column) instead of the generic one
+    void setPluginKernel(size_t c, DecoderPluginKernel kernel) { pluginKernels[c] = kernel; }
+    bool usesPlugin(size_t c) const { return pluginKernels[c] != nullptr; }
+    // Append a column computed by program from the plan's columns after they are decoded,
+    // under the given field index, element 0. Its inputs must be single-value columns already
+    // in the plan; false, and nothing added, if one isn't.
+    bool addDerived(int field, std::shared_ptr<const ChannelProgram> program);
+
+    // Append the values of every whole struct in data to out, one row per struct; returns
+    // the number of rows added. A frame column appends its elements in order, so
+    // consecutive structs' arrays read as one sample stream. Columns that would read past
+    // the struct are left out at construction. Derived columns are computed last, over the
+    // rows just added.
+    size_t decode(const char* data, size_t size, ColumnBuffers& out) const;
+
+private:
+    std::vector<Column> columnList;
+    std::vector<Kernel> kernels; // One per column
+    // A bitfield column's kernel and mask, with its entry in kernels unused; null otherwise
+    struct Bitfield {
+        BitfieldKernel kernel = nullptr;
+        BitfieldMask bits;
+    };
+    std::vector<Bitfield> bitfields;
+    std::vector<DecoderPluginKernel> pluginKernels; // Null: the column's generic kernel
+    // Columns computed from others, at the end of columnList in the order added
+    struct Derived {
+        size_t column;
+        std::shared_ptr<const ChannelProgram> program;
+        std::vector<size_t> inputs; // Columns of the program's inputs
+    };
+    std::vector<Derived> derived;
+    size_t structStride = 0;
+    bool swap = false;
+};
+
+#endif // EXTRACTIONPLAN_H
@@ -3,20 +3,19 @@
 
 #include <QString>
 #include <QList>
-#include <QVariant>
-#include <QByteArray>
-#include <vector>
 
 struct FieldDef {
-    QString type;
-    QString name;
+    QString type; // One of the primitive types; an enum field has its underlying type
+    QString name; // Members of nested structs are qualified: "header.seq", "points[2].x"
     int count;
+    // Where parseCStruct() placed it. A field without a layout (offset -1) goes after the
+    // previous one at its natural alignment.
+    int offset = -1;   // Bytes from the start of the struct; for a bitfield, of its storage unit
+    int align = 0;     // Alignment it gives the struct: its size, or less under #pragma pack; 0 for its size
+    int bitOffset = 0; // A bitfield's first bit in its unit, from the least significant bit
+    int bitWidth = 0;  // Bits of a bitfield, 0 for a whole value
+    int tail = 0;      // Padding after it up to the end of the struct, on the last field
+    QString declaredType; // The type as written when it isn't type: "enum Mode", "uint8_t : 3"
 };
 
-// Extracts all field values from a struct buffer, returns as QVariant (int, double, etc.)
-std::vector<QVariant> extractFieldValues(const QByteArray& structData, const QList<FieldDef>& fields, bool swapEndian = false);
-
-// Zero-copy version that works with raw pointers
-std::vector<QVariant> extractFieldValues(const char* data, size_t size, const QList<FieldDef>& fields, bool swapEndian = false);
-
-#endif // FIELDDEF_H 
\ No newline at end of file
+#endif // FIELDDEF_H
@@ -1,12 +1,11 @@
 #include "LoggingManager.h"
-#include "FieldDef.h"
 #include "mainwindow.h"
-#include <QDateTime>
+#include "DecoderPlugin.h"
 #include <QDebug>
 #include <QThread>
-#include <QVariant>
 #include <vector>
-#include "UdpWorker.h"
+#include <cstring>
+#include <charconv>
 #ifdef Q_OS_WIN
 #include <windows.h>
 #elif defined(Q_OS_LINUX)
@@ -14,16 +13,21 @@
 #include <sched.h>
 #endif
 
-LoggingManager::LoggingManager(const QList<FieldDef>& fields, int structSize, int durationSec, const QString& filename, UdpWorker* udpWorker, QObject* parent)
+LoggingManager::LoggingManager(const QList<FieldDef>& fields, int structSize, int durationSec, const QString& filename, PacketSource source, QObject* parent)
     : QObject(parent),
       m_fields(fields),
+      m_layout(fields),
       m_structSize(structSize),
       m_durationSec(durationSec),
       m_filename(filename),
       m_running(false),
-      m_udpWorker(udpWorker),
+      m_source(std::move(source)),
       m_bytesWritten(0)
 {
+    // Rows formatted by the layout's plugin, if one was built for it
+    m_layout.setPlugin(findDecoderPlugin(m_layout));
+    // Room for the longest row: a stamp, every value and the line end
+    m_csvRow.resize(STAMP_CHARS + 1 + m_layout.maxCsvRowBytes() + 1);
     m_file.setFileName(m_filename);
     m_timer = new QTimer(this);
     m_timer->setSingleShot(true);
@@ -34,6 +38,46 @@ LoggingManager::~LoggingManager() {
     stop();
 }
 
+void LoggingManager::setDerivedChannels(const QList<DerivedChannel>& channels) {
+    QVector<QPair<int, int>> selection;
+    m_derivedNames.clear();
+    for (int d = 0; d < channels.size(); ++d) {
+        if (!channels[d].program) continue;
+        selection.append(qMakePair(m_layout.fieldCount() + d, 0));
+        m_derivedNames << channels[d].name;
+    }
+    m_derivedPlan = selection.isEmpty() ? ExtractionPlan() : planChannels(m_layout, channels, selection, false);
+    m_derivedColumns.clear();
+    for (const auto& pick : selection) m_derivedColumns.push_back(m_derivedPlan.find(pick.first, pick.second));
+    // Room for their values too
+    m_csvRow.resize(STAMP_CHARS + 1 + m_layout.maxCsvRowBytes() + m_derivedColumns.size() * (CompiledLayout::MAX_VALUE_CHARS + 1) + 1);
+#ifdef ENABLE_DEBUG
+    qDebug() << "[LoggingManager] Derived channels:" << m_derivedNames;
+#endif
+}
+
+void LoggingManager::decodeDerived(const char* data, size_t size) {
+    if (m_derivedColumns.empty()) return;
+    m_derivedValues.clear();
+    m_derivedPlan.decode(data, size, m_derivedValues);
+}
+
+size_t LoggingManager::formatDerived(size_t row, char* out) const {
+    char* p = out;
+    for (int c : m_derivedColumns) {
+        *p++ = ',';
+        if (c >= 0 && row < m_derivedValues.rows()) p += CompiledLayout::formatValue(p, m_derivedValues.column(c)[row]);
+    }
+    return static_cast<size_t>(p - out);
+}
+
+LoggingManager::PacketSource LoggingManager::onePerCall(std::function<bool(PacketRing::Packet&)> pop) {
+    // One packet per batch: the next call invalidates the previous packet anyway
+    return [pop = std::move(pop)](PacketRing::Packet* out, int maxCount) {
+        return maxCount > 0 && pop(out[0]) ? 1 : 0;
+    };
+}
+
 void LoggingManager::start() {
     if (m_running.exchange(true)) return;
     
@@ -49,6 +93,8 @@ void LoggingManager::start() {
     }
     
     m_bytesWritten = 0;
+    m_writeBuffer = PacketMemory(WRITE_BUFFER_SIZE, m_memoryPolicy);
+    m_writeUsed = 0;
     m_writerThread = std::thread(&LoggingManager::writerThreadFunc, this);
     // Set thread priority for better performance
 #ifdef Q_OS_WIN
@@ -108,7 +154,7 @@ void LoggingManager::startBinaryLogging() {
     // Write binary header
     m_binaryHeader.structSize = m_structSize;
     m_binaryHeader.fieldCount = m_fields.size();
-    m_binaryHeader.startTimestamp = QDateTime::currentMSecsSinceEpoch();
+    m_binaryHeader.startTimestamp = wallClockNs();
     qint64 bytesWritten = m_binaryFile.write(reinterpret_cast<const char*>(&m_binaryHeader), sizeof(m_binaryHeader));
     m_binaryFile.flush();
     
@@ -171,41 +217,47 @@ void LoggingManager::convertBinaryToCSV(const QString& binaryFile, const QString
     qDebug() << "[LoggingManager] structSize:" << header.structSize << "fieldCount:" << header.fieldCount;
 #endif
     
-    // Write CSV header
+    // Write CSV header; the first column is each packet's receive timestamp
     QStringList headers;
+    headers << (header.version >= 2 ? "timestamp_ns" : "timestamp_ms");
     for (const FieldDef& f : m_fields) {
         for (int i = 0; i < f.count; ++i) {
             headers << (f.name + (f.count > 1 ? QString("[%1]").arg(i) : ""));
         }
     }
+    headers << m_derivedNames;
     outCsvFile.write(headers.join(",").toUtf8());
     outCsvFile.write("\n");
     
-    // Convert binary data to CSV
+    // Convert binary records to CSV, one row per struct
     QByteArray buffer;
-    const int BATCH_SIZE = 1024 * 1024; // 1MB batches
-    buffer.resize(BATCH_SIZE);
-    
     qint64 totalBytes = 0;
     qint64 totalPackets = 0;
     while (!binFile.atEnd()) {
-        qint64 bytesRead = binFile.read(buffer.data(), BATCH_SIZE);
-        if (bytesRead <= 0) break;
+        qint64 timestamp = 0;
+        quint64 size = 0;
+        if (binFile.read(reinterpret_cast<char*>(&timestamp), sizeof(timestamp)) != sizeof(timestamp) ||
+            binFile.read(reinterpret_cast<char*>(&size), sizeof(size)) != sizeof(size)) break;
+        buffer.resize(size);
+        if (binFile.read(buffer.data(), size) != static_cast<qint64>(size)) break; // Truncated record
         
-        // Process each struct in the buffer
-        for (qint64 offset = 0; offset <= bytesRead - m_structSize; offset += m_structSize) {
+        // Every row starts with the packet's stamp; the struct's values go after it
+        char* row = m_csvRow.data();
+        size_t stampLength = std::to_chars(row, row + STAMP_CHARS, timestamp).ptr - row;
+        row[stampLength++] = ',';
+        decodeDerived(buffer.constData(), size);
+        for (quint64 offset = 0; offset + m_structSize <= size; offset += m_structSize) {
             const char* structPtr = buffer.constData() + offset;
-            auto values = extractFieldValues(structPtr, m_structSize, m_fields);
-            QStringList row;
-            for (const QVariant& v : values) row << v.toString();
-            outCsvFile.write(row.join(",").toUtf8());
-            outCsvFile.write("\n");
-            totalPackets++;
+            size_t length = stampLength + m_layout.formatCsvRow(structPtr, m_structSize, false, row + stampLength);
+            length += formatDerived(offset / m_structSize, row + length);
+            row[length++] = '\n';
+            outCsvFile.write(row, length);
         }
+        totalPackets++;
         
-        totalBytes += bytesRead;
+        totalBytes += sizeof(timestamp) + sizeof(size) + size;
 #ifdef ENABLE_DEBUG
-        if (totalBytes % (10 * 1024 * 1024) == 0) { // Every 10MB
+        if (totalPackets % 100000 == 0) {
             qDebug() << "[LoggingManager] Converted" << totalBytes / 1024 / 1024 << "MB," << totalPackets << "packets";
         }
 #endif
@@ -223,23 +275,24 @@ void LoggingManager::convertBinaryToCSV(const QString& binaryFile, const QString
 void LoggingManager::writerThreadFunc() {
     if (m_binaryMode) {
         // Binary logging mode - maximum performance
-        QByteArray writeBuffer;
-        const int flushThreshold = 1024 * 1024; // 1MB for binary logging
+        const size_t flushThreshold = 1024 * 1024; // 1MB for binary logging
         int noDataCount = 0;
         const int MAX_NO_DATA_COUNT = 1000; // 5 seconds at 5ms sleep
         
         while (m_running) {
-            UdpWorker::Packet packet;
+            PacketRing::Packet batch[POP_BATCH];
             bool gotData = false;
             do {
-                gotData = m_udpWorker && m_udpWorker->popFromRingBuffer(packet);
-                if (gotData) {
-                    noDataCount = 0; // Reset counter when we get data
-                    // Write packet timestamp and data
-                    qint64 timestamp = packet.timestamp;
-                    writeBuffer.append(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
-                    writeBuffer.append(reinterpret_cast<const char*>(&packet.size), sizeof(packet.size));
-                    writeBuffer.append(packet.data, packet.size);
+                int count = m_source ? m_source(batch, POP_BATCH) : 0;
+                gotData = count > 0;
+                if (gotData) noDataCount = 0; // Reset counter when we get data
+                for (int b = 0; b < count; ++b) {
+                    const PacketRing::Packet& packet = batch[b];
+                    // Write packet receive timestamp (ns) and data
+                    qint64 timestamp = packet.timestampNs;
+                    appendToWriteBuffer(m_binaryFile, reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
+                    appendToWriteBuffer(m_binaryFile, reinterpret_cast<const char*>(&packet.size), sizeof(packet.size));
+                    appendToWriteBuffer(m_binaryFile, packet.data, packet.size);
                     m_binaryHeader.packetCount++;
                     m_bytesWritten += packet.size + sizeof(timestamp) + sizeof(packet.size);
                     
@@ -251,10 +304,7 @@ void LoggingManager::writerThreadFunc() {
                     }
 #endif
                 }
-                if (writeBuffer.size() > flushThreshold) {
-                    m_binaryFile.write(writeBuffer);
-                    writeBuffer.clear();
-                }
+                if (m_writeUsed > flushThreshold) flushWriteBuffer(m_binaryFile);
             } while (gotData);
             
             if (!gotData) {
@@ -271,45 +321,41 @@ void LoggingManager::writerThreadFunc() {
             QThread::usleep(1000); // 1 millisecond for high-rate binary mode
         }
         
-        if (!writeBuffer.isEmpty()) {
-            m_binaryFile.write(writeBuffer);
-            writeBuffer.clear();
-        }
+        flushWriteBuffer(m_binaryFile);
         m_binaryFile.flush();
     } else {
-        // CSV logging mode (original implementation)
-        QByteArray writeBuffer;
-        const int flushThreshold = 64 * 1024; // 64KB
+        // CSV logging mode: each struct formatted straight into the row buffer, then the write buffer
+        char* row = m_csvRow.data();
+        const size_t flushThreshold = 64 * 1024; // 64KB
         int noDataCount = 0;
         const int MAX_NO_DATA_COUNT = 1000; // 5 seconds at 5ms sleep
         
         while (m_running) {
-            UdpWorker::Packet packet;
+            PacketRing::Packet batch[POP_BATCH];
             bool gotData = false;
             do {
-                gotData = m_udpWorker && m_udpWorker->popFromRingBuffer(packet);
-                if (gotData) {
-                    noDataCount = 0; // Reset counter when we get data
+                int count = m_source ? m_source(batch, POP_BATCH) : 0;
+                gotData = count > 0;
+                if (gotData) noDataCount = 0; // Reset counter when we get data
+                for (int b = 0; b < count; ++b) {
+                    const PacketRing::Packet& packet = batch[b];
                     int nStructs = packet.size / m_structSize;
 #ifdef ENABLE_DEBUG
                     if (nStructs > 0) {
                         qDebug() << "[LoggingManager] Processing" << nStructs << "structs from packet of size" << packet.size;
                     }
 #endif
+                    decodeDerived(packet.data, packet.size);
                     for (int i = 0; i < nStructs; ++i) {
                         const char* structPtr = packet.data + i * m_structSize;
-                        auto values = extractFieldValues(structPtr, m_structSize, m_fields);
-                        QStringList row;
-                        for (const QVariant& v : values) row << v.toString();
-                        writeBuffer += row.join(",").toUtf8();
-                        writeBuffer += "\n";
+                        size_t length = m_layout.formatCsvRow(structPtr, m_structSize, false, row);
+                        length += formatDerived(i, row + length);
+                        row[length++] = '\n';
+                        appendToWriteBuffer(m_file, row, length);
                     }
                     m_bytesWritten += packet.size;
                 }
-                if (writeBuffer.size() > flushThreshold) {
-                    m_file.write(writeBuffer);
-                    writeBuffer.clear();
-                }
+                if (m_writeUsed > flushThreshold) flushWriteBuffer(m_file);
             } while (gotData);
             
             if (!gotData) {
@@ -325,10 +371,7 @@ void LoggingManager::writerThreadFunc() {
             
             QThread::usleep(1000); // 1 millisecond for high-rate CSV mode
         }
-        if (!writeBuffer.isEmpty()) {
-            m_file.write(writeBuffer);
-            writeBuffer.clear();
-        }
+        flushWriteBuffer(m_file);
         m_file.flush();
     }
 }
@@ -340,10 +383,29 @@ void LoggingManager::writeCsvHeader() {
             headers << (f.name + (f.count > 1 ? QString("[%1]").arg(i) : ""));
         }
     }
+    headers << m_derivedNames;
     m_file.write(headers.join(",").toUtf8());
     m_file.write("\n");
 }
 
+void LoggingManager::appendToWriteBuffer(QFile& file, const char* data, size_t size) {
+    if (m_writeUsed + size > m_writeBuffer.size()) {
+        flushWriteBuffer(file);
+        if (size > m_writeBuffer.size()) {
+            file.write(data, size);
+            return;
+        }
+    }
+    memcpy(m_writeBuffer.data() + m_writeUsed, data, size);
+    m_writeUsed += size;
+}
+
+void LoggingManager::flushWriteBuffer(QFile& file) {
+    if (m_writeUsed == 0) return;
+    file.write(m_writeBuffer.data(), m_writeUsed);
+    m_writeUsed = 0;
+}
+
 void LoggingManager::flushBuffer() {
     // No-op: all data is drained in writerThreadFunc
     m_file.flush();
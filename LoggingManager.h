@@ -7,19 +7,30 @@
 #include <QTimer>
 #include <QAtomicInt>
 #include <QString>
+#include <QStringList>
 #include <QVector>
 #include <QByteArray>
 #include <atomic>
 #include <thread>
 #include <vector>
+#include <functional>
 #include "FieldDef.h"
-
-class UdpWorker; // Forward declaration
+#include "CompiledLayout.h"
+#include "DerivedChannel.h"
+#include "PacketRing.h"
+#include "PacketMemory.h"
 
 class LoggingManager : public QObject {
     Q_OBJECT
 public:
-    LoggingManager(const QList<FieldDef>& fields, int structSize, int durationSec, const QString& filename, UdpWorker* udpWorker, QObject* parent = nullptr);
+    // Where the writer thread pops packets from (a stream's ring); called from that thread only.
+    // Fills up to maxCount packets, which stay valid until the next call, and returns how many.
+    using PacketSource = std::function<int(PacketRing::Packet* out, int maxCount)>;
+    // Adapts a source that hands out one packet per call, each valid until the next
+    static PacketSource onePerCall(std::function<bool(PacketRing::Packet&)> pop);
+    static constexpr int POP_BATCH = 64;
+
+    LoggingManager(const QList<FieldDef>& fields, int structSize, int durationSec, const QString& filename, PacketSource source, QObject* parent = nullptr);
     ~LoggingManager();
 
     // Called from UDP receive thread
@@ -32,6 +43,12 @@ public:
     
     // Binary logging methods
     void enableBinaryMode(bool enable = true) { m_binaryMode = enable; }
+    // How the write buffer is allocated (huge pages, locked, NUMA node); set before start()
+    void setMemoryPolicy(const MemoryPolicy& policy) { m_memoryPolicy = policy; }
+    const MemoryReport& memoryReport() const { return m_writeBuffer.report(); }
+    // Channels written as extra columns after the struct's values, those that compiled; set
+    // before start()
+    void setDerivedChannels(const QList<DerivedChannel>& channels);
     void startBinaryLogging();
     void stopBinaryLogging();
     void convertBinaryToCSV(const QString& binaryFile, const QString& csvFile);
@@ -46,8 +63,14 @@ private:
     void writerThreadFunc();
     void writeCsvHeader();
     void flushBuffer();
+    void appendToWriteBuffer(QFile& file, const char* data, size_t size);
+    void flushWriteBuffer(QFile& file);
+    // The derived channels of a packet's structs, then one struct's as ",value" text
+    void decodeDerived(const char* data, size_t size);
+    size_t formatDerived(size_t row, char* out) const;
 
     QList<FieldDef> m_fields;
+    CompiledLayout m_layout; // Field offsets and types, for formatting CSV rows without allocating
     int m_structSize;
     int m_durationSec;
     QString m_filename;
@@ -57,17 +80,33 @@ private:
     QAtomicInt m_bytesWritten;
     QTimer* m_timer;
 
-    UdpWorker* m_udpWorker = nullptr;
+    PacketSource m_source;
+
+    // Records are gathered here and written in large blocks; allocated by start()
+    static constexpr size_t WRITE_BUFFER_SIZE = PacketMemory::HUGE_PAGE_SIZE;
+    MemoryPolicy m_memoryPolicy;
+    PacketMemory m_writeBuffer;
+    size_t m_writeUsed = 0;
+    // One CSV row, formatted in place: sized for the longest the layout can produce
+    static constexpr size_t STAMP_CHARS = 20;
+    std::vector<char> m_csvRow;
+    // Derived channels: a plan computing them a packet at a time, and their columns in it
+    QStringList m_derivedNames;
+    ExtractionPlan m_derivedPlan;
+    std::vector<int> m_derivedColumns;
+    ColumnBuffers m_derivedValues;
     
     // Binary logging members
     QFile m_binaryFile;
     bool m_binaryMode = false;
+    // Followed by packetCount records of: int64 receive timestamp (ns since the epoch),
+    // uint64 payload size, payload bytes. Version 1 files stamped records in milliseconds.
     struct BinaryHeader {
         uint32_t magic = 0x12345678;
-        uint32_t version = 1;
+        uint32_t version = 2;
         uint32_t structSize;
         uint32_t fieldCount;
-        uint64_t startTimestamp;
+        uint64_t startTimestamp; // ns since the epoch (ms in version 1)
         uint64_t packetCount = 0;
     } m_binaryHeader;
 };
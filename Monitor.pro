@@ -15,8 +15,19 @@ SOURCES += \
         mainwindow.cpp \
         CommandEditDialog.cpp \
         CustomCommandDialog.cpp \
+        StreamDialog.cpp \
         LoggingManager.cpp \
-        FieldExtract.cpp \
+        DecodeKernels.cpp \
+        ExtractionPlan.cpp \
+        CompiledLayout.cpp \
+        ChannelProgram.cpp \
+        CStructParser.cpp \
+        DerivedChannel.cpp \
+        DecoderPlugin.cpp \
+        PacketMemory.cpp \
+        PacketRing.cpp \
+        SequenceTracker.cpp \
+        SpillFile.cpp \
         UdpWorker.cpp
 
 HEADERS += \
@@ -24,6 +35,22 @@ HEADERS += \
         CustomCommandDialog.h \
         LoggingManager.h \
         CommandEditDialog.h \
+        StreamDialog.h \
+        StreamConfig.h \
+        CompiledLayout.h \
+        ChannelProgram.h \
+        CStructParser.h \
+        DecodeKernels.h \
+        DecoderPlugin.h \
+        DecoderPluginApi.h \
+        DerivedChannel.h \
+        ExtractionPlan.h \
+        PacketMemory.h \
+        PacketRing.h \
+        CaptureStats.h \
+        SequenceTracker.h \
+        SpillFile.h \
+        SpscRing.h \
         UdpWorker.h
 
 FORMS += \
@@ -34,6 +61,20 @@ qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
+# Native receive engine (recvmmsg, busy-poll/epoll receive thread) is Linux only
+linux {
+    SOURCES += ReceiveEngine.cpp \
+        ReceiveScheduler.cpp \
+        CaptureBackend.cpp \
+        PacketMmapBackend.cpp \
+        XdpBackend.cpp
+    HEADERS += ReceiveEngine.h \
+        ReceiveScheduler.h \
+        CaptureBackend.h \
+        PacketMmapBackend.h \
+        XdpBackend.h
+}
+
 # Add Winsock library for Windows
 win32 {
     LIBS += -lws2_32
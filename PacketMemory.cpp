@@ -0,0 +1,200 @@
+#include "PacketMemory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <linux/mempolicy.h>
+#endif
+
+namespace {
+
+constexpr int MAX_NUMA_NODES = 1024;
+
+size_t alignUp(size_t n, size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+void addProblem(std::string& problems, const std::string& text) {
+    if (!problems.empty()) problems += "; ";
+    problems += text;
+}
+
+#ifdef __linux__
+// AnonHugePages of the mapping that contains `address`, from /proc/self/smaps
+size_t transparentHugeBytes(const void* address) {
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inMapping = false;
+    while (std::getline(smaps, line)) {
+        unsigned long start, end;
+        if (sscanf(line.c_str(), "%lx-%lx ", &start, &end) == 2) {
+            inMapping = start <= reinterpret_cast<unsigned long>(address) && reinterpret_cast<unsigned long>(address) < end;
+            continue;
+        }
+        size_t kb;
+        if (inMapping && sscanf(line.c_str(), "AnonHugePages: %zu kB", &kb) == 1) return kb * 1024;
+    }
+    return 0;
+}
+#endif
+
+} // namespace
+
+std::string MemoryReport::describe() const {
+    std::ostringstream text;
+    text << (bytes >> 20) << " MB: ";
+    switch (pages) {
+    case Heap: text << "heap"; break;
+    case SmallPages: text << "4 KB pages"; break;
+    case HugeTlbPages: text << "hugetlb pages"; break;
+    case TransparentHugePages:
+        text << "transparent huge pages";
+        if (prefaulted) text << " (" << (hugeBytes >> 20) << " MB backed)";
+        else text << " (madvised, backed as faulted in)";
+        break;
+    }
+    if (locked) text << ", locked";
+    else if (prefaulted) text << ", prefaulted";
+    if (node >= 0) text << ", node " << node;
+    if (!problems.empty()) text << " [" << problems << "]";
+    return text.str();
+}
+
+PacketMemory::PacketMemory(size_t bytes, const MemoryPolicy& policy) {
+    info.bytes = bytes;
+#ifdef __linux__
+    if ((policy.hugePages || policy.lock || policy.numaNode >= 0) && map(bytes, policy)) return;
+#else
+    if (policy.hugePages || policy.lock || policy.numaNode >= 0) info.problems = "memory options need Linux";
+#endif
+    // Default-initialised on purpose: pages are only committed as they are first used
+    heap.reset(new char[bytes]);
+    base = heap.get();
+}
+
+PacketMemory::~PacketMemory() {
+    release();
+}
+
+PacketMemory::PacketMemory(PacketMemory&& other) noexcept {
+    *this = std::move(other);
+}
+
+PacketMemory& PacketMemory::operator=(PacketMemory&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    base = other.base;
+    heap = std::move(other.heap);
+    mappedBytes = other.mappedBytes;
+    info = std::move(other.info);
+    other.base = nullptr;
+    other.mappedBytes = 0;
+    return *this;
+}
+
+void PacketMemory::release() {
+#ifdef __linux__
+    if (mappedBytes) munmap(base, mappedBytes); // Also unlocks
+#endif
+    heap.reset();
+    base = nullptr;
+    mappedBytes = 0;
+}
+
+#ifdef __linux__
+bool PacketMemory::map(size_t bytes, const MemoryPolicy& policy) {
+    size_t length = policy.hugePages ? alignUp(bytes, HUGE_PAGE_SIZE) : bytes;
+    void* address = MAP_FAILED;
+    if (policy.hugePages) {
+        // Needs pages reserved in vm.nr_hugepages; fall back to transparent huge pages
+        address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (address != MAP_FAILED) {
+            info.pages = MemoryReport::HugeTlbPages;
+            info.hugeBytes = length;
+        } else {
+            addProblem(info.problems, std::string("no hugetlb pages: ") + strerror(errno));
+        }
+    }
+    if (address == MAP_FAILED) {
+        address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) {
+            addProblem(info.problems, std::string("mmap failed: ") + strerror(errno));
+            return false;
+        }
+        info.pages = MemoryReport::SmallPages;
+        if (policy.hugePages) {
+            if (madvise(address, length, MADV_HUGEPAGE) == 0) info.pages = MemoryReport::TransparentHugePages;
+            else addProblem(info.problems, std::string("MADV_HUGEPAGE: ") + strerror(errno));
+        }
+    }
+    base = static_cast<char*>(address);
+    mappedBytes = length;
+
+    // The policy has to be in place before the pages are first touched
+    bool bound = false;
+    if (policy.numaNode >= 0 && policy.numaNode < MAX_NUMA_NODES) {
+        unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+        mask[policy.numaNode / (8 * sizeof(unsigned long))] |= 1UL << (policy.numaNode % (8 * sizeof(unsigned long)));
+        if (syscall(SYS_mbind, base, length, MPOL_BIND, mask, MAX_NUMA_NODES, 0) != 0) {
+            addProblem(info.problems, std::string("mbind: ") + strerror(errno));
+        } else {
+            bound = true;
+        }
+    }
+
+    if (policy.lock) {
+        long pageSize = sysconf(_SC_PAGESIZE);
+        for (size_t offset = 0; offset < length; offset += pageSize) base[offset] = 0;
+        info.prefaulted = true;
+        if (mlock(base, length) == 0) info.locked = true;
+        else addProblem(info.problems, std::string("mlock: ") + strerror(errno) + " (raise RLIMIT_MEMLOCK)");
+
+        int node = -1;
+        if (syscall(SYS_get_mempolicy, &node, nullptr, 0, base, MPOL_F_NODE | MPOL_F_ADDR) == 0) info.node = node;
+        if (info.pages == MemoryReport::TransparentHugePages) info.hugeBytes = std::min(length, transparentHugeBytes(base));
+    } else if (bound) {
+        info.node = policy.numaNode; // Bound, but only placed as pages are first used
+    }
+    return true;
+}
+#endif
+
+int numaNodeOfCpu(int cpu) {
+#ifdef __linux__
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return -1;
+    int node = -1;
+    while (dirent* entry = readdir(dir)) {
+        if (sscanf(entry->d_name, "node%d", &node) == 1) break;
+        node = -1;
+    }
+    closedir(dir);
+    return node;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+bool numaNodeCpus(int node, std::vector<int>& cpus) {
+    cpus.clear();
+    // cpulist is a comma-separated list of ranges, e.g. "0-7,16-23"
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string range;
+    while (std::getline(file, range, ',')) {
+        int first, last;
+        int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (fields < 1) continue;
+        if (fields == 1) last = first;
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return !cpus.empty();
+}
@@ -0,0 +1,65 @@
+#ifndef PACKETMEMORY_H
+#define PACKETMEMORY_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How packet memory (rings, logger write buffers) is allocated. The defaults give plain
+// heap memory that is committed lazily; the options only take effect on Linux.
+struct MemoryPolicy {
+    bool hugePages = false; // hugetlbfs pages (MAP_HUGETLB), else transparent huge pages via madvise
+    bool lock = false;      // Prefault and mlock, so the first fill at full rate takes no page faults
+    int numaNode = -1;      // Bind to this node (mbind MPOL_BIND); -1 leaves placement to the kernel
+};
+
+// What an allocation actually got, which may be less than the policy asked for
+struct MemoryReport {
+    enum Pages { Heap, SmallPages, HugeTlbPages, TransparentHugePages };
+    size_t bytes = 0;
+    Pages pages = Heap;
+    size_t hugeBytes = 0;  // Backed by huge pages, as far as the kernel reports it
+    bool prefaulted = false;
+    bool locked = false;
+    int node = -1;         // Node of the first page once faulted in, -1 if unknown
+    std::string problems;  // Why a requested option was not obtained
+
+    // One line, e.g. "256 MB: hugetlb pages, locked, node 0"
+    std::string describe() const;
+};
+
+// A block of packet memory allocated according to a MemoryPolicy, released on destruction
+class PacketMemory {
+public:
+    PacketMemory() = default;
+    PacketMemory(size_t bytes, const MemoryPolicy& policy);
+    ~PacketMemory();
+    PacketMemory(PacketMemory&& other) noexcept;
+    PacketMemory& operator=(PacketMemory&& other) noexcept;
+    PacketMemory(const PacketMemory&) = delete;
+    PacketMemory& operator=(const PacketMemory&) = delete;
+
+    char* data() const { return base; }
+    size_t size() const { return info.bytes; }
+    const MemoryReport& report() const { return info; }
+
+    static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20; // Default huge page size on x86-64 and arm64
+
+private:
+    void release();
+#ifdef __linux__
+    bool map(size_t bytes, const MemoryPolicy& policy);
+#endif
+
+    char* base = nullptr;
+    std::unique_ptr<char[]> heap; // Default policy
+    size_t mappedBytes = 0;       // mmap length, 0 when on the heap
+    MemoryReport info;
+};
+
+// NUMA topology, from sysfs. Both return -1 / false where there is no NUMA information.
+int numaNodeOfCpu(int cpu);
+bool numaNodeCpus(int node, std::vector<int>& cpus);
+
+#endif // PACKETMEMORY_H
@@ -0,0 +1,203 @@
+#include "PacketMmapBackend.h"
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING 23
+#endif
+
+PacketMmapBackend::PacketMmapBackend(PacketRing& ring, CaptureStats& stats) : CaptureBackend(ring, stats) {
+    datagrams.resize(BATCH_SIZE);
+    heldBlocks.resize(BLOCK_COUNT);
+}
+
+PacketMmapBackend::~PacketMmapBackend() {
+    close();
+}
+
+bool PacketMmapBackend::open(const CaptureConfig& config, std::string& error) {
+    if (sockFd >= 0) return true;
+    port = config.port;
+    // Protocol 0 receives nothing until bind(), so no unfiltered packets slip in during setup
+    sockFd = ::socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sockFd < 0) {
+        error = std::string("Failed to create AF_PACKET socket (needs root): ") + strerror(errno);
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(sockFd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+        error = std::string("TPACKET_V3 not supported: ") + strerror(errno);
+        close();
+        return false;
+    }
+
+    // Kernel-side filter, offsets from the IPv4 header: unfragmented UDP to our port
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                  // IP protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                  // Flags and fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3fff, 4, 0),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                 // X = IP header length
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                  // UDP destination port
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0x40000),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    sock_fprog filter = {static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code};
+    if (setsockopt(sockFd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) != 0) {
+        error = std::string("Failed to attach the port filter: ") + strerror(errno);
+        close();
+        return false;
+    }
+    // Loopback shows every packet twice otherwise; older kernels are handled in receiveBatch()
+    int one = 1;
+    setsockopt(sockFd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one));
+
+    tpacket_req3 req{};
+    req.tp_block_size = BLOCK_SIZE;
+    req.tp_block_nr = BLOCK_COUNT;
+    req.tp_frame_size = FRAME_SIZE;
+    req.tp_frame_nr = BLOCK_SIZE / FRAME_SIZE * BLOCK_COUNT;
+    req.tp_retire_blk_tov = BLOCK_TIMEOUT_MS;
+    if (setsockopt(sockFd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+        error = std::string("Failed to set up the packet ring: ") + strerror(errno);
+        close();
+        return false;
+    }
+    mapSize = static_cast<size_t>(BLOCK_SIZE) * BLOCK_COUNT;
+    void* mapped = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, sockFd, 0);
+    if (mapped == MAP_FAILED) {
+        error = std::string("Failed to map the packet ring: ") + strerror(errno);
+        close();
+        return false;
+    }
+    map = static_cast<uint8_t*>(mapped);
+    currentBlock = 0;
+
+    sockaddr_ll addr{};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    if (!config.interfaceName.empty()) {
+        addr.sll_ifindex = if_nametoindex(config.interfaceName.c_str());
+        if (addr.sll_ifindex == 0) {
+            error = "Unknown interface " + config.interfaceName;
+            close();
+            return false;
+        }
+    }
+    if (::bind(sockFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = std::string("Failed to bind AF_PACKET socket: ") + strerror(errno);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void PacketMmapBackend::close() {
+    releaseAll();
+    if (map) {
+        munmap(map, mapSize);
+        map = nullptr;
+    }
+    if (sockFd >= 0) {
+        ::close(sockFd);
+        sockFd = -1;
+    }
+}
+
+bool PacketMmapBackend::blockReady(unsigned index) const {
+    if (heldBlocks[index]) return false; // The kernel has wrapped around to a block we still hold
+    return __atomic_load_n(&blockAt(index)->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER;
+}
+
+void PacketMmapBackend::releaseBuffer(uint64_t block) {
+    heldBlocks[block] = false;
+    if (map) __atomic_store_n(&blockAt(block)->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+}
+
+void PacketMmapBackend::publish(int count, bool zeroCopy) {
+    if (count == 0) return;
+    if (batchHandler) batchHandler(datagrams.data(), count);
+    for (int k = 0; k < count; ++k) {
+        const Datagram& d = datagrams[k];
+        bool pushed;
+        if (zeroCopy) {
+            pushed = ring.pushExternal(d.data, d.size, d.timestampNs, d.source);
+        } else if (d.size > ring.maxPacketSize()) {
+            stats.truncated.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        } else {
+            pushed = ring.push(d.data, d.size, d.timestampNs, d.source);
+        }
+        if (!pushed) stats.ringDrops.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+int PacketMmapBackend::receiveBatch(bool& drained) {
+    releaseConsumed();
+    if (!blockReady(currentBlock)) {
+        drained = true;
+        return 0;
+    }
+
+    // Lend the block to the ring only while the consumer keeps up: it is attached, its backlog
+    // is small and at most half the blocks are waiting on it
+    bool zeroCopy = ring.hasConsumer() && ring.usedBytes() < ring.capacityBytes() / 4 && heldCount() < BLOCK_COUNT / 2;
+    uint64_t publishedBefore = ring.published();
+    tpacket_block_desc* block = blockAt(currentBlock);
+    uint8_t* next = reinterpret_cast<uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt;
+    int count = 0;
+    int received = 0;
+    int64_t newestNs = 0;
+    for (unsigned i = 0; i < block->hdr.bh1.num_pkts; ++i) {
+        auto* pkt = reinterpret_cast<tpacket3_hdr*>(next);
+        next += pkt->tp_next_offset;
+        auto* ll = reinterpret_cast<sockaddr_ll*>(reinterpret_cast<uint8_t*>(pkt) + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+        if (ll->sll_pkttype == PACKET_OUTGOING) continue;
+        received++;
+        if (pkt->tp_snaplen < pkt->tp_len) {
+            stats.truncated.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        size_t length = pkt->tp_snaplen;
+        const uint8_t* payload;
+        uint64_t source;
+        if (!udpPayload(reinterpret_cast<uint8_t*>(pkt) + pkt->tp_net, length, port, payload, &source)) continue;
+        newestNs = static_cast<int64_t>(pkt->tp_sec) * 1000000000LL + pkt->tp_nsec;
+        datagrams[count++] = {const_cast<char*>(reinterpret_cast<const char*>(payload)), length, newestNs, source};
+        if (count == BATCH_SIZE) {
+            publish(count, zeroCopy);
+            count = 0;
+        }
+    }
+    publish(count, zeroCopy);
+    if (newestNs > 0) {
+        int64_t nowNs = realtimeNs();
+        if (nowNs >= newestNs) stats.latency.record(nowNs - newestNs);
+    }
+
+    if (zeroCopy && ring.published() != publishedBefore) {
+        heldBlocks[currentBlock] = true;
+        holdUntilConsumed(currentBlock);
+        releaseConsumed();
+    } else {
+        releaseBuffer(currentBlock);
+    }
+    currentBlock = (currentBlock + 1) % BLOCK_COUNT;
+    drained = !blockReady(currentBlock);
+
+    // Packets the kernel could not fit in the block ring (the counters reset on every read)
+    tpacket_stats_v3 ringStats{};
+    socklen_t statsLength = sizeof(ringStats);
+    if (getsockopt(sockFd, SOL_PACKET, PACKET_STATISTICS, &ringStats, &statsLength) == 0 && ringStats.tp_drops > 0) {
+        stats.kernelDrops.fetch_add(ringStats.tp_drops, std::memory_order_relaxed);
+    }
+    return received;
+}
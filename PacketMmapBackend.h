@@ -0,0 +1,49 @@
+#ifndef PACKETMMAPBACKEND_H
+#define PACKETMMAPBACKEND_H
+
+#include "CaptureBackend.h"
+#include <linux/if_packet.h>
+
+// AF_PACKET TPACKET_V3 capture: the kernel writes filtered packets into a block ring that
+// is mapped into our address space, so there is no per-packet syscall or copy to user space.
+// Payload pointers go to the parser and into PacketRing as-is; each block is handed back to
+// the kernel once the ring consumer has popped its packets. The kernel fills blocks in order,
+// so a lent block that is still unconsumed when the kernel wraps around to it stalls capture;
+// blocks are therefore only lent while the consumer keeps up, and copied into ring slots
+// otherwise. The kernel still delivers the packets to the UDP stack as usual. Needs CAP_NET_RAW.
+class PacketMmapBackend : public CaptureBackend {
+public:
+    static constexpr unsigned BLOCK_SIZE = 1 << 20;
+    static constexpr unsigned BLOCK_COUNT = 256;
+    static constexpr unsigned FRAME_SIZE = 2048;     // Only sizes tp_frame_nr; V3 packs packets tightly
+    static constexpr unsigned BLOCK_TIMEOUT_MS = 1;  // Partially filled blocks are handed over after this
+
+    PacketMmapBackend(PacketRing& ring, CaptureStats& stats);
+    ~PacketMmapBackend() override;
+
+    bool open(const CaptureConfig& config, std::string& error) override;
+    void close() override;
+    int fd() const override { return sockFd; }
+    int receiveBatch(bool& drained) override;
+    bool lendsBuffers() const override { return true; }
+
+protected:
+    void releaseBuffer(uint64_t block) override;
+
+private:
+    tpacket_block_desc* blockAt(unsigned index) const {
+        return reinterpret_cast<tpacket_block_desc*>(map + static_cast<size_t>(index) * BLOCK_SIZE);
+    }
+    bool blockReady(unsigned index) const;
+    void publish(int count, bool zeroCopy);
+
+    int sockFd = -1;
+    uint8_t* map = nullptr;
+    size_t mapSize = 0;
+    unsigned currentBlock = 0;
+    std::vector<bool> heldBlocks; // Lent to the ring: still TP_STATUS_USER, but already processed
+    uint16_t port = 0;
+    std::vector<Datagram> datagrams;
+};
+
+#endif // PACKETMMAPBACKEND_H
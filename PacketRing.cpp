@@ -0,0 +1,476 @@
+#include "PacketRing.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+PacketRing::PacketRing(size_t capacityBytes, size_t maxPacketSize, const MemoryPolicy& policy)
+    : arenaBytes(std::max(alignUp(capacityBytes), 4 * alignUp(HEADER_SIZE + maxPacketSize))),
+      maxPayload(maxPacketSize),
+      arena(arenaBytes, policy),
+      readers(new Reader[MAX_READERS]),
+      regionPayload(std::min(DEFAULT_RESERVE_SIZE, maxPacketSize)) {
+    for (int i = 0; i < MAX_READERS; ++i) readers[i].ring = this;
+}
+
+PacketRing::~PacketRing() = default;
+
+void PacketRing::growReserveSize(size_t size) {
+    regionPayload = std::min(maxPayload, std::max(regionPayload, alignUp(size)));
+}
+
+uint64_t PacketRing::requiredTail() const {
+    uint64_t least = std::numeric_limits<uint64_t>::max();
+    uint32_t mask = requiredMask.load(std::memory_order_acquire);
+    for (int i = 0; mask; ++i, mask >>= 1) {
+        if (mask & 1) least = std::min(least, readers[i].tail.load(std::memory_order_acquire));
+    }
+    return least;
+}
+
+uint64_t PacketRing::writeLimit() const {
+    // Up to a lap ahead of the slowest required reader. With none, only idleLead() ahead of
+    // what was written last, so a reader attaching meanwhile finds the rest of the lap intact.
+    // Either stays valid while the readers move on, or while one attaches.
+    return hasConsumer() ? requiredTail() + arenaBytes : writePos + idleLead();
+}
+
+uint64_t PacketRing::refreshLimit() {
+    // Cached no further than idleLead() ahead either: a reader that left may have allowed a
+    // whole lap, and one attaching in the past needs to know how far the producer can go
+    // before it looks again
+    // Pairs with startReader(): either the readers' mask read here has the new reader, or
+    // the reader sees the head as of now
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t limit = writeLimit();
+    cachedLimit = std::min(limit, writePos + idleLead());
+    return limit;
+}
+
+int PacketRing::reserveRegions(size_t stride, int maxCount, bool wait) {
+    uint64_t start = writePos;
+    uint64_t offset = start % arenaBytes;
+    if (offset + stride > arenaBytes) start += arenaBytes - offset; // Continue on the next lap
+    uint64_t fitLap = (arenaBytes - start % arenaBytes) / stride;
+    uint64_t wanted = std::min<uint64_t>(static_cast<uint64_t>(maxCount), fitLap);
+    uint64_t fitFree = start + stride <= cachedLimit ? (cachedLimit - start) / stride : 0;
+    if (fitFree < wanted) {
+        // Only now look at the readers' cursors, and their cache lines
+        int mode = overflowMode.load(std::memory_order_relaxed);
+        uint64_t limit = refreshLimit();
+        fitFree = start + stride <= cachedLimit ? (cachedLimit - start) / stride : 0;
+        // Drop oldest acts from 3/4 full, so that the readers have made room before it is
+        // needed; the limit is refreshed at least every idleLead(), well before that
+        if (mode == DropOldest && hasConsumer() && start + stride + arenaBytes / 4 > limit) requestTrim(start);
+        if (fitFree == 0 && wait && mode == Block && !blockExpired && hasConsumer() && waitForRoom(start + stride)) {
+            fitFree = (cachedLimit - start) / stride;
+        }
+    }
+    if (fitFree > 0) blockExpired = false;
+    reserveBase = start;
+    reserveStride = stride;
+    reserveCount = static_cast<int>(std::min(wanted, fitFree));
+
+    // Tell optional readers what is about to be overwritten before anything is written
+    uint64_t reach = start + reserveCount * stride;
+    if (reserveCount > 0 && reach > arenaBytes + overwritten.load(std::memory_order_relaxed)) {
+        uint64_t gone = reach - arenaBytes;
+        // Follow the old records' headers past it while they are still there. The end of the
+        // current lap is not written yet, but the records continue at writePos.
+        uint64_t oldest = historyStart.load(std::memory_order_relaxed);
+        while (oldest < gone && oldest < writePos) oldest += headerAt(oldest)->span;
+        overwritten.store(gone, std::memory_order_relaxed);
+        historyStart.store(oldest, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    return reserveCount;
+}
+
+bool PacketRing::waitForRoom(uint64_t end) {
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::microseconds(blockTimeoutUs.load(std::memory_order_relaxed));
+    bool room = false;
+    while (!room && hasConsumer() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+        refreshLimit();
+        room = end <= cachedLimit;
+    }
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+    overflow.blocked.fetch_add(1, std::memory_order_relaxed);
+    overflow.blockedNs.fetch_add(static_cast<uint64_t>(waited.count()), std::memory_order_relaxed);
+    if (!room && hasConsumer()) {
+        overflow.blockTimeouts.fetch_add(1, std::memory_order_relaxed);
+        blockExpired = true;
+        return false;
+    }
+    refreshLimit(); // The reader may have gone meanwhile
+    return end <= cachedLimit;
+}
+
+void PacketRing::requestTrim(uint64_t start) {
+    // Keep the newest half of the arena; the readers drop the rest on their next pop
+    if (start <= arenaBytes / 2) return;
+    uint64_t target = start - arenaBytes / 2;
+    if (target > trimTo.load(std::memory_order_relaxed)) trimTo.store(target, std::memory_order_release);
+}
+
+void PacketRing::setOverflowPolicy(Overflow policy, int timeoutUs, const std::string& directory) {
+    {
+        std::lock_guard<std::mutex> lock(spillDirectoryMutex);
+        spillDirectory = directory;
+    }
+    blockTimeoutUs.store(std::max(0, timeoutUs), std::memory_order_relaxed);
+    overflowMode.store(policy, std::memory_order_relaxed);
+}
+
+bool PacketRing::spillPacket(const char* data, size_t size, int64_t timestampNs, uint64_t source) {
+    if (overflowMode.load(std::memory_order_relaxed) != Spill && !spillPending()) return false;
+    if (!spillFile) {
+        std::lock_guard<std::mutex> lock(spillDirectoryMutex);
+        spillFile = std::make_unique<SpillFile>(spillDirectory, SPILL_LIMIT_BYTES);
+    }
+    if (!spillFile->append(data, size, timestampNs, source)) {
+        overflow.spillFailures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    overflow.spilled.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool PacketRing::restoreSpilled() {
+    if (!spillPending()) return true;
+    size_t size;
+    int64_t timestampNs;
+    uint64_t source;
+    while (spillFile->peek(size, timestampNs, source)) {
+        if (size > maxPayload || reserveRegions(alignUp(HEADER_SIZE + size), 1, false) == 0) return false;
+        if (!spillFile->read(arena.data() + reserveBase % arenaBytes + HEADER_SIZE)) break;
+        commit(0, size, timestampNs, source);
+        overflow.restored.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (spillFile->empty()) return true;
+    // Unreadable: what is left is lost
+    overflow.spillFailures.fetch_add(overflow.spilled.load(std::memory_order_relaxed) - overflow.restored.load(std::memory_order_relaxed),
+                                     std::memory_order_relaxed);
+    overflow.spilled.store(overflow.restored.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    spillFile->discard();
+    return true;
+}
+
+int PacketRing::reserve(char** out, int maxCount) {
+    if (!restoreSpilled()) return 0; // Spilled packets go first
+    int n = reserveRegions(alignUp(HEADER_SIZE + regionPayload), maxCount);
+    for (int i = 0; i < n; ++i) {
+        out[i] = arena.data() + (reserveBase + i * reserveStride) % arenaBytes + HEADER_SIZE;
+    }
+    return n;
+}
+
+char* PacketRing::reserve(size_t size) {
+    if (!restoreSpilled()) return nullptr;
+    if (size > maxPayload || reserveRegions(alignUp(HEADER_SIZE + size), 1) == 0) return nullptr;
+    return arena.data() + reserveBase % arenaBytes + HEADER_SIZE;
+}
+
+void PacketRing::commit(int index, size_t size, int64_t timestampNs, uint64_t source) {
+    uint64_t position = reserveBase + static_cast<uint64_t>(index) * reserveStride;
+    padUpTo(position);
+    RecordHeader* header = headerAt(position);
+    header->span = static_cast<uint32_t>(alignUp(HEADER_SIZE + size));
+    header->kind = Data;
+    header->size = static_cast<uint32_t>(size);
+    header->timestampNs = timestampNs;
+    header->source = source;
+    publish(header, position + header->span);
+}
+
+bool PacketRing::pushExternal(char* data, size_t size, int64_t timestampNs, uint64_t source) {
+    if (!restoreSpilled() || reserveRegions(alignUp(HEADER_SIZE + sizeof(char*)), 1) == 0) {
+        return size <= maxPayload && spillPacket(data, size, timestampNs, source); // Copied, not lent
+    }
+    padUpTo(reserveBase);
+    RecordHeader* header = headerAt(reserveBase);
+    header->span = static_cast<uint32_t>(reserveStride);
+    header->kind = External;
+    header->size = static_cast<uint32_t>(size);
+    header->timestampNs = timestampNs;
+    header->source = source;
+    memcpy(header + 1, &data, sizeof(data));
+    externalEnd.store(reserveBase + reserveStride, std::memory_order_relaxed);
+    publish(header, reserveBase + reserveStride);
+    return true;
+}
+
+void PacketRing::padUpTo(uint64_t position) {
+    // Skipped regions, and the end of a lap that was too short, become padding records
+    while (writePos < position) {
+        uint64_t lapEnd = writePos - writePos % arenaBytes + arenaBytes;
+        uint64_t end = std::min(position, lapEnd);
+        RecordHeader* pad = headerAt(writePos);
+        pad->span = static_cast<uint32_t>(end - writePos);
+        pad->kind = Padding;
+        writePos = end;
+    }
+}
+
+void PacketRing::publish(RecordHeader* header, uint64_t end) {
+    uint64_t count = publishCount.load(std::memory_order_relaxed);
+    header->sequence = static_cast<uint32_t>(count);
+    writePos = end;
+    // Head first: whoever sees the new count also sees the packet (see attachReader)
+    head.store(end, std::memory_order_release);
+    publishCount.store(count + 1, std::memory_order_release);
+}
+
+uint64_t PacketRing::consumed() const {
+    uint32_t mask = requiredMask.load(std::memory_order_acquire);
+    if (!mask) return published();
+    uint64_t least = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; mask; ++i, mask >>= 1) {
+        if (mask & 1) least = std::min(least, readers[i].released.load(std::memory_order_acquire));
+    }
+    return least;
+}
+
+size_t PacketRing::usedBytes() const {
+    if (!hasConsumer()) return 0;
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t start = requiredTail();
+    return end > start ? static_cast<size_t>(end - start) : 0;
+}
+
+PacketRing::Reader* PacketRing::attachReader(bool required) {
+    // Slot 0 is the primary reader's
+    for (int i = 1; i < MAX_READERS; ++i) {
+        int expected = Reader::Free;
+        Reader& reader = readers[i];
+        if (!reader.state.compare_exchange_strong(expected, required ? Reader::Required : Reader::Optional)) continue;
+        startReader(i, required);
+        return &reader;
+    }
+    return nullptr;
+}
+
+void PacketRing::detachReader(Reader* reader) {
+    if (!reader) return;
+    int slot = static_cast<int>(reader - readers.get());
+    requiredMask.fetch_and(~(1u << slot), std::memory_order_acq_rel);
+    reader->state.store(Reader::Free, std::memory_order_release);
+}
+
+void PacketRing::setConsumerAttached(bool attached, int64_t historyNs, size_t historyBytes) {
+    Reader& primary = readers[0];
+    if (attached == (primary.state.load(std::memory_order_relaxed) != Reader::Free)) return;
+    if (!attached) {
+        detachReader(&primary);
+        return;
+    }
+    primary.state.store(Reader::Required, std::memory_order_release);
+    startReader(0, true, historyNs, historyBytes);
+}
+
+void PacketRing::startReader(int slot, bool required, int64_t historyNs, size_t historyBytes) {
+    Reader& reader = readers[slot];
+    reader.pendingRelease = false;
+    reader.popped = false;
+    reader.cachedHead = 0;
+    reader.skippedCount.store(0, std::memory_order_relaxed);
+    // A required reader holds the producer back from where it is registered, so it may only
+    // move forward from there: to the head read after that, or into the history. The count
+    // is read before the head, so that it never covers a packet after the starting position.
+    bool history = required && historyNs > 0 && historyBytes > 0;
+    uint64_t end = head.load(std::memory_order_acquire);
+    reader.tail.store(history ? std::min(historyStart.load(std::memory_order_acquire), end) : end, std::memory_order_release);
+    uint32_t others = required ? requiredMask.fetch_or(1u << slot, std::memory_order_acq_rel) & ~(1u << slot) : 0;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t count = publishCount.load(std::memory_order_acquire);
+    end = head.load(std::memory_order_acquire);
+    if (!history || others) {
+        // Another required reader may have let the producer go anywhere up to its own tail
+        reader.tail.store(end, std::memory_order_release);
+        reader.released.store(count, std::memory_order_release);
+        return;
+    }
+
+    // Until the producer refreshes its limit and finds this reader, it may overwrite up to a
+    // lap minus idleLead() behind the head. Lent packets may be back with their owner already.
+    uint64_t floor = end - std::min<uint64_t>(end, std::min<uint64_t>(historyBytes, arenaBytes - idleLead()));
+    floor = std::max({floor, externalEnd.load(std::memory_order_acquire), trimTo.load(std::memory_order_acquire)});
+    uint64_t position = historyBoundary(std::min(floor, end), end);
+    // From there on nothing is overwritten any more; skip what is older than asked for
+    int64_t cutoff = wallClockNs() - historyNs;
+    while (position < end) {
+        const RecordHeader* header = headerAt(position);
+        if (header->kind != Padding && header->timestampNs >= cutoff) break;
+        position += header->span;
+    }
+    reader.tail.store(position, std::memory_order_release);
+    if (position < end) {
+        // Widen the first record's 32-bit sequence against a count that is not behind it
+        uint64_t total = publishCount.load(std::memory_order_acquire);
+        count = total - static_cast<uint32_t>(static_cast<uint32_t>(total) - headerAt(position)->sequence);
+    }
+    reader.released.store(count, std::memory_order_release);
+}
+
+uint64_t PacketRing::historyBoundary(uint64_t floor, uint64_t end) const {
+    // Walk the headers from the oldest record, starting over whenever the producer overwrites
+    // the one just read (as optional readers do)
+    uint64_t position = historyStart.load(std::memory_order_acquire);
+    while (position < floor && position < end) {
+        uint32_t span = headerAt(position)->span;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (position < overwritten.load(std::memory_order_relaxed)) {
+            position = historyStart.load(std::memory_order_acquire);
+            continue;
+        }
+        position += span;
+    }
+    return std::min(position, end);
+}
+
+bool PacketRing::pop(Packet& packet) {
+    return readers[0].pop(packet);
+}
+
+int PacketRing::popBatch(Packet* out, int maxCount) {
+    return readers[0].popBatch(out, maxCount);
+}
+
+bool PacketRing::peek(Packet& packet) {
+    return readers[0].peek(packet);
+}
+
+void PacketRing::Reader::releasePending() {
+    if (!pendingRelease) return;
+    pendingRelease = false;
+    tail.store(pendingTail, std::memory_order_release);
+    // Widen the header's 32-bit sequence against the previous count
+    uint64_t done = released.load(std::memory_order_relaxed);
+    released.store(done + static_cast<uint32_t>(pendingSequence + 1 - static_cast<uint32_t>(done)), std::memory_order_release);
+}
+
+bool PacketRing::Reader::readRecord(uint64_t& position, Packet& packet, uint64_t& next, uint32_t& sequence) {
+    bool optional = state.load(std::memory_order_relaxed) == Optional;
+    while (true) {
+        if (optional && position < ring->overwritten.load(std::memory_order_acquire)) {
+            position = cachedHead = ring->head.load(std::memory_order_acquire); // Lapped: skip to the newest packet
+        }
+        if (position >= cachedHead) {
+            cachedHead = ring->head.load(std::memory_order_acquire);
+            if (position >= cachedHead) return false; // Empty
+        }
+
+        // An optional reader's record may be overwritten under it; the copy is only used
+        // once the producer is known not to have reached it
+        RecordHeader header;
+        memcpy(&header, ring->headerAt(position), sizeof(header));
+        size_t offset = position % ring->arenaBytes;
+        char* external = nullptr;
+        if (header.kind == External && offset + HEADER_SIZE + sizeof(external) <= ring->arenaBytes) {
+            memcpy(&external, ring->arena.data() + offset + HEADER_SIZE, sizeof(external));
+        }
+        if (optional) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (position < ring->overwritten.load(std::memory_order_relaxed)) continue;
+        }
+        if (header.kind == Padding) {
+            position += header.span;
+            continue;
+        }
+        packet.size = header.size;
+        packet.timestampNs = header.timestampNs;
+        packet.source = header.source;
+        packet.data = header.kind == External ? external : ring->arena.data() + offset + HEADER_SIZE;
+        next = position + header.span;
+        sequence = header.sequence;
+        if (header.kind == External && !lastExternal) {
+            lastExternal = true;
+            lastSequence = header.sequence;
+        }
+        return true;
+    }
+}
+
+uint64_t PacketRing::Reader::evict(uint64_t position, uint64_t trim) {
+    // The producer has not overwritten these yet (this reader holds it back); just skip them
+    uint64_t end = ring->head.load(std::memory_order_acquire);
+    uint64_t count = 0;
+    while (position < trim && position < end) {
+        const RecordHeader* header = ring->headerAt(position);
+        if (header->kind != Padding) {
+            pendingSequence = header->sequence;
+            count++;
+        }
+        position += header->span;
+    }
+    if (count > 0) {
+        pendingTail = position;
+        pendingRelease = true;
+        releasePending();
+        skippedCount.fetch_add(count, std::memory_order_relaxed);
+        if (this == &ring->readers[0]) ring->overflow.evicted.fetch_add(count, std::memory_order_relaxed);
+    } else {
+        tail.store(position, std::memory_order_release);
+    }
+    return position;
+}
+
+int PacketRing::Reader::popBatch(Packet* out, int maxCount) {
+    if (state.load(std::memory_order_relaxed) == Free) return 0;
+    releasePending();
+    bool optional = state.load(std::memory_order_relaxed) == Optional;
+    lastExternal = false;
+    uint64_t start = tail.load(std::memory_order_relaxed);
+    uint64_t trim = ring->trimTo.load(std::memory_order_acquire);
+    if (!optional && start < trim) start = evict(start, trim);
+    uint64_t position = start;
+    uint64_t next = start;
+    uint32_t sequence = 0;
+    int n = 0;
+    while (n < maxCount && readRecord(position, out[n], next, sequence)) {
+        if (n == 0) lastPosition = position;
+        if (optional && popped) {
+            skippedCount.fetch_add(static_cast<uint32_t>(sequence - poppedSequence - 1), std::memory_order_relaxed);
+        }
+        popped = true;
+        poppedSequence = sequence;
+        position = next;
+        ++n;
+    }
+    if (n == 0) {
+        if (position != start) tail.store(position, std::memory_order_release); // Past padding, or lapped
+        return 0;
+    }
+    pendingTail = next;
+    pendingSequence = sequence;
+    pendingRelease = true;
+    return n;
+}
+
+bool PacketRing::Reader::pop(Packet& packet) {
+    return popBatch(&packet, 1) == 1;
+}
+
+bool PacketRing::Reader::peek(Packet& packet) {
+    if (state.load(std::memory_order_relaxed) == Free) return false;
+    releasePending();
+    lastExternal = false;
+    uint64_t position = tail.load(std::memory_order_relaxed);
+    uint64_t trim = ring->trimTo.load(std::memory_order_acquire);
+    if (state.load(std::memory_order_relaxed) == Required && position < trim) position = evict(position, trim);
+    uint64_t next;
+    uint32_t sequence;
+    bool found = readRecord(position, packet, next, sequence);
+    tail.store(position, std::memory_order_release);
+    if (found) lastPosition = position;
+    return found;
+}
+
+bool PacketRing::Reader::intact() const {
+    if (state.load(std::memory_order_relaxed) != Optional) return true;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (lastPosition < ring->overwritten.load(std::memory_order_relaxed)) return false;
+    // Lent memory goes back to the capture backend once the required readers are past it
+    if (lastExternal && static_cast<int32_t>(static_cast<uint32_t>(ring->consumed()) - lastSequence - 1) >= 0) return false;
+    return true;
+}
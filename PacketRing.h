@@ -0,0 +1,286 @@
+#ifndef PACKETRING_H
+#define PACKETRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "PacketMemory.h"
+#include "SpillFile.h"
+
+// Wall-clock nanoseconds since the epoch: the timebase of Packet::timestampNs
+// (CLOCK_REALTIME on Linux, which is also what kernel receive timestamps use)
+inline int64_t wallClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Identifies a sender: IPv4 address (host order) and UDP port
+inline uint64_t sourceId(uint32_t address, uint16_t port) {
+    return (static_cast<uint64_t>(address) << 16) | port;
+}
+
+// Lock-free single-producer, multi-reader ring of variable-length packet records in
+// one contiguous byte arena. Each record is a 32-byte header followed by the payload,
+// rounded up to RECORD_ALIGN, so memory use follows the actual datagram sizes. A record
+// never wraps: whatever does not fit before the end of the arena is skipped with a
+// padding record. By default the arena is not touched until used, so a large capacity
+// costs no startup time; a MemoryPolicy can instead ask for huge pages, prefaulted and
+// locked memory on the receive thread's NUMA node.
+//
+// The producer can either copy a packet in with push(), or receive straight into the
+// arena: reserve() hands out regions for the next records, the socket read targets them,
+// and commit() publishes each one. Each payload is then written once, by the kernel.
+// Capture backends with kernel-shared buffers use pushExternal() instead, which records
+// only the pointer, and keep that memory valid until consumed().
+//
+// Each consumer reads through its own Reader cursor, straight from the arena. Required
+// readers (the logger) hold the producer back: the ring is full when it catches up with
+// the slowest one. Optional readers (forwarding, analysis) never do; one that falls a lap
+// behind skips to the newest packet, and checks intact() after using a packet, since the
+// producer may have overwritten it meanwhile. With no required reader the producer never
+// finds the ring full.
+//
+// What happens when it does is the overflow policy, see Overflow.
+//
+// Until the producer laps them, records stay in the arena after they are consumed (or
+// when nobody reads them). The primary reader can attach that far in the past, which
+// gives retroactive capture without copying anything on the receive path.
+class PacketRing {
+public:
+    struct Packet {
+        char* data = nullptr;
+        size_t size = 0;
+        int64_t timestampNs = 0; // Arrival time, see wallClockNs()
+        uint64_t source = 0;     // Sender, see sourceId(); 0 where unknown
+    };
+
+    static constexpr size_t RECORD_ALIGN = 32;
+    static constexpr size_t HEADER_SIZE = 32;
+    static constexpr size_t DEFAULT_RESERVE_SIZE = 2048; // Batch regions until a larger datagram shows up
+    static constexpr int MAX_READERS = 8;
+    static constexpr size_t CACHE_LINE = 64;
+
+    // What the producer does when the slowest required reader has not left room
+    enum Overflow {
+        DropNewest = 0, // Refuse the new packet
+        DropOldest = 1, // Keep the newest: from 3/4 full, required readers skip ahead to the newest half
+        Block = 2,      // Wait for room, up to a timeout, then refuse the packet (until room is back)
+        Spill = 3       // Append it to a spill file, read back into the ring in order as room frees up
+    };
+    static constexpr int DEFAULT_BLOCK_TIMEOUT_US = 10000;
+    static constexpr uint64_t SPILL_LIMIT_BYTES = uint64_t(16) << 30;
+
+    // Per-policy totals since construction. Written by the producer, except `evicted`,
+    // counted by the primary reader as it skips.
+    struct OverflowStats {
+        std::atomic<uint64_t> evicted{0};       // Drop oldest: queued packets dropped to make room
+        std::atomic<uint64_t> blocked{0};       // Block: times the producer waited for room
+        std::atomic<uint64_t> blockedNs{0};     //   time spent waiting
+        std::atomic<uint64_t> blockTimeouts{0}; //   waits that ran out
+        std::atomic<uint64_t> spilled{0};       // Spill: packets written to the spill file
+        std::atomic<uint64_t> restored{0};      //   read back into the ring
+        std::atomic<uint64_t> spillFailures{0}; //   that could not be spilled (dropped)
+    };
+
+    class Reader;
+
+    PacketRing(size_t capacityBytes, size_t maxPacketSize, const MemoryPolicy& policy = MemoryPolicy());
+    ~PacketRing();
+
+    // Any thread; the producer picks a change up with its next packet. The spill file is
+    // created in spillDirectory when first needed (empty: the system's temporary directory).
+    void setOverflowPolicy(Overflow policy, int blockTimeoutUs = DEFAULT_BLOCK_TIMEOUT_US, const std::string& spillDirectory = std::string());
+    Overflow overflowPolicy() const { return static_cast<Overflow>(overflowMode.load(std::memory_order_relaxed)); }
+    const OverflowStats& overflowStats() const { return overflow; }
+    // Producer: move spilled packets back into the ring while it has room. True when none
+    // are left. Called with every packet anyway; call it when idle to drain the spill sooner.
+    bool restoreSpilled();
+
+    size_t capacityBytes() const { return arenaBytes; }
+    size_t maxPacketSize() const { return maxPayload; }
+    const MemoryReport& memoryReport() const { return arena.report(); }
+
+    // Producer: regions for up to maxCount records of reserveSize() bytes each, consecutive
+    // in the arena. Returns how many were reserved (0 when the ring is full, or while
+    // spilled packets wait to go first). Reserved regions stay private until committed.
+    int reserve(char** out, int maxCount);
+    // Producer: one region of exactly `size` bytes, or nullptr when the ring is full
+    char* reserve(size_t size);
+    // Payload capacity of each region handed out by reserve(out, maxCount)
+    size_t reserveSize() const { return regionPayload; }
+    // Producer: raise reserveSize() once a larger datagram has been seen (never lowered)
+    void growReserveSize(size_t size);
+
+    // Producer: publish reserved region `index` (0-based within the last reserve()) as the
+    // next packet. Commits must be made in increasing index order; skipped regions become
+    // padding.
+    void commit(int index, size_t size, int64_t timestampNs, uint64_t source = 0);
+
+    // Producer: copying push. False when the ring is full and the packet was dropped; with
+    // the Spill policy it goes to the spill file instead.
+    bool push(const char* data, size_t size, int64_t timestampNs, uint64_t source = 0) {
+        char* buffer = reserve(size);
+        if (!buffer) return size <= maxPayload && spillPacket(data, size, timestampNs, source);
+        memcpy(buffer, data, size);
+        commit(0, size, timestampNs, source);
+        return true;
+    }
+
+    // Producer: publish a packet whose memory the producer owns; it must stay valid
+    // until consumed() has passed it (unless it was spilled: published() did not move).
+    // False when the ring is full and the packet was dropped.
+    bool pushExternal(char* data, size_t size, int64_t timestampNs, uint64_t source = 0);
+
+    // Producer: packets published so far, and how many of those every required reader has
+    // released (all of them when there is none)
+    uint64_t published() const { return publishCount.load(std::memory_order_relaxed); }
+    uint64_t consumed() const;
+
+    // Consumer: a cursor that starts at the next packet to be published, or nullptr when
+    // all MAX_READERS are taken. Attach and detach from the consumer's side of the ring.
+    Reader* attachReader(bool required);
+    void detachReader(Reader* reader);
+
+    // The primary reader (the logger), a required reader kept in the first slot. The
+    // producers only lend memory through pushExternal() while a required reader is
+    // attached, since nothing else would ever hand it back.
+    // With historyNs > 0 it starts at the oldest packet still in the ring that arrived at
+    // most historyNs ago, within the newest historyBytes (and 7/8 of the arena); packets
+    // lent before it attached are left out.
+    void setConsumerAttached(bool attached, int64_t historyNs = 0, size_t historyBytes = 0);
+    bool hasConsumer() const { return requiredMask.load(std::memory_order_acquire) != 0; }
+    bool pop(Packet& packet);
+    int popBatch(Packet* out, int maxCount);
+    bool peek(Packet& packet);
+
+    // Approximate number of packets and arena bytes the slowest required reader has queued
+    int size() const { return static_cast<int>(published() - consumed()); }
+    size_t usedBytes() const;
+
+private:
+    enum RecordKind : uint32_t { Data = 0, External = 1, Padding = 2 };
+    struct RecordHeader {
+        uint32_t span;  // Bytes from this header to the next one
+        uint32_t kind;
+        uint32_t size;  // Payload bytes
+        uint32_t sequence; // Low bits of published() when it was published
+        int64_t timestampNs;
+        uint64_t source;
+    };
+    static_assert(sizeof(RecordHeader) == HEADER_SIZE, "record header layout");
+
+    static size_t alignUp(size_t n) { return (n + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1); }
+    RecordHeader* headerAt(uint64_t position) const {
+        return reinterpret_cast<RecordHeader*>(arena.data() + position % arenaBytes);
+    }
+    // Start `count` regions of `stride` bytes at the first position that keeps them in one
+    // lap. `wait`: apply the Block policy when none fit.
+    int reserveRegions(size_t stride, int maxCount, bool wait = true);
+    bool waitForRoom(uint64_t end);
+    void requestTrim(uint64_t start);
+    bool spillPacket(const char* data, size_t size, int64_t timestampNs, uint64_t source);
+    bool spillPending() const { return spillFile && !spillFile->empty(); }
+    void padUpTo(uint64_t position);
+    void publish(RecordHeader* header, uint64_t end);
+    uint64_t requiredTail() const;
+    uint64_t writeLimit() const;
+    // How far ahead of what was written last the producer may go without looking at the
+    // readers again (at least two of the largest records); the rest of the lap is history
+    size_t idleLead() const { return std::max(arenaBytes / 8, 2 * alignUp(HEADER_SIZE + maxPayload)); }
+    // Re-read writeLimit() into cachedLimit, capped at idleLead(); returns the uncapped limit
+    uint64_t refreshLimit();
+    void startReader(int slot, bool required, int64_t historyNs = 0, size_t historyBytes = 0);
+    // A record boundary at or after `floor` (below `end`) that has not been overwritten
+    uint64_t historyBoundary(uint64_t floor, uint64_t end) const;
+
+    // Set at construction, read by everyone
+    size_t arenaBytes;
+    size_t maxPayload;
+    PacketMemory arena;
+    std::unique_ptr<Reader[]> readers;
+
+    // Producer-only, on a cache line of their own so that readers never share it
+    alignas(CACHE_LINE) size_t regionPayload = DEFAULT_RESERVE_SIZE;
+    uint64_t writePos = 0;     // End of the last committed record
+    uint64_t reserveBase = 0;  // Position of region 0 of the last reserve()
+    size_t reserveStride = 0;
+    int reserveCount = 0;
+    uint64_t cachedLimit = 0;  // See refreshLimit(); the readers' tails are only read once it is reached
+    bool blockExpired = false; // A wait ran out; no more waiting until there is room again
+    std::unique_ptr<SpillFile> spillFile;
+
+    // Written by the producer, read by the readers
+    alignas(CACHE_LINE) std::atomic<uint64_t> head{0};  // Published end, in bytes since construction
+    std::atomic<uint64_t> publishCount{0};
+    // Everything before this position may have been overwritten; optional readers check it
+    std::atomic<uint64_t> overwritten{0};
+    // Drop oldest: required readers skip the records that start before this position
+    std::atomic<uint64_t> trimTo{0};
+    // The oldest record not yet overwritten, and the end of the last lent one
+    std::atomic<uint64_t> historyStart{0};
+    std::atomic<uint64_t> externalEnd{0};
+
+    alignas(CACHE_LINE) std::atomic<uint32_t> requiredMask{0}; // Slots of the attached required readers
+    std::atomic<int> overflowMode{DropNewest};
+    std::atomic<int> blockTimeoutUs{DEFAULT_BLOCK_TIMEOUT_US};
+    std::mutex spillDirectoryMutex;
+    std::string spillDirectory;
+
+    alignas(CACHE_LINE) OverflowStats overflow;
+};
+
+class alignas(PacketRing::CACHE_LINE) PacketRing::Reader {
+public:
+    // The popped packet stays valid until the next pop(), popBatch() or peek(), which hand
+    // its space back to the producer (for an optional reader, see intact())
+    bool pop(Packet& packet);
+    // Up to maxCount packets at once, valid together until the next call. The ring's head is
+    // read once per batch and the whole batch is released with a single store.
+    int popBatch(Packet* out, int maxCount);
+    // Look at the next packet without removing it
+    bool peek(Packet& packet);
+    bool required() const { return state.load(std::memory_order_relaxed) == Required; }
+    // Optional readers: whether the packets from the last pop(), popBatch() or peek() were
+    // left alone until now. Check after using them, and discard what was made of them otherwise.
+    bool intact() const;
+    // Packets this reader never got to: overwritten (optional readers) or evicted to make
+    // room (required readers, with the DropOldest policy)
+    uint64_t skipped() const { return skippedCount.load(std::memory_order_relaxed); }
+
+private:
+    friend class PacketRing;
+    enum State { Free, Required, Optional };
+
+    void releasePending();
+    // Drop oldest: skip the records that start before `trim`
+    uint64_t evict(uint64_t position, uint64_t trim);
+    // The record at or after `position` (past padding, or lapping for an optional reader);
+    // on success `position` is the record's own and `sequence` its header's
+    bool readRecord(uint64_t& position, Packet& packet, uint64_t& next, uint32_t& sequence);
+    void noteHandedOut(uint64_t position, uint32_t sequence, bool external, bool first);
+
+    PacketRing* ring = nullptr;
+    std::atomic<int> state{Free};
+    std::atomic<uint64_t> tail{0};     // Released up to here (read by the producer)
+    std::atomic<uint64_t> released{0}; // Records released, see consumed()
+    std::atomic<uint64_t> skippedCount{0};
+    // Reader's own: the packets handed out last, released by the next call
+    uint64_t cachedHead = 0;  // The ring's head as last read; only re-read once reached
+    uint64_t pendingTail = 0;
+    uint32_t pendingSequence = 0;
+    bool pendingRelease = false;
+    uint32_t poppedSequence = 0;
+    bool popped = false;      // poppedSequence is set, for counting skips
+    // The oldest packet, and the oldest lent one, handed out by the last call, for intact()
+    uint64_t lastPosition = 0;
+    uint32_t lastSequence = 0;
+    bool lastExternal = false;
+};
+
+#endif // PACKETRING_H
@@ -0,0 +1,160 @@
+#include "ReceiveEngine.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sched.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+ReceiveEngine::ReceiveEngine(PacketRing& ring, Backend backend)
+    : ring(ring), capture(createCaptureBackend(backend, ring, stats)) {
+}
+
+ReceiveEngine::~ReceiveEngine() {
+    close();
+}
+
+bool ReceiveEngine::open(const CaptureConfig& config, std::string& error) {
+    return capture->open(config, error);
+}
+
+void ReceiveEngine::close() {
+    stopThread();
+    capture->close();
+}
+
+void ReceiveEngine::setHandlers(BatchHandler onBatch, WakeHandler onWake) {
+    capture->setBatchHandler(std::move(onBatch));
+    wakeHandler = std::move(onWake);
+}
+
+int ReceiveEngine::drain(int maxPackets) {
+    int total = 0;
+    while (total < maxPackets) {
+        bool drained = false;
+        total += capture->receiveBatch(drained);
+        if (drained) break;
+    }
+    return total;
+}
+
+int ReceiveEngine::service(int maxPackets) {
+    int drained = drain(maxPackets);
+    if (drained == 0) ring.restoreSpilled();
+    if (wakeHandler) wakeHandler(drained);
+    return drained;
+}
+
+bool ReceiveEngine::startThread(Policy policy, std::string& error) {
+    if (capture->fd() < 0) {
+        error = "Receive engine is not open";
+        return false;
+    }
+    if (worker.joinable()) return true;
+
+    if (policy == Policy::BusyPoll || policy == Policy::Hybrid) {
+        capture->enableBusyPoll(BUSY_POLL_US);
+    }
+    if (policy != Policy::BusyPoll) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) {
+            error = std::string("Failed to set up epoll: ") + strerror(errno);
+            stopThread();
+            return false;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = capture->fd();
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, capture->fd(), &ev);
+        ev.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+    }
+
+    stopRequested = false;
+    worker = std::thread(&ReceiveEngine::threadFunc, this, policy);
+    // A spinning thread must not be SCHED_FIFO or it can starve the whole core
+    if (policy != Policy::BusyPoll) {
+        sched_param sch_params;
+        sch_params.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        pthread_setschedparam(worker.native_handle(), SCHED_FIFO, &sch_params);
+    }
+    return true;
+}
+
+void ReceiveEngine::stopThread() {
+    if (worker.joinable()) {
+        stopRequested = true;
+        if (wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+        worker.join();
+    }
+    if (epollFd >= 0) {
+        ::close(epollFd);
+        epollFd = -1;
+    }
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+void ReceiveEngine::pinThread(int cpu) {
+    if (!worker.joinable()) return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus);
+}
+
+void ReceiveEngine::pinThreadToNode(int node) {
+    std::vector<int> nodeCpus;
+    if (!worker.joinable() || !numaNodeCpus(node, nodeCpus)) return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : nodeCpus) CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus);
+}
+
+bool ReceiveEngine::waitReadable(int timeoutMs) {
+    epoll_event events[2];
+    int n = epoll_wait(epollFd, events, 2, timeoutMs);
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.fd == capture->fd()) return true;
+    }
+    return false;
+}
+
+void ReceiveEngine::threadFunc(Policy policy) {
+    auto lastTraffic = std::chrono::steady_clock::now();
+
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        bool readable = false;
+        switch (policy) {
+        case Policy::BusyPoll:
+            break; // Never block
+        case Policy::Epoll:
+            readable = waitReadable(WAIT_TIMEOUT_MS);
+            break;
+        case Policy::Hybrid:
+            if (std::chrono::steady_clock::now() - lastTraffic > std::chrono::microseconds(HYBRID_SPIN_US)) {
+                readable = waitReadable(WAIT_TIMEOUT_MS);
+            }
+            break;
+        }
+        int drained = service(MAX_DRAIN);
+        // A backend can stay readable with nothing new, e.g. a packet ring whose newest block is
+        // still lent to the ring consumer; back off rather than spin at real-time priority
+        if (readable && drained == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(HYBRID_SPIN_US));
+        }
+        if (drained > 0 && policy == Policy::Hybrid) {
+            lastTraffic = std::chrono::steady_clock::now();
+        }
+    }
+}
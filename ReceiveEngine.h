@@ -0,0 +1,80 @@
+#ifndef RECEIVEENGINE_H
+#define RECEIVEENGINE_H
+
+#include "CaptureBackend.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <pthread.h>
+
+// Linux UDP receive engine: a CaptureBackend (by default a native socket read with recvmmsg
+// straight into PacketRing slots). It can be drained from the Qt event loop (QSocketNotifier
+// on fd()), or own a plain receive thread with a selectable wait policy that bypasses the
+// event loop entirely.
+class ReceiveEngine {
+public:
+    enum class Policy {
+        BusyPoll,   // Spin on the backend; SO_BUSY_POLL lets the kernel poll the device queue
+        Epoll,      // Block in epoll_wait (with timeout) until the socket is readable
+        Hybrid      // Spin for HYBRID_SPIN_US after the last datagram, then block in epoll_wait
+    };
+
+    using Backend = CaptureBackend::Kind;
+    using Datagram = CaptureBackend::Datagram;
+    using BatchHandler = CaptureBackend::BatchHandler;
+    // Called by the receive thread after every wakeup, with the number of datagrams drained
+    using WakeHandler = std::function<void(int drained)>;
+
+    static constexpr int BATCH_SIZE = CaptureBackend::BATCH_SIZE;
+    static constexpr int WAIT_TIMEOUT_MS = 5;
+    static constexpr int HYBRID_SPIN_US = 50;
+    static constexpr int BUSY_POLL_US = 50;
+    static constexpr int MAX_DRAIN = 1000; // Per-wakeup budget, as in the event-loop paths
+
+    explicit ReceiveEngine(PacketRing& ring, Backend backend = Backend::Socket);
+    ~ReceiveEngine();
+
+    bool open(const CaptureConfig& config, std::string& error);
+    void close();
+    int fd() const { return capture->fd(); }
+    // Published ring packets point into capture memory; see CaptureBackend::lendsBuffers()
+    bool lendsBuffers() const { return capture->lendsBuffers(); }
+    void enableBusyPoll(int us) { capture->enableBusyPoll(us); }
+    void pollKernelDrops() { capture->pollKernelDrops(); }
+
+    void setHandlers(BatchHandler onBatch, WakeHandler onWake = nullptr);
+
+    // Non-blocking: read batches until the backend is drained or maxPackets were received
+    int drain(int maxPackets);
+    // One receive-thread wakeup: drain(), then the wake handler. Lets ReceiveScheduler
+    // threads drive engines that have no thread of their own. Also moves spilled packets
+    // back into the ring, so that a spill drains while the sender is quiet.
+    int service(int maxPackets);
+
+    bool startThread(Policy policy, std::string& error);
+    void stopThread();
+    bool threadRunning() const { return worker.joinable(); }
+    pthread_t nativeThread() { return worker.native_handle(); }
+    void pinThread(int cpu);
+    // Keep the thread on the CPUs of a NUMA node (where its ring memory was bound)
+    void pinThreadToNode(int node);
+
+    CaptureStats stats;
+
+private:
+    void threadFunc(Policy policy);
+    bool waitReadable(int timeoutMs);
+
+    PacketRing& ring;
+    std::unique_ptr<CaptureBackend> capture;
+    int epollFd = -1;
+    int wakeFd = -1; // eventfd used to interrupt epoll_wait on stop
+    std::atomic<bool> stopRequested{false};
+    std::thread worker;
+    WakeHandler wakeHandler;
+};
+
+#endif // RECEIVEENGINE_H
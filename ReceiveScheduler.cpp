@@ -0,0 +1,138 @@
+#include "ReceiveScheduler.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+ReceiveScheduler::~ReceiveScheduler() {
+    stop();
+}
+
+bool ReceiveScheduler::start(const std::vector<ReceiveEngine*>& engines, int threadCount, Policy policy, std::string& error) {
+    if (!workers.empty() || engines.empty()) return true;
+    threadCount = std::max(1, std::min(threadCount, static_cast<int>(engines.size())));
+
+    for (int i = 0; i < threadCount; ++i) workers.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < engines.size(); ++i) {
+        if (engines[i]->fd() < 0 || engines[i]->threadRunning()) {
+            error = "Receive engine is not open, or already has a thread";
+            workers.clear();
+            return false;
+        }
+        workers[i % threadCount]->engines.push_back(engines[i]);
+    }
+
+    if (policy == Policy::BusyPoll || policy == Policy::Hybrid) {
+        for (ReceiveEngine* engine : engines) engine->enableBusyPoll(ReceiveEngine::BUSY_POLL_US);
+    }
+    if (policy != Policy::BusyPoll) {
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            error = std::string("Failed to set up epoll: ") + strerror(errno);
+            stop();
+            return false;
+        }
+        for (auto& worker : workers) {
+            worker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (worker->epollFd < 0) {
+                error = std::string("Failed to set up epoll: ") + strerror(errno);
+                stop();
+                return false;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            for (ReceiveEngine* engine : worker->engines) {
+                ev.data.fd = engine->fd();
+                epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, engine->fd(), &ev);
+            }
+            ev.data.fd = wakeFd;
+            epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        }
+    }
+
+    stopRequested = false;
+    for (auto& worker : workers) {
+        worker->thread = std::thread(&ReceiveScheduler::threadFunc, this, worker.get(), policy);
+        // As in ReceiveEngine: never SCHED_FIFO for a spinning thread
+        if (policy != Policy::BusyPoll) {
+            sched_param sch_params;
+            sch_params.sched_priority = sched_get_priority_max(SCHED_FIFO);
+            pthread_setschedparam(worker->thread.native_handle(), SCHED_FIFO, &sch_params);
+        }
+    }
+    return true;
+}
+
+void ReceiveScheduler::stop() {
+    stopRequested = true;
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+        if (worker->epollFd >= 0) ::close(worker->epollFd);
+    }
+    workers.clear();
+    if (wakeFd >= 0) {
+        ::close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+std::vector<pthread_t> ReceiveScheduler::nativeThreads() {
+    std::vector<pthread_t> threads;
+    for (auto& worker : workers) threads.push_back(worker->thread.native_handle());
+    return threads;
+}
+
+void ReceiveScheduler::pinThreads(int firstCpu, int cpuCount) {
+    for (size_t i = 0; i < workers.size(); ++i) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET((firstCpu + i) % cpuCount, &cpus);
+        pthread_setaffinity_np(workers[i]->thread.native_handle(), sizeof(cpus), &cpus);
+    }
+}
+
+bool ReceiveScheduler::waitReadable(Worker* worker, int timeoutMs) {
+    epoll_event events[16];
+    int n = epoll_wait(worker->epollFd, events, 16, timeoutMs);
+    for (int i = 0; i < n; ++i) {
+        if (events[i].data.fd != wakeFd) return true;
+    }
+    return false;
+}
+
+void ReceiveScheduler::threadFunc(Worker* worker, Policy policy) {
+    auto lastTraffic = std::chrono::steady_clock::now();
+
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        switch (policy) {
+        case Policy::BusyPoll:
+            break;
+        case Policy::Epoll:
+            waitReadable(worker, ReceiveEngine::WAIT_TIMEOUT_MS);
+            break;
+        case Policy::Hybrid:
+            if (std::chrono::steady_clock::now() - lastTraffic > std::chrono::microseconds(ReceiveEngine::HYBRID_SPIN_US)) {
+                waitReadable(worker, ReceiveEngine::WAIT_TIMEOUT_MS);
+            }
+            break;
+        }
+        // Service every engine, not just the readable ones: an empty drain is one failed
+        // recvmmsg, and each engine's wake handler still gets to flush on time
+        int drained = 0;
+        for (ReceiveEngine* engine : worker->engines) {
+            drained += engine->service(ReceiveEngine::MAX_DRAIN);
+        }
+        if (drained > 0 && policy == Policy::Hybrid) {
+            lastTraffic = std::chrono::steady_clock::now();
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef RECEIVESCHEDULER_H
+#define RECEIVESCHEDULER_H
+
+#include "ReceiveEngine.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+// A fixed pool of receive threads shared by several opened ReceiveEngines (one per stream),
+// so that N streams do not need N spinning or blocked threads. Engines are spread round-robin
+// over the threads; each thread waits on all of its engines' fds at once and services every
+// engine per wakeup, with the same wait policies as ReceiveEngine::startThread().
+class ReceiveScheduler {
+public:
+    using Policy = ReceiveEngine::Policy;
+
+    ReceiveScheduler() = default;
+    ~ReceiveScheduler();
+
+    // Engines must be open, have no thread of their own, and outlive stop()
+    bool start(const std::vector<ReceiveEngine*>& engines, int threadCount, Policy policy, std::string& error);
+    void stop();
+    bool running() const { return !workers.empty(); }
+    std::vector<pthread_t> nativeThreads();
+    void pinThreads(int firstCpu, int cpuCount);
+
+private:
+    struct Worker {
+        std::vector<ReceiveEngine*> engines;
+        int epollFd = -1;
+        std::thread thread;
+    };
+    void threadFunc(Worker* worker, Policy policy);
+    bool waitReadable(Worker* worker, int timeoutMs);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    int wakeFd = -1; // eventfd shared by every worker's epoll set, to interrupt them on stop
+    std::atomic<bool> stopRequested{false};
+};
+
+#endif // RECEIVESCHEDULER_H
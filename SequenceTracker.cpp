@@ -0,0 +1,214 @@
+#include "SequenceTracker.h"
+#include <algorithm>
+
+namespace {
+// Single-writer counter update: no locked read-modify-write on the per-struct path
+void bump(std::atomic<uint64_t>& counter, uint64_t by = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+uint64_t mask(int size) {
+    return size >= 8 ? ~uint64_t(0) : (uint64_t(1) << (size * 8)) - 1;
+}
+
+// A window must stay under half the counter range to tell ahead from behind
+int64_t windowFor(int size) {
+    return size == 1 ? 128 : SequenceTracker::WINDOW;
+}
+}
+
+uint64_t SequenceField::read(const char* structPtr) const {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(structPtr + offset);
+    unsigned char bytes[8];
+    for (int i = 0; i < size; ++i) bytes[i] = swap ? p[size - 1 - i] : p[i];
+    switch (size) {
+    case 1: return bytes[0];
+    case 2: { uint16_t v; memcpy(&v, bytes, 2); return v; }
+    case 4: { uint32_t v; memcpy(&v, bytes, 4); return v; }
+    case 8: { uint64_t v; memcpy(&v, bytes, 8); return v; }
+    }
+    return 0;
+}
+
+int64_t SequenceField::distance(uint64_t a, uint64_t b) const {
+    if (size >= 8) return static_cast<int64_t>(b - a);
+    uint64_t range = uint64_t(1) << (size * 8);
+    uint64_t d = (b - a) & (range - 1);
+    return d >= range / 2 ? static_cast<int64_t>(d) - static_cast<int64_t>(range) : static_cast<int64_t>(d);
+}
+
+void SequenceTracker::observe(const char* data, size_t size, uint64_t source, const SequenceField& field) {
+    if (!field.valid()) return;
+    size_t count = size / field.structSize;
+    for (size_t i = 0; i < count; ++i) {
+        observe(source, field.read(data + i * field.structSize), field);
+    }
+}
+
+void SequenceTracker::observe(uint64_t source, uint64_t sequence, const SequenceField& field) {
+    if (resetRequested.exchange(false, std::memory_order_relaxed)) {
+        sources.clear();
+        for (auto* counter : {&received, &lost, &duplicates, &reordered, &late, &restarts}) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+    bump(received);
+    bool fresh;
+    SourceState& state = stateFor(source, sequence, fresh);
+    if (fresh) return;
+
+    int64_t window = windowFor(field.size);
+    int64_t d = field.distance(state.highest, sequence);
+    if (d > 0) {
+        // Ahead: everything skipped is missing until it turns up inside the window
+        bump(lost, d - 1);
+        if (d >= window) {
+            std::fill(std::begin(state.seen), std::end(state.seen), 0);
+        } else {
+            uint64_t m = mask(field.size);
+            for (int64_t k = 1; k < d; ++k) clear(state, (state.highest + k) & m);
+        }
+        testAndSet(state, sequence);
+        state.highest = sequence;
+        state.behindInARow = 0;
+    } else if (d == 0) {
+        bump(duplicates);
+    } else if (-d < window) {
+        state.behindInARow = 0;
+        if (testAndSet(state, sequence)) {
+            bump(duplicates);
+        } else {
+            bump(reordered);
+            if (lost.load(std::memory_order_relaxed) > 0) lost.store(lost.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+    } else {
+        bump(late);
+        if (++state.behindInARow >= RESTART_AFTER) {
+            // The sender started counting again (a device reset): follow it
+            bump(restarts);
+            std::fill(std::begin(state.seen), std::end(state.seen), 0);
+            state.highest = sequence;
+            testAndSet(state, sequence);
+            state.behindInARow = 0;
+        }
+    }
+}
+
+SequenceTracker::SourceState& SequenceTracker::stateFor(uint64_t source, uint64_t sequence, bool& fresh) {
+    for (SourceState& state : sources) {
+        if (state.source == source) {
+            fresh = false;
+            return state;
+        }
+    }
+    fresh = true;
+    sources.emplace_back();
+    SourceState& state = sources.back();
+    state.source = source;
+    state.highest = sequence;
+    testAndSet(state, sequence);
+    return state;
+}
+
+bool SequenceTracker::testAndSet(SourceState& state, uint64_t sequence) {
+    unsigned bit = sequence % WINDOW;
+    uint64_t flag = uint64_t(1) << (bit % 64);
+    bool wasSet = state.seen[bit / 64] & flag;
+    state.seen[bit / 64] |= flag;
+    return wasSet;
+}
+
+void SequenceTracker::clear(SourceState& state, uint64_t sequence) {
+    unsigned bit = sequence % WINDOW;
+    state.seen[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+}
+
+ReorderBuffer::ReorderBuffer(Source upstream, const SequenceField& field, int depth, size_t slotSize, int64_t holdNs)
+    : upstream(std::move(upstream)), field(field), depth(std::max(1, depth)), slotSize(slotSize), holdNs(holdNs) {
+    // One buffer more than the window: the packet last handed out is still in use
+    for (int i = 0; i <= this->depth; ++i) {
+        pool.push_back(std::make_unique<char[]>(slotSize));
+        freeBuffers.push_back(pool.back().get());
+    }
+    held.reserve(this->depth);
+}
+
+ReorderBuffer::Expected& ReorderBuffer::expectedFor(uint64_t source, uint64_t first) {
+    for (Expected& e : expected) {
+        if (e.source == source) return e;
+    }
+    expected.push_back({source, first});
+    return expected.back();
+}
+
+void ReorderBuffer::release(size_t index, PacketRing::Packet& packet) {
+    Entry entry = held[index];
+    held.erase(held.begin() + index);
+    expectedFor(entry.packet.source, entry.first).next = (entry.last + 1) & mask(field.size);
+    releasedBuffer = entry.packet.data;
+    packet = entry.packet;
+}
+
+bool ReorderBuffer::pop(PacketRing::Packet& packet) {
+    if (releasedBuffer) {
+        freeBuffers.push_back(releasedBuffer);
+        releasedBuffer = nullptr;
+    }
+    for (;;) {
+        // A held packet that has become next in line (or fallen behind it) goes first
+        for (size_t i = 0; i < held.size(); ++i) {
+            if (field.distance(expectedFor(held[i].packet.source, held[i].first).next, held[i].first) <= 0) {
+                release(i, packet);
+                return true;
+            }
+        }
+        if (freeBuffers.empty()) break;
+
+        PacketRing::Packet incoming;
+        if (!upstream(incoming)) break;
+        if (!field.valid() || incoming.size < static_cast<size_t>(field.structSize) || incoming.size > slotSize) {
+            packet = incoming;
+            return true;
+        }
+        size_t structs = incoming.size / field.structSize;
+        uint64_t first = field.read(incoming.data);
+        uint64_t last = field.read(incoming.data + (structs - 1) * field.structSize);
+        Expected& next = expectedFor(incoming.source, first);
+        if (field.distance(next.next, first) <= 0) {
+            // In order, or behind what was already released (nothing to wait for): pass through
+            if (next.next == first) next.next = (last + 1) & mask(field.size);
+            packet = incoming;
+            return true;
+        }
+        // Ahead of a gap: hold a copy until the gap fills or times out
+        char* buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        memcpy(buffer, incoming.data, incoming.size);
+        Entry entry;
+        entry.packet = incoming;
+        entry.packet.data = buffer;
+        entry.first = first;
+        entry.last = last;
+        entry.heldSinceNs = wallClockNs();
+        held.push_back(entry);
+    }
+
+    // Nothing in order: give up on the oldest gap once the window is full or it waited too long
+    if (held.empty()) return false;
+    if (!freeBuffers.empty() && wallClockNs() - held.front().heldSinceNs < holdNs) return false;
+    uint64_t source = held.front().packet.source;
+    Expected& next = expectedFor(source, held.front().first);
+    size_t lowest = 0;
+    int64_t lowestDistance = INT64_MAX;
+    for (size_t i = 0; i < held.size(); ++i) {
+        if (held[i].packet.source != source) continue;
+        int64_t d = field.distance(next.next, held[i].first);
+        if (d < lowestDistance) {
+            lowestDistance = d;
+            lowest = i;
+        }
+    }
+    skippedCount.fetch_add(static_cast<uint64_t>(lowestDistance), std::memory_order_relaxed);
+    release(lowest, packet);
+    return true;
+}
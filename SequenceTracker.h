@@ -0,0 +1,108 @@
+#ifndef SEQUENCETRACKER_H
+#define SEQUENCETRACKER_H
+
+#include "PacketRing.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Where the device's sequence counter sits in each struct. Counters of 1 to 8 bytes wrap
+// at their own width; swap reverses the byte order (the "Change Endianness" setting).
+struct SequenceField {
+    int offset = 0;
+    int size = 0;       // 0: no sequence field
+    int structSize = 0;
+    bool swap = false;
+
+    bool valid() const { return size > 0 && structSize > 0 && offset + size <= structSize; }
+    uint64_t read(const char* structPtr) const;
+    // Signed distance from a to b, modulo the counter width
+    int64_t distance(uint64_t a, uint64_t b) const;
+};
+
+// Line-rate loss accounting, per source (sender address and port), from the sequence
+// counter of every struct. Each source keeps the highest sequence seen and a bitmap of
+// the WINDOW before it, so a late arrival can be told apart from a duplicate:
+//   ahead of the highest  -> the skipped numbers count as lost (for now)
+//   inside the window     -> first time: reordered (and no longer lost); again: duplicate
+//   behind the window     -> late; too old to tell, treated as a sequence restart once
+//                            RESTART_AFTER of them arrive in a row
+// observe() is called by one receive thread at a time; the counters may be read anywhere.
+class SequenceTracker {
+public:
+    static constexpr int WINDOW = 1024;
+    static constexpr int RESTART_AFTER = 16;
+
+    void observe(const char* data, size_t size, uint64_t source, const SequenceField& field);
+    void observe(uint64_t source, uint64_t sequence, const SequenceField& field);
+    // Takes effect on the next observe(), from the receive thread
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> lost{0};       // Currently missing; late arrivals take it back down
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> reordered{0};  // Arrived after a higher sequence from the same source
+    std::atomic<uint64_t> late{0};       // Arrived behind the window
+    std::atomic<uint64_t> restarts{0};
+
+private:
+    struct SourceState {
+        uint64_t source = 0;
+        uint64_t highest = 0;
+        uint64_t seen[WINDOW / 64] = {}; // Bit (s % WINDOW) set once s has arrived
+        int behindInARow = 0;
+    };
+    SourceState& stateFor(uint64_t source, uint64_t sequence, bool& fresh);
+    static bool testAndSet(SourceState& state, uint64_t sequence);
+    static void clear(SourceState& state, uint64_t sequence);
+
+    std::vector<SourceState> sources; // Receive thread only; a handful of senders at most
+    std::atomic<bool> resetRequested{false};
+};
+
+// Consumer-side reorder stage between a ring and its consumer (the logger). Packets are
+// copied out of the ring into a small pool and released per source in sequence order.
+// A gap is waited for until the pool is full or the oldest held packet is holdNs old,
+// then skipped. Packets without a sequence, or behind the released position, pass straight
+// through. Ordering uses the first struct's sequence; the next expected one follows the last.
+class ReorderBuffer {
+public:
+    using Source = std::function<bool(PacketRing::Packet&)>;
+
+    ReorderBuffer(Source upstream, const SequenceField& field, int depth, size_t slotSize, int64_t holdNs);
+
+    // The released packet stays valid until the next pop()
+    bool pop(PacketRing::Packet& packet);
+    uint64_t skipped() const { return skippedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        PacketRing::Packet packet; // data points into the pool
+        uint64_t first;
+        uint64_t last;
+        int64_t heldSinceNs;
+    };
+    struct Expected {
+        uint64_t source;
+        uint64_t next;
+    };
+    Expected& expectedFor(uint64_t source, uint64_t first);
+    void release(size_t index, PacketRing::Packet& packet);
+
+    Source upstream;
+    SequenceField field;
+    int depth;
+    size_t slotSize;
+    int64_t holdNs;
+    std::vector<std::unique_ptr<char[]>> pool;
+    std::vector<char*> freeBuffers;
+    char* releasedBuffer = nullptr; // Handed out by the last pop(), recycled by the next
+    std::vector<Entry> held;         // Arrival order
+    std::vector<Expected> expected;
+    std::atomic<uint64_t> skippedCount{0};
+};
+
+#endif // SEQUENCETRACKER_H
@@ -0,0 +1,125 @@
+#include "SpillFile.h"
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+SpillFile::SpillFile(const std::string& directory, uint64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes) {
+}
+
+SpillFile::~SpillFile() {
+    if (file) fclose(file);
+}
+
+bool SpillFile::open() {
+    if (file) return true;
+#ifdef __linux__
+    if (!directory.empty()) {
+        std::string path = directory + "/spectradaq-spill-XXXXXX";
+        int fd = mkstemp(&path[0]);
+        if (fd >= 0) {
+            unlink(path.c_str());
+            file = fdopen(fd, "w+b");
+            if (!file) ::close(fd);
+        }
+    }
+#endif
+    if (!file) file = tmpfile();
+    if (!file) {
+        lastError = std::string("cannot create spill file: ") + strerror(errno);
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    return true;
+}
+
+bool SpillFile::seekTo(uint64_t offset) {
+    if (offset == filePosition) return true;
+#ifdef _WIN32
+    bool ok = _fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+    bool ok = fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    if (ok) filePosition = offset;
+    else lastError = std::string("spill file seek: ") + strerror(errno);
+    return ok;
+}
+
+bool SpillFile::append(const char* data, size_t size, int64_t timestampNs, uint64_t source) {
+    if (writeOffset + sizeof(Header) + size > maxBytes) {
+        lastError = "spill file limit reached";
+        return false;
+    }
+    if (!open()) return false;
+    if (!writing) {
+        // A switch from reading to writing needs a seek, even to where the stream already is
+        filePosition = ~uint64_t(0);
+        writing = true;
+    }
+    if (!seekTo(writeOffset)) return false;
+    Header header{size, timestampNs, source};
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || (size > 0 && fwrite(data, size, 1, file) != 1)) {
+        lastError = std::string("spill file write: ") + strerror(errno);
+        filePosition = ~uint64_t(0); // Unknown after a short write
+        return false;
+    }
+    writeOffset += sizeof(header) + size;
+    filePosition = writeOffset;
+    return true;
+}
+
+bool SpillFile::startReading() {
+    if (!writing) return true;
+    // Buffered writes have to reach the file before they can be read back
+    if (fflush(file) != 0) {
+        lastError = std::string("spill file flush: ") + strerror(errno);
+        return false;
+    }
+    filePosition = ~uint64_t(0);
+    writing = false;
+    return true;
+}
+
+bool SpillFile::peek(size_t& size, int64_t& timestampNs, uint64_t& source) {
+    if (empty()) return false;
+    if (!peeked) {
+        if (!startReading() || !seekTo(readOffset)) return false;
+        if (fread(&next, sizeof(next), 1, file) != 1) {
+            lastError = "spill file read failed";
+            filePosition = ~uint64_t(0);
+            return false;
+        }
+        filePosition += sizeof(next);
+        peeked = true;
+    }
+    size = static_cast<size_t>(next.size);
+    timestampNs = next.timestampNs;
+    source = next.source;
+    return true;
+}
+
+bool SpillFile::read(char* out) {
+    // Appends may have come between peek() and read()
+    if (!peeked || !startReading() || !seekTo(readOffset + sizeof(next))) return false;
+    if (next.size > 0 && fread(out, static_cast<size_t>(next.size), 1, file) != 1) {
+        lastError = "spill file read failed";
+        filePosition = ~uint64_t(0);
+        return false;
+    }
+    peeked = false;
+    filePosition += next.size;
+    readOffset += sizeof(next) + next.size;
+    if (empty()) {
+        // Everything is back: start over at the beginning of the file
+        readOffset = writeOffset = 0;
+    }
+    return true;
+}
+
+void SpillFile::discard() {
+    peeked = false;
+    readOffset = writeOffset = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef SPILLFILE_H
+#define SPILLFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Packets that did not fit in a PacketRing, kept in an anonymous temporary file and read
+// back in the order they were written. The file is created on the first append and
+// removed when closed (on Linux it is unlinked right away, so it goes even on a crash).
+// Once everything has been read back it is rewound, so it only grows to the largest
+// backlog. Producer thread only.
+class SpillFile {
+public:
+    // directory: where the file goes (empty: the system's temporary directory). Put it on
+    // a disk; on tmpfs the spill would take RAM after all.
+    SpillFile(const std::string& directory, uint64_t maxBytes);
+    ~SpillFile();
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    // False when the file cannot be created or written, or would exceed maxBytes
+    bool append(const char* data, size_t size, int64_t timestampNs, uint64_t source);
+    bool empty() const { return readOffset == writeOffset; }
+    uint64_t pendingBytes() const { return writeOffset - readOffset; }
+
+    // The next packet's header, without consuming it; false when empty or unreadable
+    bool peek(size_t& size, int64_t& timestampNs, uint64_t& source);
+    // Read the peeked packet's payload into `out` and consume it
+    bool read(char* out);
+    // Forget everything not read back yet
+    void discard();
+    const std::string& error() const { return lastError; }
+
+private:
+    struct Header {
+        uint64_t size;
+        int64_t timestampNs;
+        uint64_t source;
+    };
+    bool open();
+    bool startReading();
+    bool seekTo(uint64_t offset);
+
+    std::string directory;
+    uint64_t maxBytes;
+    FILE* file = nullptr;
+    uint64_t readOffset = 0;
+    uint64_t writeOffset = 0;
+    uint64_t filePosition = 0; // Where the stream is, to skip redundant seeks
+    bool writing = true;       // Last operation; switching between reads and writes needs a seek
+    bool peeked = false;
+    Header next{};
+    std::string lastError;
+};
+
+#endif // SPILLFILE_H
@@ -0,0 +1,105 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Lock-free single-producer, single-consumer ring of plain values, allocated once at
+// construction (the capacity is rounded up to a power of two). Hands parsed samples from
+// the receive path to the UI, which drains it on its own timer: neither side allocates,
+// locks or waits, and a consumer that falls behind costs dropped values instead of a
+// growing queue.
+//
+// The producer may change between threads (a receive mode switch), as long as the old
+// one has stopped before the new one starts.
+template <typename T>
+class SpscRing {
+public:
+    static constexpr size_t CACHE_LINE = 64;
+
+    explicit SpscRing(size_t capacity)
+        : mask(roundUp(capacity) - 1), items(new T[mask + 1]) {}
+
+    size_t capacity() const { return mask + 1; }
+
+    // Producer: append up to count values; returns how many fit. The rest are dropped and
+    // counted, see dropped().
+    size_t push(const T* values, size_t count) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h + count > producerTail + capacity()) producerTail = tail.load(std::memory_order_acquire);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(count, producerTail + capacity() - h));
+        size_t offset = static_cast<size_t>(h & mask);
+        size_t first = std::min(n, capacity() - offset);
+        std::copy(values, values + first, items.get() + offset);
+        std::copy(values + first, values + n, items.get());
+        head.store(h + n, std::memory_order_release);
+        if (n < count) droppedCount.fetch_add(count - n, std::memory_order_relaxed);
+        return n;
+    }
+    bool push(const T& value) { return push(&value, 1) == 1; }
+
+    // Producer: how many values would fit right now
+    size_t room() {
+        producerTail = tail.load(std::memory_order_acquire);
+        return static_cast<size_t>(producerTail + capacity() - head.load(std::memory_order_relaxed));
+    }
+
+    // Consumer: take up to maxCount values, oldest first; returns how many were taken
+    size_t pop(T* out, size_t maxCount) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        size_t n = available(t, maxCount);
+        size_t offset = static_cast<size_t>(t & mask);
+        size_t first = std::min(n, capacity() - offset);
+        std::copy(items.get() + offset, items.get() + offset + first, out);
+        std::copy(items.get(), items.get() + (n - first), out + first);
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: the oldest value, left in place
+    bool front(T& value) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (available(t, 1) == 0) return false;
+        value = items[static_cast<size_t>(t & mask)];
+        return true;
+    }
+
+    // Consumer: discard up to count of the oldest values unread; returns how many
+    size_t skip(size_t count) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        size_t n = available(t, count);
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Values queued: at least this many for the consumer, at most this many for the producer
+    size_t size() const {
+        return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+    size_t available(uint64_t t, size_t maxCount) {
+        if (t + maxCount > consumerHead) consumerHead = head.load(std::memory_order_acquire);
+        return static_cast<size_t>(std::min<uint64_t>(maxCount, consumerHead - t));
+    }
+
+    const size_t mask;
+    const std::unique_ptr<T[]> items;
+    // Each side's index, and its cached copy of the other's, on cache lines of their own
+    alignas(CACHE_LINE) std::atomic<uint64_t> head{0};
+    uint64_t producerTail = 0;
+    std::atomic<uint64_t> droppedCount{0};
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail{0};
+    uint64_t consumerHead = 0;
+};
+
+#endif // SPSCRING_H
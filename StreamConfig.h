@@ -0,0 +1,41 @@
+#ifndef STREAMCONFIG_H
+#define STREAMCONFIG_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include "FieldDef.h"
+
+// An additional UDP stream received next to the main one: its own port (or multicast group),
+// struct layout, ring and log file. Stored in presets under "streams".
+struct StreamConfig {
+    QString name;
+    quint16 port = 0;
+    QString multicastGroup; // IPv4 group to join, empty for unicast
+    QString interfaceName;  // Interface for the group membership, empty for the default route
+    QString structText;
+    // Resolved from structText by MainWindow before the config is handed to UdpWorker
+    QList<FieldDef> fields;
+    int structSize = 0;
+
+    QJsonObject toJson() const {
+        QJsonObject obj;
+        obj["name"] = name;
+        obj["port"] = port;
+        obj["multicast_group"] = multicastGroup;
+        obj["interface"] = interfaceName;
+        obj["struct_def"] = structText;
+        return obj;
+    }
+    static StreamConfig fromJson(const QJsonObject &obj) {
+        StreamConfig s;
+        s.name = obj["name"].toString();
+        s.port = static_cast<quint16>(obj["port"].toInt());
+        s.multicastGroup = obj["multicast_group"].toString();
+        s.interfaceName = obj["interface"].toString();
+        s.structText = obj["struct_def"].toString();
+        return s;
+    }
+};
+
+#endif // STREAMCONFIG_H
@@ -0,0 +1,114 @@
+#include "StreamDialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QLineEdit>
+#include <QSpinBox>
+#include <QPlainTextEdit>
+
+StreamDialog::StreamDialog(const QJsonArray &streams, QWidget *parent)
+    : QDialog(parent), streamArray(streams)
+{
+    setWindowTitle("Edit Streams");
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    listWidget = new QListWidget(this);
+    mainLayout->addWidget(listWidget);
+    QHBoxLayout *btnLayout = new QHBoxLayout;
+    QPushButton *addBtn = new QPushButton("Add", this);
+    QPushButton *editBtn = new QPushButton("Edit", this);
+    QPushButton *removeBtn = new QPushButton("Remove", this);
+    btnLayout->addWidget(addBtn);
+    btnLayout->addWidget(editBtn);
+    btnLayout->addWidget(removeBtn);
+    mainLayout->addLayout(btnLayout);
+    QHBoxLayout *saveCancelLayout = new QHBoxLayout;
+    QPushButton *saveBtn = new QPushButton("Save", this);
+    QPushButton *cancelBtn = new QPushButton("Cancel", this);
+    saveCancelLayout->addStretch();
+    saveCancelLayout->addWidget(saveBtn);
+    saveCancelLayout->addWidget(cancelBtn);
+    mainLayout->addLayout(saveCancelLayout);
+    connect(addBtn, &QPushButton::clicked, this, &StreamDialog::on_addButton_clicked);
+    connect(editBtn, &QPushButton::clicked, this, &StreamDialog::on_editButton_clicked);
+    connect(removeBtn, &QPushButton::clicked, this, &StreamDialog::on_removeButton_clicked);
+    connect(saveBtn, &QPushButton::clicked, this, &QDialog::accept);
+    connect(cancelBtn, &QPushButton::clicked, this, &QDialog::reject);
+    setLayout(mainLayout);
+    updateStreamList();
+}
+
+QJsonArray StreamDialog::getStreams() const {
+    return streamArray;
+}
+
+void StreamDialog::updateStreamList() {
+    listWidget->clear();
+    for (const QJsonValue &val : streamArray) {
+        StreamConfig stream = StreamConfig::fromJson(val.toObject());
+        QString source = stream.multicastGroup.isEmpty() ? QString("port %1").arg(stream.port)
+                                                         : QString("%1:%2").arg(stream.multicastGroup).arg(stream.port);
+        listWidget->addItem(stream.name + " [" + source + "]");
+    }
+}
+
+bool StreamDialog::editStream(StreamConfig &stream) {
+    QDialog dlg(this);
+    dlg.setWindowTitle("Edit Stream");
+    QVBoxLayout *layout = new QVBoxLayout(&dlg);
+    QFormLayout *form = new QFormLayout;
+    QLineEdit *nameEdit = new QLineEdit(stream.name, &dlg);
+    QSpinBox *portSpin = new QSpinBox(&dlg);
+    portSpin->setRange(1, 65535);
+    portSpin->setValue(stream.port);
+    QLineEdit *groupEdit = new QLineEdit(stream.multicastGroup, &dlg);
+    groupEdit->setPlaceholderText("e.g. 239.1.2.3, empty for unicast");
+    QLineEdit *interfaceEdit = new QLineEdit(stream.interfaceName, &dlg);
+    interfaceEdit->setPlaceholderText("Default route");
+    QPlainTextEdit *structEdit = new QPlainTextEdit(stream.structText, &dlg);
+    form->addRow("Name (log file suffix)", nameEdit);
+    form->addRow("Port", portSpin);
+    form->addRow("Multicast group", groupEdit);
+    form->addRow("Interface", interfaceEdit);
+    form->addRow("Struct definition", structEdit);
+    layout->addLayout(form);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, &dlg);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    if (dlg.exec() != QDialog::Accepted) return false;
+    stream.name = nameEdit->text().trimmed();
+    stream.port = static_cast<quint16>(portSpin->value());
+    stream.multicastGroup = groupEdit->text().trimmed();
+    stream.interfaceName = interfaceEdit->text().trimmed();
+    stream.structText = structEdit->toPlainText();
+    return true;
+}
+
+void StreamDialog::on_addButton_clicked() {
+    StreamConfig stream;
+    stream.name = QString("stream%1").arg(streamArray.size() + 1);
+    stream.port = 2024;
+    if (editStream(stream)) {
+        streamArray.append(stream.toJson());
+        updateStreamList();
+    }
+}
+
+void StreamDialog::on_editButton_clicked() {
+    int row = listWidget->currentRow();
+    if (row < 0 || row >= streamArray.size()) return;
+    StreamConfig stream = StreamConfig::fromJson(streamArray[row].toObject());
+    if (editStream(stream)) {
+        streamArray[row] = stream.toJson();
+        updateStreamList();
+    }
+}
+
+void StreamDialog::on_removeButton_clicked() {
+    int row = listWidget->currentRow();
+    if (row < 0 || row >= streamArray.size()) return;
+    streamArray.removeAt(row);
+    updateStreamList();
+}
@@ -0,0 +1,28 @@
+#ifndef STREAMDIALOG_H
+#define STREAMDIALOG_H
+
+#include <QDialog>
+#include <QJsonArray>
+#include <QListWidget>
+#include "StreamConfig.h"
+
+// Edits the additional streams of a preset (a JSON array of StreamConfig)
+class StreamDialog : public QDialog {
+    Q_OBJECT
+public:
+    explicit StreamDialog(const QJsonArray &streams, QWidget *parent = nullptr);
+    QJsonArray getStreams() const;
+
+private slots:
+    void on_addButton_clicked();
+    void on_editButton_clicked();
+    void on_removeButton_clicked();
+
+private:
+    bool editStream(StreamConfig &stream);
+    void updateStreamList();
+    QJsonArray streamArray;
+    QListWidget *listWidget;
+};
+
+#endif // STREAMDIALOG_H
@@ -1,10 +1,13 @@
 #include "UdpWorker.h"
 #include <QDebug>
-#include <QtEndian>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
 #include <algorithm>
 #include "mainwindow.h"
 #include "LoggingManager.h"
-#include <QDateTime>
+#include "DecoderPlugin.h"
 #ifdef Q_OS_WIN
 #include <windows.h>
 #include <winsock2.h>
@@ -12,15 +15,14 @@
 #include <sys/socket.h>
 #include <pthread.h>
 #include <sched.h>
+#include <ctime>
 #endif
+#include <QSocketNotifier>
+#include <QTimer>
 
 UdpWorker::UdpWorker(QObject *parent) : QObject(parent) {
-    packetPool.resize(RING_BUFFER_SIZE);
-    for (auto& ptr : packetPool) {
-        ptr = std::make_unique<char[]>(MAX_PACKET_SIZE);
-    }
+    ring = makeRing(ringBytes, -1);
     recvBuffer.resize(MAX_PACKET_SIZE);
-    ringBuffer.fill(Packet{});
 }
 
 UdpWorker::~UdpWorker() {
@@ -28,6 +30,13 @@ UdpWorker::~UdpWorker() {
 }
 
 void UdpWorker::configure(const QString &structText_, const QList<FieldDef> &fields_, int structSize_, bool endianness_, int selectedField_, int selectedArrayIndex_, int selectedFieldCount_) {
+    // Offsets and types of every field, as the UI sized the struct, decoded by the layout's
+    // plugin if one was built for it, and the derived channels over them; all done before the
+    // receive threads are held up
+    CompiledLayout compiled(fields_);
+    compiled.setPlugin(findDecoderPlugin(compiled));
+    QList<DerivedChannel> channels = parseDerivedChannels(derivedText, fields_);
+    std::unique_lock<std::shared_mutex> lock(configMutex);
     structText = structText_;
     fields = fields_;
     structSize = structSize_;
@@ -36,97 +45,70 @@ void UdpWorker::configure(const QString &structText_, const QList<FieldDef> &fie
     selectedArrayIndex = selectedArrayIndex_;
     selectedFieldCount = selectedFieldCount_;
 
-    // Precompute field offsets, sizes, alignments
-    fieldOffsets.clear();
-    fieldSizes.clear();
-    fieldAlignments.clear();
-    int offset = 0;
-    auto typeSize = [](const QString &type) -> int {
-        if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        return 0;
-    };
-    auto typeAlignment = [](const QString &type) -> int {
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        return 1;
-    };
-    for (int i = 0; i < fields.size(); ++i) {
-        int align = typeAlignment(fields[i].type);
-        int sz = typeSize(fields[i].type);
-        int padding = (align - (offset % align)) % align;
-        offset += padding;
-        fieldOffsets.append(offset);
-        fieldSizes.append(sz);
-        fieldAlignments.append(align);
-        offset += sz * fields[i].count;
-    }
-    // Precompute selectedTypeSize and selectedFieldOffset
-    selectedTypeSize = fieldSizes.value(selectedField, 0);
-    selectedFieldOffset = fieldOffsets.value(selectedField, 0);
-    if (selectedField >= 0 && selectedField < fields.size() && fields[selectedField].count > 1) {
-        selectedFieldOffset += selectedArrayIndex * selectedTypeSize;
-    }
-    // Precompute converter
-    QString type = (selectedField >= 0 && selectedField < fields.size()) ? fields[selectedField].type : "";
-    if (type == "int16_t") {
-        converter = [](const char* ptr, bool swap) {
-            int16_t v = *reinterpret_cast<const int16_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "uint16_t") {
-        converter = [](const char* ptr, bool swap) {
-            uint16_t v = *reinterpret_cast<const uint16_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "int32_t") {
-        converter = [](const char* ptr, bool swap) {
-            int32_t v = *reinterpret_cast<const int32_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "uint32_t") {
-        converter = [](const char* ptr, bool swap) {
-            uint32_t v = *reinterpret_cast<const uint32_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "float") {
-        converter = [](const char* ptr, bool swap) {
-            float v = *reinterpret_cast<const float*>(ptr);
-            if (swap) v = qFromLittleEndian(v);
-            return v;
-        };
-    } else if (type == "int64_t") {
-        converter = [](const char* ptr, bool swap) {
-            int64_t v = *reinterpret_cast<const int64_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "uint64_t") {
-        converter = [](const char* ptr, bool swap) {
-            uint64_t v = *reinterpret_cast<const uint64_t*>(ptr);
-            return static_cast<float>(swap ? qFromLittleEndian(v) : v);
-        };
-    } else if (type == "double") {
-        converter = [](const char* ptr, bool swap) {
-            double v = *reinterpret_cast<const double*>(ptr);
-            if (swap) v = qFromLittleEndian(v);
-            return static_cast<float>(v);
-        };
-    } else if (type == "int8_t") {
-        converter = [](const char* ptr, bool) {
-            return static_cast<float>(*reinterpret_cast<const int8_t*>(ptr));
-        };
-    } else if (type == "uint8_t" || type == "char") {
-        converter = [](const char* ptr, bool) {
-            return static_cast<float>(*reinterpret_cast<const uint8_t*>(ptr));
-        };
-    } else {
-        converter = [](const char*, bool) { return 0.0f; };
+    layout = compiled;
+    derivedChannels = channels;
+    resolveSequenceField();
+    // Compile the extraction plan for the plotted element, or with ALL_ELEMENTS the whole
+    // array as a sample frame (the plan's element -1), or a derived channel along with the
+    // fields it reads
+    QVector<QPair<int, int>> selection;
+    if (selectedField >= 0 && selectedField < fields.size()) {
+        selection.append(qMakePair(selectedField, fields[selectedField].count > 1 ? selectedArrayIndex : 0));
+    } else if (selectedField >= fields.size() && selectedField < fields.size() + derivedChannels.size()) {
+        selection.append(qMakePair(selectedField, 0));
+    }
+    plan = planChannels(layout, derivedChannels, selection, endianness);
+    plotColumn = selection.isEmpty() ? 0 : static_cast<size_t>(std::max(0, plan.find(selection[0].first, selection[0].second)));
+    reserveParseScratch();
+}
+
+void UdpWorker::reserveParseScratch() {
+    // A datagram's worth of structs, grown only past that
+    size_t rows = MAX_PACKET_SIZE / std::max(structSize, 1);
+    qtValues.reserve(plan, rows);
+#ifdef Q_OS_LINUX
+    nativeValues.reserve(plan, rows);
+    for (auto& shard : shards) shard->values.reserve(plan, rows);
+#endif
+}
+
+void UdpWorker::resolveSequenceField() {
+    // Only a scalar integer field can count packets
+    SequenceField resolved;
+    if (layout.isSequenceCandidate(sequenceFieldIndex)) {
+        const CompiledLayout::Field& field = layout.field(sequenceFieldIndex);
+        resolved.offset = static_cast<int>(field.offset);
+        resolved.size = static_cast<int>(field.stride);
+        resolved.structSize = layout.size();
+        resolved.swap = endianness;
+    }
+    if (!resolved.valid()) resolved = SequenceField();
+    if (resolved.offset != sequenceField.offset || resolved.size != sequenceField.size
+        || resolved.structSize != sequenceField.structSize || resolved.swap != sequenceField.swap) {
+        sequenceField = resolved;
+        resetSequenceTracking();
     }
-    // Remove this line, std::array does not support resize
-    // ringBuffer.resize(RING_BUFFER_SIZE);
+}
+
+void UdpWorker::resetSequenceTracking() {
+    sequenceTracker.reset();
+#ifdef Q_OS_LINUX
+    for (auto& shard : shards) shard->sequence.reset();
+#endif
+}
+
+void UdpWorker::setSequenceField(int field) {
+    std::unique_lock<std::shared_mutex> lock(configMutex);
+    sequenceFieldIndex = field;
+    resolveSequenceField();
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Sequence field" << field << "offset" << sequenceField.offset << "size" << sequenceField.size;
+#endif
+}
+
+void UdpWorker::setDerivedChannels(const QString& text) {
+    std::unique_lock<std::shared_mutex> lock(configMutex);
+    derivedText = text;
 }
 
 void UdpWorker::updateConfig(const QString &structText_, const QList<FieldDef> &fields_, int structSize_, bool endianness_, int selectedField_, int selectedArrayIndex_, int selectedFieldCount_) {
@@ -135,13 +117,21 @@ void UdpWorker::updateConfig(const QString &structText_, const QList<FieldDef> &
 #endif
     configure(structText_, fields_, structSize_, endianness_, selectedField_, selectedArrayIndex_, selectedFieldCount_);
 #ifdef ENABLE_DEBUG
-    qDebug() << "[UdpWorker] Configuration updated: structSize=" << structSize << "selectedTypeSize=" << selectedTypeSize;
+    qDebug() << "[UdpWorker] Configuration updated: structSize=" << structSize << "plan columns=" << plan.columnCount();
 #endif
 }
 
 void UdpWorker::start(quint16 port_) {
     if (udpSocket) return;
     port = port_;
+#ifdef Q_OS_LINUX
+    if (engine || !shards.empty()) return;
+    if (receiveMode != QtSocketMode) {
+        if (startNative(port)) finishStart();
+        return;
+    }
+#endif
+    if (!ring) ring = makeRing(ringBytes, currentNumaNode());
     udpSocket = new QUdpSocket(this);
     // Set Qt buffer size BEFORE binding
     udpSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 64 * 1024 * 1024);  // 64MB
@@ -240,7 +230,16 @@ void UdpWorker::start(quint16 port_) {
 #ifdef ENABLE_DEBUG
     qDebug() << "[UdpWorker] Connected readyRead signal to processPendingDatagrams";
 #endif
+    finishStart();
+}
+
+void UdpWorker::finishStart() {
     running = true;
+    rxPackets = 0;
+    rxBytes = 0;
+    lastRxPackets = lastRxBytes = 0;
+    qtStats.resetDrops();
+    resetSequenceTracking();
     
     // Set UDP thread priority for better performance
 #ifdef Q_OS_WIN
@@ -254,14 +253,89 @@ void UdpWorker::start(quint16 port_) {
     sched_param sch_params;
     sch_params.sched_priority = sched_get_priority_max(SCHED_FIFO);
     pthread_setschedparam(threadHandle, SCHED_FIFO, &sch_params);
+    startStreams();
+    trackReceiveThreads();
 #endif
+    reportMemory();
+    attachForwarder();
     
-    // Add a timer to check if we're receiving data
-    QTimer* dataCheckTimer = new QTimer(this);
-    connect(dataCheckTimer, &QTimer::timeout, this, [this]() {
-        static int noDataCount = 0;
-        if (running && udpSocket) {
-            if (udpSocket->hasPendingDatagrams()) {
+    // Add a timer to check if we're receiving data and report the receive rate
+    if (!dataCheckTimer) {
+        dataCheckTimer = new QTimer(this);
+        connect(dataCheckTimer, &QTimer::timeout, this, [this]() {
+            static int noDataCount = 0;
+            if (!running) return;
+            quint64 packets = rxPackets - lastRxPackets;
+            quint64 bytes = rxBytes - lastRxBytes;
+            lastRxPackets = rxPackets;
+            lastRxBytes = rxBytes;
+            emit receiveRateUpdated(static_cast<double>(packets), bytes * 8.0 / 1e6);
+#ifdef Q_OS_LINUX
+            qint64 cpuNs = receiveThreadCpuNs();
+            double cpuPercent = (cpuNs - lastReceiveCpuNs) / 1e7; // ns per 1 s interval -> %
+            lastReceiveCpuNs = cpuNs;
+            double avgLatencyUs = 0.0, maxLatencyUs = 0.0;
+            if (!shards.empty()) {
+                // Mean of the shard averages, worst shard maximum
+                int reporting = 0;
+                for (auto& shard : shards) {
+                    double avgUs, maxUs;
+                    shard->engine->stats.latency.take(avgUs, maxUs);
+                    if (avgUs > 0.0) {
+                        avgLatencyUs += avgUs;
+                        reporting++;
+                    }
+                    maxLatencyUs = std::max(maxLatencyUs, maxUs);
+                }
+                if (reporting > 0) avgLatencyUs /= reporting;
+            } else {
+                (engine ? engine->stats.latency : qtStats.latency).take(avgLatencyUs, maxLatencyUs);
+            }
+            emit receiveLoadUpdated(cpuPercent, avgLatencyUs, maxLatencyUs);
+#endif
+            CaptureStats::Drops drops = collectDrops();
+            emit dropStatsUpdated(drops.kernel, drops.ringFull, drops.oversized, drops.shortReads);
+            // The event-loop receive paths fill the main ring from this thread: drain a spill while idle
+            if (ring && (receiveMode == QtSocketMode || receiveMode == RecvMmsgMode)) ring->restoreSpilled();
+            quint64 evicted = 0, blocked = 0, blockTimeouts = 0, spilled = 0, spillPending = 0, spillFailures = 0;
+            for (PacketRing* r : receiveRings(true)) {
+                const PacketRing::OverflowStats& overflow = r->overflowStats();
+                evicted += overflow.evicted.load(std::memory_order_relaxed);
+                blocked += overflow.blocked.load(std::memory_order_relaxed);
+                blockTimeouts += overflow.blockTimeouts.load(std::memory_order_relaxed);
+                quint64 restored = overflow.restored.load(std::memory_order_relaxed);
+                quint64 ringSpilled = overflow.spilled.load(std::memory_order_relaxed);
+                spilled += ringSpilled;
+                spillPending += ringSpilled > restored ? ringSpilled - restored : 0;
+                spillFailures += overflow.spillFailures.load(std::memory_order_relaxed);
+            }
+            emit overflowStatsUpdated(evicted, blocked, blockTimeouts, spilled, spillPending, spillFailures);
+            if (dropLog) {
+                QTextStream out(dropLog);
+                out << wallClockNs() / 1000000 << ',' << rxPackets.load() << ',' << drops.kernel << ','
+                    << drops.ringFull << ',' << drops.oversized << ',' << drops.shortReads << ','
+                    << evicted << ',' << blockTimeouts << ',' << spilled << ',' << spillPending << '\n';
+                out.flush();
+            }
+            if (sequenceField.valid()) {
+                quint64 lost = sequenceTracker.lost, duplicates = sequenceTracker.duplicates;
+                quint64 reordered = sequenceTracker.reordered, late = sequenceTracker.late;
+#ifdef Q_OS_LINUX
+                for (auto& shard : shards) {
+                    lost += shard->sequence.lost;
+                    duplicates += shard->sequence.duplicates;
+                    reordered += shard->sequence.reordered;
+                    late += shard->sequence.late;
+                }
+#endif
+                emit sequenceStatsUpdated(lost, duplicates, reordered, late);
+            }
+            if (!forwardReaders.empty()) {
+                quint64 skipped = forwardTorn;
+                for (const auto& reader : forwardReaders) skipped += reader.second->skipped();
+                emit forwardStatsUpdated(forwardedPackets, skipped);
+            }
+            if (packets > 0) {
                 noDataCount = 0;
             } else {
                 noDataCount++;
@@ -274,20 +348,599 @@ void UdpWorker::start(quint16 port_) {
                 }
 #endif
             }
-        }
-    });
+        });
+    }
     dataCheckTimer->start(1000); // Check every second
 }
 
 void UdpWorker::stop() {
     running = false;
+    if (dataCheckTimer) dataCheckTimer->stop();
+    detachForwarder(); // Its readers belong to rings that may go away below
     if (udpSocket) {
         udpSocket->close();
         udpSocket->deleteLater();
         udpSocket = nullptr;
     }
+#ifdef Q_OS_LINUX
+    stopNative();
+    stopStreams();
+#endif
+}
+
+void UdpWorker::setReceiveMode(int mode) {
+#ifndef Q_OS_LINUX
+    if (mode != QtSocketMode) {
+        emit errorOccurred("Native receive modes are only available on Linux");
+        return;
+    }
+#endif
+    if (mode == receiveMode) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        // The logger drains the rings that a mode change would replace
+        emit errorOccurred("Cannot change the receive mode while logging");
+        return;
+    }
+    receiveMode = mode;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Receive mode set to" << mode;
+#endif
+    // Rebind on the same port with the new receive path
+    bool wasStarted = udpSocket != nullptr;
+#ifdef Q_OS_LINUX
+    wasStarted = wasStarted || engine != nullptr || !shards.empty();
+#endif
+    if (wasStarted) {
+        stop();
+        start(port);
+    }
 }
 
+void UdpWorker::setShardCount(int count) {
+    count = std::max(1, count);
+    if (count == shardCount) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot change the shard count while logging");
+        return;
+    }
+    shardCount = count;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Shard count set to" << shardCount;
+#endif
+#ifdef Q_OS_LINUX
+    // Only the engine thread modes shard; rebind if one is active
+    if (engine || !shards.empty()) {
+        stop();
+        start(port);
+    }
+#endif
+}
+
+void UdpWorker::setRingCapacity(int megabytes) {
+    size_t bytes = static_cast<size_t>(std::max(1, megabytes)) << 20;
+    if (bytes == ringBytes) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot resize the ring buffer while logging");
+        return;
+    }
+    ringBytes = bytes;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Ring capacity set to" << megabytes << "MB";
+#endif
+    rebuildRing();
+}
+
+void UdpWorker::setMemoryPolicy(bool hugePages_, bool lockMemory_, bool numaLocal_) {
+#ifndef Q_OS_LINUX
+    if (hugePages_ || lockMemory_ || numaLocal_) {
+        emit errorOccurred("Huge pages, locked and NUMA-local memory are only available on Linux");
+        return;
+    }
+#endif
+    if (hugePages_ == hugePages && lockMemory_ == lockMemory && numaLocal_ == numaLocal) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot change the packet memory while logging");
+        return;
+    }
+    hugePages = hugePages_;
+    lockMemory = lockMemory_;
+    numaLocal = numaLocal_;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Packet memory: huge pages" << hugePages << "locked" << lockMemory << "NUMA local" << numaLocal;
+#endif
+    rebuildRing();
+}
+
+void UdpWorker::rebuildRing() {
+    // The receive paths create the ring on start; rebind if one is active
+    bool wasStarted = udpSocket != nullptr;
+#ifdef Q_OS_LINUX
+    wasStarted = wasStarted || engine != nullptr || !shards.empty();
+#endif
+    if (wasStarted) stop();
+    ring.reset();
+    if (wasStarted) start(port);
+}
+
+MemoryPolicy UdpWorker::memoryPolicy(int node) const {
+    MemoryPolicy policy;
+    policy.hugePages = hugePages;
+    policy.lock = lockMemory;
+    policy.numaNode = numaLocal ? node : -1;
+    return policy;
+}
+
+std::unique_ptr<PacketRing> UdpWorker::makeRing(size_t bytes, int node) {
+    auto r = std::make_unique<PacketRing>(bytes, MAX_PACKET_SIZE, memoryPolicy(node));
+    applyOverflowPolicy(*r);
+    return r;
+}
+
+void UdpWorker::applyOverflowPolicy(PacketRing& r) const {
+    r.setOverflowPolicy(static_cast<PacketRing::Overflow>(overflowPolicy), blockTimeoutMs * 1000, spillDirectory.toStdString());
+}
+
+std::vector<PacketRing*> UdpWorker::receiveRings(bool withStreams) const {
+    std::vector<PacketRing*> rings;
+    if (ring) rings.push_back(ring.get());
+#ifdef Q_OS_LINUX
+    for (auto& shard : shards) rings.push_back(shard->ring.get());
+    if (withStreams) {
+        for (auto& stream : streams) rings.push_back(stream->ring.get());
+    }
+#else
+    Q_UNUSED(withStreams);
+#endif
+    return rings;
+}
+
+void UdpWorker::setOverflowPolicy(int policy, int timeoutMs) {
+    if (policy < PacketRing::DropNewest || policy > PacketRing::Spill) return;
+    overflowPolicy = policy;
+    blockTimeoutMs = timeoutMs;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Ring overflow policy" << policy << "block timeout" << timeoutMs << "ms";
+#endif
+    // Takes effect on the running rings with their next packet
+    for (PacketRing* r : receiveRings(true)) applyOverflowPolicy(*r);
+}
+
+void UdpWorker::setPreRoll(int seconds, int megabytes) {
+    preRollSeconds = qMax(0, seconds);
+    preRollMegabytes = qMax(1, megabytes);
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Pre-roll" << preRollSeconds << "s, up to" << preRollMegabytes << "MB";
+#endif
+}
+
+void UdpWorker::attachLogger(PacketRing& r, size_t preRollBytes) {
+    // At most half the ring, so that live traffic has room while the logger catches up
+    r.setConsumerAttached(true, qint64(preRollSeconds) * 1000000000, qMin(preRollBytes, r.capacityBytes() / 2));
+}
+
+int UdpWorker::currentNumaNode() const {
+#ifdef Q_OS_LINUX
+    int cpu = sched_getcpu();
+    return cpu >= 0 ? numaNodeOfCpu(cpu) : -1;
+#else
+    return -1;
+#endif
+}
+
+void UdpWorker::reportMemory() {
+    QStringList lines;
+    if (ring) lines << "ring " + QString::fromStdString(ring->memoryReport().describe());
+#ifdef Q_OS_LINUX
+    for (size_t i = 0; i < shards.size(); ++i) {
+        lines << QString("shard %1 ring ").arg(i) + QString::fromStdString(shards[i]->ring->memoryReport().describe());
+    }
+    for (auto& stream : streams) {
+        lines << QString("stream %1 ring ").arg(stream->config.name) + QString::fromStdString(stream->ring->memoryReport().describe());
+    }
+#endif
+#ifdef ENABLE_DEBUG
+    for (const QString& line : lines) qDebug() << "[UdpWorker] Packet memory:" << line;
+#endif
+    emit memoryReportReady(lines.join("; "));
+}
+
+void UdpWorker::setForwardTarget(const QString& target) {
+    // "host:port" re-sends every received datagram there, unchanged; empty stops forwarding
+    QHostAddress address;
+    quint16 targetPort = 0;
+    if (!target.isEmpty()) {
+        int colon = target.lastIndexOf(':');
+        bool ok = false;
+        targetPort = colon > 0 ? target.mid(colon + 1).toUShort(&ok) : 0;
+        if (!ok || targetPort == 0 || !address.setAddress(target.left(colon))) {
+            emit errorOccurred(QString("Invalid forward target '%1', expected host:port").arg(target));
+            return;
+        }
+    }
+    detachForwarder();
+    forwardAddress = address;
+    forwardPort = targetPort;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Forwarding" << (forwardPort ? target : QString("disabled"));
+#endif
+    if (running) attachForwarder();
+}
+
+void UdpWorker::attachForwarder() {
+    if (!forwardPort || !forwardReaders.empty()) return;
+    // The forwarder is an optional reader: it reads the packet bytes where they were received
+    // and never holds the receive path back; if it falls a lap behind, it skips ahead
+    for (PacketRing* r : receiveRings(false)) {
+        if (PacketRing::Reader* reader = r->attachReader(false)) forwardReaders.emplace_back(r, reader);
+    }
+    if (!forwardSocket) forwardSocket = new QUdpSocket(this);
+    if (!forwardTimer) {
+        forwardTimer = new QTimer(this);
+        connect(forwardTimer, &QTimer::timeout, this, &UdpWorker::forwardPackets);
+    }
+    forwardedPackets = 0;
+    forwardTorn = 0;
+    forwardTimer->start(FORWARD_INTERVAL_MS);
+}
+
+void UdpWorker::detachForwarder() {
+    if (forwardTimer) forwardTimer->stop();
+    for (const auto& reader : forwardReaders) reader.first->detachReader(reader.second);
+    forwardReaders.clear();
+}
+
+void UdpWorker::forwardPackets() {
+    Packet batch[LoggingManager::POP_BATCH];
+    for (const auto& reader : forwardReaders) {
+        for (int sent = 0; sent < FORWARD_BATCH;) {
+            int count = reader.second->popBatch(batch, LoggingManager::POP_BATCH);
+            if (count == 0) break;
+            for (int i = 0; i < count; ++i) {
+                forwardSocket->writeDatagram(batch[i].data, batch[i].size, forwardAddress, forwardPort);
+            }
+            sent += count;
+            // The socket copied them; if the producer lapped us meanwhile, some may have gone out torn
+            if (reader.second->intact()) forwardedPackets += count;
+            else forwardTorn += count;
+        }
+    }
+}
+
+void UdpWorker::setCaptureBackend(int backend, const QString& interfaceName) {
+#ifndef Q_OS_LINUX
+    if (backend != CaptureSocket) {
+        emit errorOccurred("Packet capture backends are only available on Linux");
+        return;
+    }
+#endif
+    if (backend == captureBackend && interfaceName == captureInterface) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot change the capture backend while logging");
+        return;
+    }
+    captureBackend = backend;
+    captureInterface = interfaceName;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Capture backend set to" << backend << "on" << (interfaceName.isEmpty() ? "all interfaces" : interfaceName);
+#endif
+#ifdef Q_OS_LINUX
+    // Only the engine thread modes use a capture backend; rebind if one is active
+    if (engine && engine->threadRunning()) {
+        stop();
+        start(port);
+    }
+#endif
+}
+
+void UdpWorker::setStreams(const QList<StreamConfig>& streams_) {
+#ifndef Q_OS_LINUX
+    if (!streams_.isEmpty()) {
+        emit errorOccurred("Additional streams are only available on Linux");
+        return;
+    }
+#endif
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot change the streams while logging");
+        return;
+    }
+    streamConfigs = streams_;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Configured" << streamConfigs.size() << "additional streams";
+#endif
+#ifdef Q_OS_LINUX
+    if (running) {
+        stopStreams();
+        startStreams();
+        trackReceiveThreads();
+    }
+#endif
+}
+
+void UdpWorker::setUdpGro(bool enable) {
+#ifndef Q_OS_LINUX
+    if (enable) {
+        emit errorOccurred("UDP GRO is only available on Linux");
+        return;
+    }
+#endif
+    if (enable == udpGro) return;
+    if (loggingManager && loggingManager->isRunning()) {
+        emit errorOccurred("Cannot change UDP GRO while logging");
+        return;
+    }
+    udpGro = enable;
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] UDP GRO" << (enable ? "enabled" : "disabled");
+#endif
+#ifdef Q_OS_LINUX
+    // QUdpSocket mode reads one datagram at a time and is left alone; rebind native sockets
+    if (engine || !shards.empty()) {
+        stop();
+        start(port);
+    }
+#endif
+}
+
+#ifdef Q_OS_LINUX
+ReceiveEngine::Policy UdpWorker::enginePolicy() const {
+    return receiveMode == EngineBusyPollMode ? ReceiveEngine::Policy::BusyPoll
+         : receiveMode == EngineEpollMode ? ReceiveEngine::Policy::Epoll
+         : ReceiveEngine::Policy::Hybrid;
+}
+
+bool UdpWorker::startNative(quint16 port_) {
+    // The recvmmsg mode is always a plain socket; the engine thread modes use the selected backend
+    bool engineThread = receiveMode != RecvMmsgMode;
+    auto backend = engineThread ? static_cast<ReceiveEngine::Backend>(captureBackend) : ReceiveEngine::Backend::Socket;
+    if (engineThread && shardCount > 1) {
+        if (backend == ReceiveEngine::Backend::Socket) {
+            return startShards(port_, enginePolicy());
+        }
+        emit errorOccurred("Shards need the socket backend; using one receive thread");
+    }
+
+    if (!ring) ring = makeRing(ringBytes, currentNumaNode());
+    engine = std::make_unique<ReceiveEngine>(*ring, backend);
+    CaptureConfig config;
+    config.port = port_;
+    config.interfaceName = captureInterface.toStdString();
+    config.gro = udpGro && backend == ReceiveEngine::Backend::Socket;
+    std::string error;
+    if (!engine->open(config, error)) {
+        emit errorOccurred(QString::fromStdString(error));
+        engine.reset();
+        return false;
+    }
+
+    // Batches are parsed in place, straight from their ring slots (or capture buffers)
+    engine->setHandlers([this](const ReceiveEngine::Datagram* datagrams, int count) {
+        std::shared_lock<std::shared_mutex> lock(configMutex);
+        quint64 bytes = 0;
+        for (int i = 0; i < count; ++i) {
+            parseDatagram(datagrams[i].data, datagrams[i].size, nativeValues);
+            sequenceTracker.observe(datagrams[i].data, datagrams[i].size, datagrams[i].source, sequenceField);
+            bytes += datagrams[i].size;
+        }
+        publishValues(nativeValues);
+        rxPackets.fetch_add(count, std::memory_order_relaxed);
+        rxBytes.fetch_add(bytes, std::memory_order_relaxed);
+    });
+
+    if (receiveMode == RecvMmsgMode) {
+        nativeNotifier = new QSocketNotifier(engine->fd(), QSocketNotifier::Read, this);
+        connect(nativeNotifier, &QSocketNotifier::activated, this, &UdpWorker::processNativeDatagrams);
+    } else {
+        if (!engine->startThread(enginePolicy(), error)) {
+            emit errorOccurred(QString::fromStdString(error));
+            engine.reset();
+            return false;
+        }
+        // Keep the receive thread next to its ring
+        if (numaLocal && ring->memoryReport().node >= 0) engine->pinThreadToNode(ring->memoryReport().node);
+    }
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Native receive path bound to port" << port_ << "mode" << receiveMode
+             << "backend" << static_cast<int>(backend) << "batch size" << ReceiveEngine::BATCH_SIZE;
+#endif
+    return true;
+}
+
+void UdpWorker::stopNative() {
+    if (nativeNotifier) {
+        nativeNotifier->setEnabled(false);
+        nativeNotifier->deleteLater();
+        nativeNotifier = nullptr;
+    }
+    if (engine) {
+        // Logged packets may still point into the capture buffers that close() unmaps
+        if (engine->lendsBuffers() && loggingManager && loggingManager->isRunning()) {
+            stopLogging();
+        }
+        engine->close(); // Joins the engine thread, if any
+        engine.reset();
+    }
+    nativeValues.clear();
+    if (mergeTimer) mergeTimer->stop();
+    for (auto& shard : shards) {
+        shard->engine->close();
+    }
+    shards.clear();
+}
+
+bool UdpWorker::startShards(quint16 port_, ReceiveEngine::Policy policy) {
+    // The shards split the main ring's byte budget between them
+    ring.reset();
+    size_t bytesPerShard = std::max(MIN_RING_BYTES, ringBytes / shardCount);
+    int cpuCount = std::max(1, QThread::idealThreadCount());
+    std::string error;
+
+    for (int i = 0; i < shardCount; ++i) {
+        auto shard = std::make_unique<ReceiveShard>();
+        // Each ring sits on the node of the CPU its thread is pinned to below
+        shard->ring = makeRing(bytesPerShard, numaNodeOfCpu(i % cpuCount));
+        shard->engine = std::make_unique<ReceiveEngine>(*shard->ring);
+        CaptureConfig config;
+        config.port = port_;
+        config.reusePort = true;
+        config.gro = udpGro;
+        if (!shard->engine->open(config, error)) {
+            emit errorOccurred(QString("Shard %1: %2").arg(i).arg(QString::fromStdString(error)));
+            stopNative();
+            return false;
+        }
+        ReceiveShard* s = shard.get();
+        s->values.reserve(plan, MAX_PACKET_SIZE / std::max(structSize, 1));
+        s->engine->setHandlers([this, s](const ReceiveEngine::Datagram* datagrams, int count) {
+            std::shared_lock<std::shared_mutex> lock(configMutex);
+            quint64 bytes = 0;
+            for (int k = 0; k < count; ++k) {
+                parseDatagram(datagrams[k].data, datagrams[k].size, s->values);
+                s->sequence.observe(datagrams[k].data, datagrams[k].size, datagrams[k].source, sequenceField);
+                bytes += datagrams[k].size;
+            }
+            // Hand the batch to mergeTimer as a timestamped chunk; without room for its
+            // entry the values are dropped too, so that the two rings stay in step
+            if (s->values.rows() > 0 && s->chunks.room() > 0) {
+                size_t pushed = s->samples.push(s->values.column(plotColumn), s->values.size(plotColumn));
+                if (pushed > 0) s->chunks.push(ShardChunk{datagrams[0].timestampNs, pushed});
+            }
+            s->values.clear();
+            rxPackets.fetch_add(count, std::memory_order_relaxed);
+            rxBytes.fetch_add(bytes, std::memory_order_relaxed);
+        });
+        shards.push_back(std::move(shard));
+    }
+
+    // Bind all sockets before any thread starts so the kernel's flow spread is stable
+    for (int i = 0; i < shardCount; ++i) {
+        if (!shards[i]->engine->startThread(policy, error)) {
+            emit errorOccurred(QString("Shard %1: %2").arg(i).arg(QString::fromStdString(error)));
+            stopNative();
+            return false;
+        }
+        shards[i]->engine->pinThread(i % cpuCount);
+    }
+
+    if (!mergeTimer) {
+        mergeTimer = new QTimer(this);
+        connect(mergeTimer, &QTimer::timeout, this, &UdpWorker::mergeShardValues);
+    }
+    mergeTimer->start(SHARD_MERGE_MS);
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Started" << shardCount << "SO_REUSEPORT shards on port" << port_
+             << "with" << (bytesPerShard >> 20) << "MB rings";
+#endif
+    return true;
+}
+
+void UdpWorker::mergeShardValues() {
+    // Repeatedly take the oldest chunk across shards. A shard with nothing queued may still
+    // be parsing older values, so only release chunks older than the merge slack.
+    qint64 releaseBefore = wallClockNs() - SHARD_MERGE_SLACK_NS;
+    if (mergeValues.empty()) mergeValues.resize(4096);
+    for (;;) {
+        ReceiveShard* oldest = nullptr;
+        ShardChunk oldestChunk{0, 0};
+        bool anyEmpty = false;
+        for (auto& shard : shards) {
+            ShardChunk chunk;
+            if (!shard->chunks.front(chunk)) {
+                anyEmpty = true;
+            } else if (!oldest || chunk.timestampNs < oldestChunk.timestampNs) {
+                oldest = shard.get();
+                oldestChunk = chunk;
+            }
+        }
+        if (!oldest || (anyEmpty && oldestChunk.timestampNs >= releaseBefore)) break;
+        oldest->chunks.skip(1);
+        for (size_t left = oldestChunk.count; left > 0;) {
+            size_t n = oldest->samples.pop(mergeValues.data(), std::min(left, mergeValues.size()));
+            if (n == 0) break;
+            uiSamples.push(mergeValues.data(), n);
+            left -= n;
+        }
+    }
+}
+
+void UdpWorker::startStreams() {
+    std::vector<ReceiveEngine*> engines;
+    for (int i = 0; i < streamConfigs.size(); ++i) {
+        const StreamConfig& cfg = streamConfigs[i];
+        auto stream = std::make_unique<ReceiveStream>();
+        stream->config = cfg;
+        stream->ring = makeRing(STREAM_RING_BYTES, -1);
+        stream->engine = std::make_unique<ReceiveEngine>(*stream->ring);
+        CaptureConfig config;
+        config.port = cfg.port;
+        config.multicastGroup = cfg.multicastGroup.toStdString();
+        config.interfaceName = cfg.interfaceName.toStdString();
+        std::string error;
+        if (!stream->engine->open(config, error)) {
+            // A stream that cannot bind is reported and left out; the others still run
+            emit errorOccurred(QString("Stream %1: %2").arg(cfg.name).arg(QString::fromStdString(error)));
+            continue;
+        }
+        stream->engine->setHandlers([this](const ReceiveEngine::Datagram* datagrams, int count) {
+            quint64 bytes = 0;
+            for (int k = 0; k < count; ++k) bytes += datagrams[k].size;
+            rxPackets.fetch_add(count, std::memory_order_relaxed);
+            rxBytes.fetch_add(bytes, std::memory_order_relaxed);
+        });
+        engines.push_back(stream->engine.get());
+        streams.push_back(std::move(stream));
+    }
+    if (engines.empty()) return;
+
+    // Half the cores at most, taken from the top so they stay clear of the shard threads
+    int cpuCount = std::max(1, QThread::idealThreadCount());
+    int threadCount = std::min(static_cast<int>(engines.size()), std::max(1, cpuCount / 2));
+    ReceiveEngine::Policy policy = receiveMode == QtSocketMode || receiveMode == RecvMmsgMode
+                                 ? ReceiveEngine::Policy::Epoll : enginePolicy();
+    std::string error;
+    if (!streamScheduler.start(engines, threadCount, policy, error)) {
+        emit errorOccurred(QString::fromStdString(error));
+        stopStreams();
+        return;
+    }
+    streamScheduler.pinThreads(cpuCount - threadCount, cpuCount);
+#ifdef ENABLE_DEBUG
+    qDebug() << "[UdpWorker] Started" << streams.size() << "additional streams on" << threadCount << "receive threads";
+#endif
+}
+
+void UdpWorker::stopStreams() {
+    // Loggers pop from the stream rings, so they go first
+    stopStreamLogging();
+    streamScheduler.stop();
+    streams.clear();
+}
+
+void UdpWorker::trackReceiveThreads() {
+    // CPU usage is reported for whichever threads actually receive
+    receiveThreads.clear();
+    if (engine && engine->threadRunning()) {
+        receiveThreads.push_back(engine->nativeThread());
+    } else if (!shards.empty()) {
+        for (auto& shard : shards) receiveThreads.push_back(shard->engine->nativeThread());
+    } else {
+        receiveThreads.push_back(QThread::currentThread()->native_handle());
+    }
+    for (pthread_t thread : streamScheduler.nativeThreads()) receiveThreads.push_back(thread);
+    lastReceiveCpuNs = receiveThreadCpuNs();
+}
+
+qint64 UdpWorker::receiveThreadCpuNs() {
+    qint64 total = 0;
+    for (pthread_t thread : receiveThreads) {
+        clockid_t clockId;
+        timespec ts;
+        if (pthread_getcpuclockid(thread, &clockId) != 0 || clock_gettime(clockId, &ts) != 0) continue;
+        total += static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+    return total;
+}
+#endif
+
 void UdpWorker::setRunning(bool run) {
     running = run;
 }
@@ -297,17 +950,75 @@ void UdpWorker::startLogging(const QList<FieldDef>& fields, int structSize, int
         delete loggingManager;
         loggingManager = nullptr;
     }
-    loggingManager = new LoggingManager(fields, structSize, durationSec, filename, this);
+    stopStreamLogging();
+    LoggingManager::PacketSource source = [this](Packet* out, int maxCount) { return popFromRingBuffer(out, maxCount); };
+    if (sequenceField.valid()) {
+        // Restore each sender's sequence order before writing; gaps wait up to REORDER_HOLD_NS
+        auto upstream = [this](Packet& packet) { return popFromRingBuffer(&packet, 1) == 1; };
+        auto reorder = std::make_shared<ReorderBuffer>(upstream, sequenceField, REORDER_DEPTH, MAX_PACKET_SIZE, REORDER_HOLD_NS);
+        source = LoggingManager::onePerCall([reorder](Packet& packet) { return reorder->pop(packet); });
+    }
+    loggingManager = new LoggingManager(fields, structSize, durationSec, filename, source);
+    loggingManager->setDerivedChannels(parseDerivedChannels(derivedText, fields));
     
     // Enable binary mode if it was previously enabled
     if (binaryLoggingEnabled) {
         loggingManager->enableBinaryMode(true);
     }
+    loggingManager->setMemoryPolicy(memoryPolicy(ring ? ring->memoryReport().node : -1));
     
+    connect(loggingManager, &LoggingManager::loggingFinished, this, [this]() {
+        setRingConsumer(false);
+        closeDropLog();
+    });
     connect(loggingManager, &LoggingManager::loggingFinished, this, &UdpWorker::loggingFinished);
     connect(loggingManager, &LoggingManager::loggingError, this, &UdpWorker::loggingError);
     connect(loggingManager, &LoggingManager::conversionFinished, this, &UdpWorker::conversionFinished);
     loggingManager->start();
+    if (!loggingManager->isRunning()) return;
+    // A spill goes next to the log: a disk with room for it, unlike a tmpfs /tmp
+    spillDirectory = QFileInfo(filename).absolutePath();
+    for (PacketRing* r : receiveRings(true)) applyOverflowPolicy(*r);
+    setRingConsumer(true);
+    openDropLog(filename);
+
+#ifdef Q_OS_LINUX
+    // Each additional stream logs next to the main file, e.g. run.csv -> run_<stream>.csv
+    QFileInfo info(filename);
+    for (size_t i = 0; i < streams.size(); ++i) {
+        ReceiveStream* stream = streams[i].get();
+        if (stream->config.fields.isEmpty() || stream->config.structSize <= 0) continue;
+        QString name = stream->config.name.isEmpty() ? QString("stream%1").arg(i + 1) : stream->config.name;
+        QString streamFile = info.path() + "/" + info.completeBaseName() + "_" + name + "." + info.suffix();
+        PacketRing* streamRing = stream->ring.get();
+        attachLogger(*streamRing, size_t(preRollMegabytes) << 20);
+        stream->logger = new LoggingManager(stream->config.fields, stream->config.structSize, durationSec, streamFile,
+                                            [streamRing](Packet* out, int maxCount) { return streamRing->popBatch(out, maxCount); });
+        if (binaryLoggingEnabled) stream->logger->enableBinaryMode(true);
+        stream->logger->setMemoryPolicy(memoryPolicy(-1));
+        connect(stream->logger, &LoggingManager::loggingError, this, &UdpWorker::loggingError);
+        connect(stream->logger, &LoggingManager::loggingFinished, this, [this, stream, streamFile]() {
+            stream->ring->setConsumerAttached(false);
+            if (binaryLoggingEnabled) {
+                QString binaryFile = streamFile;
+                binaryFile.replace(".csv", ".bin");
+                stream->logger->convertBinaryToCSV(binaryFile, streamFile);
+            }
+        });
+        stream->logger->start();
+    }
+#endif
+}
+
+void UdpWorker::setRingConsumer(bool attached) {
+    // The logger starts at the next packet, or with the pre-roll. Once it detaches, what it left
+    // behind no longer holds the producer back, and capture buffers lent to the ring go back to
+    // the kernel; the packets stay in the ring as history until overwritten.
+    std::vector<PacketRing*> rings = receiveRings(false);
+    for (PacketRing* r : rings) {
+        if (attached) attachLogger(*r, (size_t(preRollMegabytes) << 20) / rings.size());
+        else r->setConsumerAttached(false);
+    }
 }
 
 void UdpWorker::stopLogging() {
@@ -316,6 +1027,20 @@ void UdpWorker::stopLogging() {
         delete loggingManager;
         loggingManager = nullptr;
     }
+    closeDropLog();
+    stopStreamLogging();
+}
+
+void UdpWorker::stopStreamLogging() {
+#ifdef Q_OS_LINUX
+    for (auto& stream : streams) {
+        if (!stream->logger) continue;
+        stream->logger->stop();
+        delete stream->logger;
+        stream->logger = nullptr;
+        stream->ring->setConsumerAttached(false);
+    }
+#endif
 }
 
 void UdpWorker::enableBinaryLogging(bool enable) {
@@ -339,43 +1064,83 @@ void UdpWorker::convertBinaryToCSV(const QString& binaryFile, const QString& csv
     }
 }
 
-void UdpWorker::pushToRingBuffer(const char* data, size_t size) {
-    int currentHead = ringHead.load(std::memory_order_relaxed);
-    int nextHead = (currentHead + 1) % RING_BUFFER_SIZE;
-    
-    // For high-rate data, drop packets if buffer is full instead of blocking
-    if (nextHead == ringTail.load(std::memory_order_acquire)) {
-        // Buffer is full, drop this packet for high-rate scenarios
-        static int dropCount = 0;
-        dropCount++;
-#ifdef ENABLE_DEBUG
-        if (dropCount % 1000 == 0) {
-            qWarning() << "[UdpWorker] Dropped" << dropCount << "packets due to full ring buffer";
-        }
+void UdpWorker::countRingDrop() {
+    // Buffer is full, drop this packet for high-rate scenarios
+    quint64 dropCount = qtStats.ringDrops.fetch_add(1, std::memory_order_relaxed) + 1;
+#ifdef ENABLE_DEBUG
+    if (dropCount % 1000 == 0) {
+        qWarning() << "[UdpWorker] Dropped" << dropCount << "packets due to full ring buffer";
+    }
+#else
+    Q_UNUSED(dropCount);
 #endif
-        return;
+}
+
+CaptureStats::Drops UdpWorker::collectDrops() {
+    CaptureStats::Drops drops;
+#ifdef Q_OS_LINUX
+    // QUdpSocket hands over no control messages, so its socket's drop count is polled
+    if (udpSocket) readSocketDrops(udpSocket->socketDescriptor(), qtStats);
+    std::vector<ReceiveEngine*> engines;
+    if (engine) engines.push_back(engine.get());
+    for (auto& shard : shards) engines.push_back(shard->engine.get());
+    for (auto& stream : streams) engines.push_back(stream->engine.get());
+    for (ReceiveEngine* e : engines) {
+        e->pollKernelDrops();
+        e->stats.addDropsTo(drops);
     }
-    
-    char* buffer = packetPool[currentHead].get();
-    memcpy(buffer, data, size);
-    ringBuffer[currentHead] = {buffer, size, QDateTime::currentMSecsSinceEpoch()};
-    ringHead.store(nextHead, std::memory_order_release);
-#ifdef ENABLE_DEBUG
-    qDebug() << "[UdpWorker] Pushed packet of size" << size << "to ring buffer at position" << currentHead;
 #endif
+    qtStats.addDropsTo(drops);
+    return drops;
 }
 
-bool UdpWorker::popFromRingBuffer(Packet& packet) {
-    int currentTail = ringTail.load(std::memory_order_relaxed);
-    if (currentTail == ringHead.load(std::memory_order_acquire)) {
-        return false; // Empty
+void UdpWorker::openDropLog(const QString& filename) {
+    closeDropLog();
+    QFileInfo info(filename);
+    dropLog = new QFile(info.path() + "/" + info.completeBaseName() + "_drops.csv", this);
+    if (!dropLog->open(QIODevice::WriteOnly | QIODevice::Text)) {
+        emit loggingError(QString("Cannot open drop log %1").arg(dropLog->fileName()));
+        delete dropLog;
+        dropLog = nullptr;
+        return;
     }
-    packet = ringBuffer[currentTail];
-    ringTail.store((currentTail + 1) % RING_BUFFER_SIZE, std::memory_order_release);
+    QTextStream(dropLog) << "time_ms,packets,kernel_drops,ring_full,oversized,short_reads,evicted,block_timeouts,spilled,spill_pending\n";
+}
+
+void UdpWorker::closeDropLog() {
+    if (!dropLog) return;
+    dropLog->close();
+    delete dropLog;
+    dropLog = nullptr;
+}
+
+int UdpWorker::popFromRingBuffer(Packet* out, int maxCount) {
+#ifdef Q_OS_LINUX
+    if (!shards.empty()) {
+        // Merge the shard rings in timestamp order (same slack rule as mergeShardValues).
+        // One packet per call: a second one from the same shard would release the first.
+        PacketRing* oldest = nullptr;
+        qint64 oldestTimestamp = 0;
+        bool anyEmpty = false;
+        for (auto& shard : shards) {
+            Packet head;
+            if (!shard->ring->peek(head)) {
+                anyEmpty = true;
+            } else if (!oldest || head.timestampNs < oldestTimestamp) {
+                oldest = shard->ring.get();
+                oldestTimestamp = head.timestampNs;
+            }
+        }
+        if (!oldest) return 0; // Empty
+        if (anyEmpty && oldestTimestamp >= wallClockNs() - SHARD_MERGE_SLACK_NS) return 0;
+        return oldest->pop(out[0]) ? 1 : 0;
+    }
+#endif
+    int count = ring ? ring->popBatch(out, maxCount) : 0;
 #ifdef ENABLE_DEBUG
-    qDebug() << "[UdpWorker] Popped packet of size" << packet.size << "from ring buffer at position" << currentTail;
+    if (count > 0) qDebug() << "[UdpWorker] Popped" << count << "packets from ring buffer";
 #endif
-    return true;
+    return count;
 }
 
 void UdpWorker::processPendingDatagrams() {
@@ -389,19 +1154,32 @@ void UdpWorker::processPendingDatagrams() {
     }
 #endif
     
-    QVector<float> allValues;
     const int MAX_BATCH = 1000;  // Reduced for more frequent updates
     int processed = 0;
+    // QUdpSocket does not expose the kernel's per-datagram timestamps, so the whole
+    // wakeup shares one clock read; the native modes carry SO_TIMESTAMPNS stamps instead
+    qint64 batchTimestampNs = wallClockNs();
     
     // Process all available datagrams with reasonable limits
     while (udpSocket->hasPendingDatagrams() && running && processed < MAX_BATCH) {
         qint64 size = udpSocket->pendingDatagramSize();
         if (size > MAX_PACKET_SIZE) {
             udpSocket->readDatagram(recvBuffer.data(), MAX_PACKET_SIZE); // Skip oversized packet
+            qtStats.truncated.fetch_add(1, std::memory_order_relaxed);
             continue;
         }
-        qint64 read = udpSocket->readDatagram(recvBuffer.data(), size);
-        if (read != size) continue;
+        // Read straight into the ring; if it is full, into scratch for the overflow policy
+        char* slot = ring->reserve(size);
+        bool inRing = slot != nullptr;
+        if (!inRing) slot = recvBuffer.data();
+        QHostAddress sender;
+        quint16 senderPort = 0;
+        qint64 read = udpSocket->readDatagram(slot, size, &sender, &senderPort);
+        if (read != size) {
+            qtStats.shortReads.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        quint64 source = sourceId(sender.toIPv4Address(), senderPort);
         
 #ifdef ENABLE_DEBUG
         static int totalReceived = 0;
@@ -411,30 +1189,67 @@ void UdpWorker::processPendingDatagrams() {
         }
 #endif
         
-        parseDatagram(recvBuffer.constData(), size, allValues);
-        pushToRingBuffer(recvBuffer.constData(), size);
+        parseDatagram(slot, size, qtValues);
+        sequenceTracker.observe(slot, size, source, sequenceField);
+        if (inRing) ring->commit(0, size, batchTimestampNs, source);
+        else if (!ring->push(slot, size, batchTimestampNs, source)) countRingDrop(); // Spilled unless dropped
+        rxBytes += size;
         processed++;
     }
+    rxPackets += processed;
+#ifdef Q_OS_LINUX
+    if (processed > 0) recordSocketLatency(udpSocket->socketDescriptor(), qtStats.latency);
+#endif
     
+    finishBatch(qtValues, processed);
+}
+
+void UdpWorker::processNativeDatagrams() {
+#ifdef Q_OS_LINUX
+    if (!running || !engine) return;
+
+    const int MAX_BATCH = 1000;  // Same per-wakeup budget as the QUdpSocket path
+    int processed = engine->drain(MAX_BATCH);
+#ifdef ENABLE_DEBUG
+    static int wakeCount = 0;
+    if (++wakeCount % 100 == 0) {
+        qDebug() << "[UdpWorker] recvmmsg wakeup #" << wakeCount << "drained" << processed << "datagrams";
+    }
+#endif
+
+    // The batch handler has already handed the values to the UI
+    Q_UNUSED(processed);
+#endif
+}
+
+void UdpWorker::publishValues(ColumnBuffers& values) {
+    // One bounded copy of the plot column into the UI ring; the scratch keeps its capacity
+    // for the next batch
+    if (values.rows() > 0) uiSamples.push(values.column(plotColumn), values.size(plotColumn));
+    values.clear();
+}
+
+void UdpWorker::finishBatch(ColumnBuffers& allValues, int processed) {
 #ifdef ENABLE_DEBUG
     if (processed > 0) {
         static int totalProcessed = 0;
         totalProcessed += processed;
         if (totalProcessed % 1000 == 0) { // Log every 1000 packets
-            qDebug() << "[UdpWorker] Total packets processed:" << totalProcessed << "with" << allValues.size() << "values";
+            qDebug() << "[UdpWorker] Total packets processed:" << totalProcessed << "with" << allValues.rows() << "values";
         }
     }
 #endif
     
-    if (!allValues.isEmpty()) {
+    if (allValues.rows() > 0) {
 #ifdef ENABLE_DEBUG
-        static int signalCount = 0;
-        signalCount++;
-        if (signalCount % 100 == 0) { // Log every 100 signals
-            qDebug() << "[UdpWorker] Emitting dataReceived signal #" << signalCount << "with" << allValues.size() << "values";
+        static int batchCount = 0;
+        batchCount++;
+        if (batchCount % 100 == 0) { // Log every 100 batches
+            qDebug() << "[UdpWorker] Publishing batch #" << batchCount << "with" << allValues.rows() << "values,"
+                     << uiSamples.dropped() << "dropped by the UI ring so far";
         }
 #endif
-        emit dataReceived(allValues);
+        publishValues(allValues);
     } else if (processed > 0) {
 #ifdef ENABLE_DEBUG
         qWarning() << "[UdpWorker] WARNING: Processed" << processed << "datagrams but extracted 0 values!";
@@ -443,56 +1258,39 @@ void UdpWorker::processPendingDatagrams() {
     
 #ifdef ENABLE_DEBUG
     // Check ring buffer status
-    int ringBufferSize = (ringHead.load() - ringTail.load() + RING_BUFFER_SIZE) % RING_BUFFER_SIZE;
+    int ringBufferSize = ring ? ring->size() : 0;
     if (ringBufferSize > 0) {
         qDebug() << "[UdpWorker] Ring buffer has" << ringBufferSize << "packets waiting";
     }
 #endif
 }
 
-void UdpWorker::parseDatagram(const char* data, qint64 size, QVector<float>& values) {
-    if (structSize <= 0 || selectedTypeSize == 0) {
+void UdpWorker::parseDatagram(const char* data, qint64 size, ColumnBuffers& values) {
+    if (plan.empty()) {
 #ifdef ENABLE_DEBUG
-        qWarning() << "[UdpWorker] parseDatagram: structSize=" << structSize << "selectedTypeSize=" << selectedTypeSize;
+        qWarning() << "[UdpWorker] parseDatagram: structSize=" << structSize << "no field to extract";
 #endif
         return;
     }
-    int numStructs = size / structSize;
-#ifdef ENABLE_DEBUG
-    qDebug() << "[UdpWorker] parseDatagram: size=" << size << "structSize=" << structSize << "numStructs=" << numStructs;
-#endif
-    
+    // Every selected value of every whole struct, appended to its column in one pass
+    size_t numStructs = plan.decode(data, static_cast<size_t>(size), values);
 #ifdef ENABLE_DEBUG
     // Always log the first few packets to see what's happening
     static int packetCount = 0;
     packetCount++;
     if (packetCount <= 5) {
         qDebug() << "[UdpWorker] Packet" << packetCount << ": size=" << size << "structSize=" << structSize << "numStructs=" << numStructs;
-        qDebug() << "[UdpWorker] selectedFieldOffset=" << selectedFieldOffset << "selectedTypeSize=" << selectedTypeSize;
-    }
-#endif
-    
-    for (int structIdx = 0; structIdx < numStructs; ++structIdx) {
-        int offset = structIdx * structSize + selectedFieldOffset;
-        if (offset + selectedTypeSize > size) break;
-        float value = converter(data + offset, endianness);
-        values.append(value);
-#ifdef ENABLE_DEBUG
-        if (structIdx < 3) {
-            qDebug() << "[UdpWorker] Struct" << structIdx << "offset" << offset << "value:" << value;
-        }
-        // Always log the first few values
-        if (packetCount <= 5 && structIdx < 3) {
-            qDebug() << "[UdpWorker] Extracted value:" << value << "at offset" << offset;
+        for (size_t c = 0; c < plan.columnCount() && numStructs > 0; ++c) {
+            qDebug() << "[UdpWorker] Column" << c << "offset" << plan.column(c).offset
+                     << "first value:" << values.column(c)[values.rows() - numStructs];
         }
-#endif
     }
-    if (values.isEmpty() && numStructs > 0) {
-#ifdef ENABLE_DEBUG
-        qWarning() << "[UdpWorker] WARNING: No values extracted from" << numStructs << "structs!";
-        qWarning() << "[UdpWorker] Check structSize=" << structSize << "selectedFieldOffset=" << selectedFieldOffset << "selectedTypeSize=" << selectedTypeSize;
-#endif
+    if (numStructs == 0 && size > 0) {
+        qWarning() << "[UdpWorker] WARNING: datagram of" << size << "bytes is shorter than structSize=" << structSize;
     }
+#else
+    Q_UNUSED(numStructs);
+#endif
 }
 
 void UdpWorker::onSocketError(QAbstractSocket::SocketError socketError) {
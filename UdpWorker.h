@@ -4,12 +4,29 @@
 #include <QHostAddress>
 #include <QVector>
 #include "FieldDef.h"
+#include "CompiledLayout.h"
+#include "DerivedChannel.h"
+#include "PacketRing.h"
+#include "CaptureStats.h"
+#include "StreamConfig.h"
+#include "SequenceTracker.h"
+#include "SpscRing.h"
 #include "mainwindow.h"
 #include <atomic>
 #include <vector>
 #include <functional>
 #include <array>
 #include <memory>
+#include <shared_mutex>
+#include <chrono>
+#ifdef Q_OS_LINUX
+#include "ReceiveEngine.h"
+#include "ReceiveScheduler.h"
+#endif
+
+class QFile;
+class QSocketNotifier;
+class QTimer;
 
 class LoggingManager; // Forward declaration
 
@@ -19,22 +36,51 @@ public:
     explicit UdpWorker(QObject *parent = nullptr);
     ~UdpWorker();
 
-    struct Packet {
-        char* data = nullptr;
-        size_t size = 0;
-        qint64 timestamp = 0;
-    };
+    using Packet = PacketRing::Packet;
 
+    // selectedArrayIndex for plotting a whole array field: each struct's array, in order,
+    // as one sample stream
+    static constexpr int ALL_ELEMENTS = -1;
     void configure(const QString &structText, const QList<FieldDef> &fields, int structSize, bool endianness, int selectedField, int selectedArrayIndex, int selectedFieldCount);
-    void pushToRingBuffer(const char* data, size_t size);
-    bool popFromRingBuffer(Packet& packet);
+    // Up to maxCount packets for the logger, valid until the next call
+    int popFromRingBuffer(Packet* out, int maxCount);
+    // Values of the selected field for the plot, drained by the UI thread on its timer.
+    // Filled by whichever receive path is running; bounded, what does not fit is dropped.
+    SpscRing<float>& plotSamples() { return uiSamples; }
 
-    using ConverterFunc = std::function<float(const char*, bool)>;
+    // How datagrams are pulled off the socket
+    enum ReceiveMode {
+        QtSocketMode = 0,       // QUdpSocket readyRead + readDatagram (portable)
+        RecvMmsgMode = 1,       // Native fd + recvmmsg batches on the Qt event loop (Linux only)
+        EngineBusyPollMode = 2, // ReceiveEngine thread, spinning with SO_BUSY_POLL (Linux only)
+        EngineEpollMode = 3,    // ReceiveEngine thread, blocking in epoll_wait (Linux only)
+        EngineHybridMode = 4    // ReceiveEngine thread, spin then block (Linux only)
+    };
+
+    // Where the engine thread modes capture from (see CaptureBackend::Kind)
+    enum CaptureBackendKind {
+        CaptureSocket = 0,      // UDP socket with recvmmsg
+        CapturePacketMmap = 1,  // AF_PACKET TPACKET_V3 mmap ring, zero-copy (Linux, root)
+        CaptureXdp = 2          // AF_XDP generic mode, zero-copy (Linux, root, needs an interface)
+    };
 
 public slots:
     void start(quint16 port);
     void stop();
     void setRunning(bool run);
+    void setReceiveMode(int mode);
+    void setShardCount(int count);
+    void setRingCapacity(int megabytes);
+    void setMemoryPolicy(bool hugePages, bool lockMemory, bool numaLocal);
+    void setOverflowPolicy(int policy, int blockTimeoutMs);
+    void setPreRoll(int seconds, int megabytes);
+    void setForwardTarget(const QString& target);
+    void setCaptureBackend(int backend, const QString& interfaceName);
+    void setStreams(const QList<StreamConfig>& streams);
+    void setUdpGro(bool enable);
+    void setSequenceField(int field);
+    // "name = expression" lines (see parseDerivedChannels), compiled by the next configure()
+    void setDerivedChannels(const QString& text);
     void updateConfig(const QString &structText, const QList<FieldDef> &fields, int structSize, bool endianness, int selectedField, int selectedArrayIndex, int selectedFieldCount);
     void sendDatagram(const QByteArray &data, const QHostAddress &addr, quint16 port);
     void startLogging(const QList<FieldDef>& fields, int structSize, int durationSec, const QString& filename);
@@ -44,12 +90,26 @@ public slots:
 
 private slots:
     void processPendingDatagrams();
+    void processNativeDatagrams();
     void onSocketError(QAbstractSocket::SocketError socketError);
+    void forwardPackets();
 
 signals:
-    void dataReceived(QVector<float> values); // Send parsed values to UI
     void ackReceived(quint8 ack);
     void errorOccurred(const QString &msg);
+    void receiveRateUpdated(double packetsPerSec, double megabitsPerSec);
+    void receiveLoadUpdated(double cpuPercent, double avgLatencyUs, double maxLatencyUs);
+    // Totals since start(), per pipeline stage: kernel socket buffer / capture ring, full
+    // PacketRing, oversized datagrams, short reads
+    void dropStatsUpdated(quint64 kernel, quint64 ringFull, quint64 oversized, quint64 shortReads);
+    void sequenceStatsUpdated(quint64 lost, quint64 duplicates, quint64 reordered, quint64 late);
+    // What the ring memory actually got (pages, locking, node), once per start
+    void memoryReportReady(const QString& report);
+    // Totals of the rings' overflow policy counters (see PacketRing::OverflowStats)
+    void overflowStatsUpdated(quint64 evicted, quint64 blocked, quint64 blockTimeouts,
+                              quint64 spilled, quint64 spillPending, quint64 spillFailures);
+    // Datagrams re-sent to the forward target, and those lapped (skipped or sent torn)
+    void forwardStatsUpdated(quint64 forwarded, quint64 skipped);
     void loggingFinished();
     void loggingError(const QString& msg);
     void conversionFinished();
@@ -58,6 +118,91 @@ private:
     QUdpSocket *udpSocket = nullptr;
     bool running = false;
     quint16 port = 0;
+    int receiveMode = QtSocketMode;
+    int captureBackend = CaptureSocket;
+    QString captureInterface; // Empty: all interfaces (AF_PACKET only)
+    bool udpGro = false; // UDP_GRO on native sockets (recvmmsg and socket-backend engine modes)
+    QTimer* dataCheckTimer = nullptr;
+    std::atomic<quint64> rxPackets{0};  // Totals since start(), sampled by dataCheckTimer
+    std::atomic<quint64> rxBytes{0};
+    quint64 lastRxPackets = 0;
+    quint64 lastRxBytes = 0;
+    std::shared_mutex configMutex; // Guards the parse configuration against ReceiveEngine threads
+    void finishStart();
+    void finishBatch(ColumnBuffers& values, int processed);
+    // UI hand-off: about a second of samples at 1 MS/s, allocated once
+    static constexpr size_t UI_SAMPLE_CAPACITY = size_t(1) << 20;
+    SpscRing<float> uiSamples{UI_SAMPLE_CAPACITY};
+    ColumnBuffers qtValues; // Parse scratch of the QUdpSocket path, kept between batches
+    void publishValues(ColumnBuffers& values);
+    // Attaches the logger as the rings' primary (required) reader, or detaches it
+    void setRingConsumer(bool attached);
+    // Forwarding: an optional reader per ring re-sends the raw datagrams
+    QHostAddress forwardAddress;
+    quint16 forwardPort = 0; // 0: off
+    QUdpSocket* forwardSocket = nullptr;
+    QTimer* forwardTimer = nullptr;
+    std::vector<std::pair<PacketRing*, PacketRing::Reader*>> forwardReaders;
+    quint64 forwardedPackets = 0;
+    quint64 forwardTorn = 0;
+    static constexpr int FORWARD_INTERVAL_MS = 1;
+    static constexpr int FORWARD_BATCH = 4096; // Per ring and tick
+    void attachForwarder();
+    void detachForwarder();
+#ifdef Q_OS_LINUX
+    // Native receive paths (recvmmsg on the event loop, or a dedicated ReceiveEngine thread)
+    std::unique_ptr<ReceiveEngine> engine;
+    QSocketNotifier* nativeNotifier = nullptr;
+    ColumnBuffers nativeValues; // Parse scratch of the engine batch handler
+    bool startNative(quint16 port);
+    void stopNative();
+    ReceiveEngine::Policy enginePolicy() const;
+
+    // SO_REUSEPORT sharding: N sockets on one port, each with its own engine thread and ring.
+    // Consumers merge the shard rings back into timestamp order.
+    struct ShardChunk {
+        qint64 timestampNs; // Receive time of the batch's first datagram
+        size_t count;       // Its values in ReceiveShard::samples
+    };
+    static constexpr size_t SHARD_SAMPLE_CAPACITY = size_t(1) << 18;
+    static constexpr size_t SHARD_CHUNK_CAPACITY = 4096;
+    struct ReceiveShard {
+        std::unique_ptr<PacketRing> ring;
+        std::unique_ptr<ReceiveEngine> engine;
+        SequenceTracker sequence; // The kernel keeps each sender on one shard
+        ColumnBuffers values; // Shard thread only: parse scratch for one batch
+        // Parsed values, and per batch its timestamp and value count, for mergeTimer
+        SpscRing<float> samples{SHARD_SAMPLE_CAPACITY};
+        SpscRing<ShardChunk> chunks{SHARD_CHUNK_CAPACITY};
+    };
+    std::vector<std::unique_ptr<ReceiveShard>> shards;
+    int shardCount = 1;
+    QTimer* mergeTimer = nullptr;
+    static constexpr int SHARD_MERGE_MS = 5;
+    std::vector<float> mergeValues; // Scratch for moving chunks into uiSamples
+    static constexpr qint64 SHARD_MERGE_SLACK_NS = 5000000; // How long an idle shard may hold back the merge
+    bool startShards(quint16 port, ReceiveEngine::Policy policy);
+    void mergeShardValues();
+
+    // Additional streams: a socket, ring and logger each, serviced by a shared thread pool.
+    // Their traffic counts towards the receive rate; only the main stream is plotted.
+    struct ReceiveStream {
+        StreamConfig config;
+        std::unique_ptr<PacketRing> ring;
+        std::unique_ptr<ReceiveEngine> engine;
+        LoggingManager* logger = nullptr;
+    };
+    std::vector<std::unique_ptr<ReceiveStream>> streams;
+    ReceiveScheduler streamScheduler;
+    static constexpr size_t STREAM_RING_BYTES = size_t(16) << 20;
+    void startStreams();
+    void stopStreams();
+    // Receive thread load: CPU time of the receiving thread and kernel-to-user latency
+    std::vector<pthread_t> receiveThreads; // Threads whose CPU time is reported
+    qint64 lastReceiveCpuNs = 0;
+    qint64 receiveThreadCpuNs();
+    void trackReceiveThreads();
+#endif
     QString structText;
     QList<FieldDef> fields;
     int structSize = 0;
@@ -65,21 +210,64 @@ private:
     int selectedField = -1;
     int selectedArrayIndex = 0;
     int selectedFieldCount = 1;
-    QVector<int> fieldOffsets; // Precomputed offsets for each field
-    QVector<int> fieldSizes;      // Precomputed sizes for each field
-    QVector<int> fieldAlignments; // Precomputed alignments for each field
-    int selectedTypeSize = 0;
-    int selectedFieldOffset = 0;
-    ConverterFunc converter;
-    void parseDatagram(const char* data, qint64 size, QVector<float>& values); // Zero-copy version
+    CompiledLayout layout; // Offsets and types of the fields, built once per configure()
+    // Virtual channels after the fields: selectedField fields.size() + d plots channel d
+    QString derivedText;
+    QList<DerivedChannel> derivedChannels;
+    // Compiled from the layout: every struct's selected values decoded in one pass into
+    // per-column buffers, derived channels computed from them. Column plotColumn is the
+    // plotted field element or channel.
+    ExtractionPlan plan;
+    size_t plotColumn = 0;
+    void reserveParseScratch();
+    // Sequence counter tracking: gaps, duplicates and reordering per sender, on every struct
+    int sequenceFieldIndex = -1;
+    SequenceField sequenceField; // Resolved from the field layout under configMutex
+    SequenceTracker sequenceTracker; // Main receive path (Qt socket, recvmmsg or engine thread)
+    void resolveSequenceField();
+    void resetSequenceTracking();
+    // Logging restores sequence order through a small window before writing
+    static constexpr int REORDER_DEPTH = 64;
+    static constexpr qint64 REORDER_HOLD_NS = 10000000;
+    void parseDatagram(const char* data, qint64 size, ColumnBuffers& values); // Zero-copy version
     void parseDatagram(const QByteArray &datagram, QVector<float> &values); // Old version (optional)
     LoggingManager* loggingManager = nullptr;
+    QList<StreamConfig> streamConfigs;
+    void stopStreamLogging();
     bool binaryLoggingEnabled = false;  // Track binary logging state
-    static constexpr int RING_BUFFER_SIZE = 65536;  // Increased to 65536 for high-rate data
     static constexpr int MAX_PACKET_SIZE = 65536;
-    std::array<Packet, RING_BUFFER_SIZE> ringBuffer;
-    std::vector<std::unique_ptr<char[]>> packetPool;
-    QByteArray recvBuffer;
-    std::atomic<int> ringHead{0};
-    std::atomic<int> ringTail{0};
+    static constexpr int DEFAULT_RING_MB = 256;
+    static constexpr size_t MIN_RING_BYTES = size_t(4) << 20; // Per shard
+    size_t ringBytes = size_t(DEFAULT_RING_MB) << 20; // Packet ring capacity, split across shards
+    std::unique_ptr<PacketRing> ring; // Sockets read straight into it; released while sharded
+    // Packet memory options for the rings and logger write buffers
+    bool hugePages = false;
+    bool lockMemory = false;
+    bool numaLocal = false; // Rings on the node of their receive thread
+    MemoryPolicy memoryPolicy(int node) const;
+    int currentNumaNode() const;
+    // What the rings do when the logger falls behind (PacketRing::Overflow)
+    int overflowPolicy = PacketRing::DropNewest;
+    int blockTimeoutMs = PacketRing::DEFAULT_BLOCK_TIMEOUT_US / 1000;
+    QString spillDirectory; // Next to the current log; empty: the system's temporary directory
+    std::unique_ptr<PacketRing> makeRing(size_t bytes, int node);
+    void applyOverflowPolicy(PacketRing& r) const;
+    // Retroactive capture: a log starts with what the rings still hold of the last
+    // preRollSeconds, up to preRollMegabytes across the main rings (each stream's on its own)
+    static constexpr int DEFAULT_PRE_ROLL_MB = 64;
+    int preRollSeconds = 0; // 0: from the next packet
+    int preRollMegabytes = DEFAULT_PRE_ROLL_MB;
+    void attachLogger(PacketRing& r, size_t preRollBytes);
+    // The main ring, or the shard rings; with streams, their rings too
+    std::vector<PacketRing*> receiveRings(bool withStreams) const;
+    void rebuildRing();
+    void reportMemory();
+    QByteArray recvBuffer; // Scratch target for packets that find the ring full
+    CaptureStats qtStats; // Drops and latency of the QUdpSocket path
+    void countRingDrop();
+    CaptureStats::Drops collectDrops();
+    // While logging, the drop counters are also written once a second to <log>_drops.csv
+    QFile* dropLog = nullptr;
+    void openDropLog(const QString& filename);
+    void closeDropLog();
 }; 
\ No newline at end of file
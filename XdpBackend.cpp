@@ -0,0 +1,301 @@
+#include "XdpBackend.h"
+#include <arpa/inet.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+namespace {
+long bpf(int cmd, bpf_attr& attr) {
+    return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+}
+
+bpf_insn insn(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+    bpf_insn i{};
+    i.code = code;
+    i.dst_reg = dst;
+    i.src_reg = src;
+    i.off = off;
+    i.imm = imm;
+    return i;
+}
+}
+
+XdpBackend::XdpBackend(PacketRing& ring, CaptureStats& stats) : CaptureBackend(ring, stats) {
+    datagrams.resize(BATCH_SIZE);
+    frames.resize(BATCH_SIZE);
+}
+
+XdpBackend::~XdpBackend() {
+    close();
+}
+
+bool XdpBackend::open(const CaptureConfig& config, std::string& error) {
+    if (xskFd >= 0) return true;
+    port = config.port;
+    if (config.interfaceName.empty()) {
+        error = "AF_XDP needs an interface name";
+        return false;
+    }
+    int ifindex = if_nametoindex(config.interfaceName.c_str());
+    if (ifindex == 0) {
+        error = "Unknown interface " + config.interfaceName;
+        return false;
+    }
+    if (!setUpSocket(ifindex, error) || !attachProgram(ifindex, error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool XdpBackend::setUpSocket(int ifindex, std::string& error) {
+    xskFd = ::socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0);
+    if (xskFd < 0) {
+        error = std::string("Failed to create AF_XDP socket (needs root): ") + strerror(errno);
+        return false;
+    }
+
+    umemSize = static_cast<size_t>(FRAME_SIZE) * FRAME_COUNT;
+    void* mem = mmap(nullptr, umemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (mem == MAP_FAILED) {
+        error = std::string("Failed to allocate UMEM: ") + strerror(errno);
+        return false;
+    }
+    umem = static_cast<uint8_t*>(mem);
+
+    xdp_umem_reg reg{};
+    reg.addr = reinterpret_cast<uint64_t>(umem);
+    reg.len = umemSize;
+    reg.chunk_size = FRAME_SIZE;
+    int ringSize = FRAME_COUNT;
+    int completionSize = 64; // Required by bind() even though nothing is transmitted
+    if (setsockopt(xskFd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) != 0 ||
+        setsockopt(xskFd, SOL_XDP, XDP_UMEM_FILL_RING, &ringSize, sizeof(ringSize)) != 0 ||
+        setsockopt(xskFd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completionSize, sizeof(completionSize)) != 0 ||
+        setsockopt(xskFd, SOL_XDP, XDP_RX_RING, &ringSize, sizeof(ringSize)) != 0) {
+        error = std::string("Failed to set up UMEM rings: ") + strerror(errno);
+        return false;
+    }
+
+    xdp_mmap_offsets off{};
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(xskFd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) != 0) {
+        error = std::string("Failed to query ring offsets: ") + strerror(errno);
+        return false;
+    }
+    rxMapSize = off.rx.desc + FRAME_COUNT * sizeof(xdp_desc);
+    rxMap = mmap(nullptr, rxMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xskFd, XDP_PGOFF_RX_RING);
+    fillMapSize = off.fr.desc + FRAME_COUNT * sizeof(uint64_t);
+    fillMap = mmap(nullptr, fillMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, xskFd, XDP_UMEM_PGOFF_FILL_RING);
+    if (rxMap == MAP_FAILED || fillMap == MAP_FAILED) {
+        if (rxMap == MAP_FAILED) rxMap = nullptr;
+        if (fillMap == MAP_FAILED) fillMap = nullptr;
+        error = std::string("Failed to map AF_XDP rings: ") + strerror(errno);
+        return false;
+    }
+    rxProducer = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(rxMap) + off.rx.producer);
+    rxConsumer = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(rxMap) + off.rx.consumer);
+    rxDescs = reinterpret_cast<xdp_desc*>(static_cast<uint8_t*>(rxMap) + off.rx.desc);
+    fillProducer = reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(fillMap) + off.fr.producer);
+    fillAddrs = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(fillMap) + off.fr.desc);
+
+    // Every frame starts out with the kernel
+    fillHead = *fillProducer;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+        releaseBuffer(static_cast<uint64_t>(i) * FRAME_SIZE);
+    }
+    flushFill();
+
+    sockaddr_xdp addr{};
+    addr.sxdp_family = AF_XDP;
+    addr.sxdp_flags = XDP_COPY;
+    addr.sxdp_ifindex = ifindex;
+    addr.sxdp_queue_id = QUEUE_ID;
+    if (::bind(xskFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = std::string("Failed to bind AF_XDP socket: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool XdpBackend::attachProgram(int ifindex, std::string& error) {
+    bpf_attr attr{};
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = QUEUE_ID + 1;
+    mapFd = bpf(BPF_MAP_CREATE, attr);
+    if (mapFd < 0) {
+        error = std::string("Failed to create XSKMAP: ") + strerror(errno);
+        return false;
+    }
+    uint32_t key = QUEUE_ID;
+    uint32_t value = xskFd;
+    attr = bpf_attr{};
+    attr.map_fd = mapFd;
+    attr.key = reinterpret_cast<uint64_t>(&key);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    if (bpf(BPF_MAP_UPDATE_ELEM, attr) != 0) {
+        error = std::string("Failed to register the AF_XDP socket: ") + strerror(errno);
+        return false;
+    }
+
+    // r1 = xdp_md. Redirect untagged IPv4 (no options, unfragmented) UDP to our port into
+    // xskmap[rx_queue_index]; anything else, or a queue without a socket, gets XDP_PASS.
+    std::vector<bpf_insn> prog;
+    std::vector<size_t> toPass;
+    auto jumpToPass = [&](bpf_insn i) { toPass.push_back(prog.size()); prog.push_back(i); };
+    prog.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0));            // r6 = ctx
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_W, 2, 1, 0, 0));              // r2 = data
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_W, 3, 1, 4, 0));              // r3 = data_end
+    prog.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_X, 4, 2, 0, 0));
+    prog.push_back(insn(BPF_ALU64 | BPF_ADD | BPF_K, 4, 0, 0, 14 + 20 + 8)); // Ethernet + IP + UDP
+    jumpToPass(insn(BPF_JMP | BPF_JGT | BPF_X, 4, 3, 0, 0));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 12, 0));             // EtherType
+    jumpToPass(insn(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 0, htons(ETH_P_IP)));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_B, 5, 2, 14, 0));             // Version and IHL
+    jumpToPass(insn(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 0, 0x45));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_B, 5, 2, 14 + 9, 0));         // Protocol
+    jumpToPass(insn(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 0, IPPROTO_UDP));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 14 + 6, 0));         // Flags and fragment offset
+    prog.push_back(insn(BPF_ALU64 | BPF_AND | BPF_K, 5, 0, 0, htons(0x3fff)));
+    jumpToPass(insn(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 0, 0));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 14 + 20 + 2, 0));    // UDP destination port
+    jumpToPass(insn(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 0, htons(port)));
+    prog.push_back(insn(BPF_LDX | BPF_MEM | BPF_W, 2, 6, 16, 0));             // r2 = rx_queue_index
+    prog.push_back(insn(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0, mapFd));
+    prog.push_back(insn(0, 0, 0, 0, 0));
+    prog.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS));     // Fallback action
+    prog.push_back(insn(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map));
+    prog.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    size_t pass = prog.size();
+    prog.push_back(insn(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS));
+    prog.push_back(insn(BPF_JMP | BPF_EXIT, 0, 0, 0, 0));
+    for (size_t i : toPass) prog[i].off = static_cast<int16_t>(pass - i - 1);
+
+    static const char license[] = "GPL";
+    std::vector<char> log(16384);
+    attr = bpf_attr{};
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = reinterpret_cast<uint64_t>(prog.data());
+    attr.insn_cnt = prog.size();
+    attr.license = reinterpret_cast<uint64_t>(license);
+    attr.log_buf = reinterpret_cast<uint64_t>(log.data());
+    attr.log_size = log.size();
+    attr.log_level = 1;
+    progFd = bpf(BPF_PROG_LOAD, attr);
+    if (progFd < 0) {
+        error = std::string("Failed to load the XDP program: ") + strerror(errno) + "\n" + log.data();
+        return false;
+    }
+
+    attr = bpf_attr{};
+    attr.link_create.prog_fd = progFd;
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+    linkFd = bpf(BPF_LINK_CREATE, attr);
+    if (linkFd < 0) {
+        error = std::string("Failed to attach the XDP program in generic mode: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void XdpBackend::close() {
+    // Detach first so the interface stops redirecting into a socket that is going away
+    for (int* fdp : {&linkFd, &progFd, &mapFd, &xskFd}) {
+        if (*fdp >= 0) {
+            ::close(*fdp);
+            *fdp = -1;
+        }
+    }
+    releaseAll();
+    if (rxMap) munmap(rxMap, rxMapSize);
+    if (fillMap) munmap(fillMap, fillMapSize);
+    if (umem) munmap(umem, umemSize);
+    rxMap = fillMap = nullptr;
+    umem = nullptr;
+    fillProducer = nullptr;
+}
+
+void XdpBackend::releaseBuffer(uint64_t frame) {
+    if (!fillProducer) return;
+    fillAddrs[fillHead & (FRAME_COUNT - 1)] = frame;
+    fillHead++;
+}
+
+void XdpBackend::readDropStats() {
+    // Cumulative: frames dropped for want of a fill ring entry, and for a full RX ring
+    batchesSinceStats = 0;
+    xdp_statistics xdpStats{};
+    socklen_t length = sizeof(xdpStats);
+    if (getsockopt(xskFd, SOL_XDP, XDP_STATISTICS, &xdpStats, &length) == 0) {
+        stats.kernelDrops.store(xdpStats.rx_dropped + xdpStats.rx_ring_full, std::memory_order_relaxed);
+    }
+}
+
+int XdpBackend::receiveBatch(bool& drained) {
+    releaseConsumed();
+    uint32_t cons = *rxConsumer;
+    uint32_t available = __atomic_load_n(rxProducer, __ATOMIC_ACQUIRE) - cons;
+    int n = static_cast<int>(std::min<uint32_t>(available, BATCH_SIZE));
+    drained = available <= static_cast<uint32_t>(BATCH_SIZE);
+    if (drained || ++batchesSinceStats >= STATS_INTERVAL) readDropStats();
+    if (n == 0) {
+        flushFill();
+        return 0;
+    }
+
+    // Generic XDP carries no receive timestamp, so the batch shares one clock read
+    int64_t nowNs = realtimeNs();
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+        const xdp_desc& desc = rxDescs[(cons + i) & (FRAME_COUNT - 1)];
+        uint64_t frame = desc.addr - desc.addr % FRAME_SIZE;
+        size_t length = desc.len > ETH_HLEN ? desc.len - ETH_HLEN : 0;
+        const uint8_t* payload;
+        uint64_t source;
+        if (!udpPayload(umem + desc.addr + ETH_HLEN, length, port, payload, &source)) {
+            releaseBuffer(frame);
+            continue;
+        }
+        datagrams[count] = {const_cast<char*>(reinterpret_cast<const char*>(payload)), length, nowNs, source};
+        frames[count] = frame;
+        count++;
+    }
+    __atomic_store_n(rxConsumer, cons + n, __ATOMIC_RELEASE);
+
+    if (count > 0 && batchHandler) batchHandler(datagrams.data(), count);
+    // Lend frames to the ring unless nobody drains it or half of UMEM is already waiting on it
+    bool zeroCopy = ring.hasConsumer() && heldCount() + count < FRAME_COUNT / 2;
+    for (int k = 0; k < count; ++k) {
+        const Datagram& d = datagrams[k];
+        bool pushed;
+        if (zeroCopy) {
+            pushed = ring.pushExternal(d.data, d.size, d.timestampNs, d.source);
+            holdUntilConsumed(frames[k]);
+        } else {
+            pushed = d.size <= ring.maxPacketSize() && ring.push(d.data, d.size, d.timestampNs, d.source);
+            releaseBuffer(frames[k]);
+        }
+        if (!pushed) stats.ringDrops.fetch_add(1, std::memory_order_relaxed);
+    }
+    releaseConsumed();
+    flushFill();
+    return n;
+}
@@ -0,0 +1,63 @@
+#ifndef XDPBACKEND_H
+#define XDPBACKEND_H
+
+#include "CaptureBackend.h"
+#include <linux/if_xdp.h>
+
+// AF_XDP capture in generic (SKB) mode, which works on any interface including lo and veth.
+// A small XDP program redirects unfragmented IPv4/UDP packets for our port into the socket's
+// UMEM; everything else passes to the stack untouched. Matching packets are consumed here and
+// do not reach the UDP stack. Like PacketMmapBackend, payloads are parsed and published to
+// PacketRing in place, and frames go back to the fill ring once the ring consumer has popped
+// them. Binds queue 0 only (lo and veth have one). Needs root and kernel 5.9+ (bpf_link).
+class XdpBackend : public CaptureBackend {
+public:
+    static constexpr uint32_t FRAME_SIZE = 4096;
+    static constexpr uint32_t FRAME_COUNT = 4096;  // Also the fill and RX ring size
+    static constexpr uint32_t QUEUE_ID = 0;
+
+    XdpBackend(PacketRing& ring, CaptureStats& stats);
+    ~XdpBackend() override;
+
+    bool open(const CaptureConfig& config, std::string& error) override;
+    void close() override;
+    int fd() const override { return xskFd; }
+    int receiveBatch(bool& drained) override;
+    bool lendsBuffers() const override { return true; }
+
+protected:
+    void releaseBuffer(uint64_t frame) override;
+
+private:
+    bool setUpSocket(int ifindex, std::string& error);
+    bool attachProgram(int ifindex, std::string& error);
+    void flushFill() { __atomic_store_n(fillProducer, fillHead, __ATOMIC_RELEASE); }
+    void readDropStats();
+
+    uint16_t port = 0;
+    int xskFd = -1;
+    int mapFd = -1;   // XSKMAP: RX queue -> socket
+    int progFd = -1;
+    int linkFd = -1;  // Closing it detaches the program
+    uint8_t* umem = nullptr;
+    size_t umemSize = 0;
+
+    void* rxMap = nullptr;
+    size_t rxMapSize = 0;
+    uint32_t* rxProducer = nullptr;
+    uint32_t* rxConsumer = nullptr;
+    xdp_desc* rxDescs = nullptr;
+
+    void* fillMap = nullptr;
+    size_t fillMapSize = 0;
+    uint32_t* fillProducer = nullptr;
+    uint64_t* fillAddrs = nullptr;
+    uint32_t fillHead = 0; // Local producer index, published by flushFill()
+
+    std::vector<Datagram> datagrams;
+    std::vector<uint64_t> frames; // Frame of each datagram in the current batch
+    unsigned batchesSinceStats = 0; // XDP_STATISTICS is read when idle and every STATS_INTERVAL batches
+    static constexpr unsigned STATS_INTERVAL = 256;
+};
+
+#endif // XDPBACKEND_H
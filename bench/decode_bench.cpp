@@ -0,0 +1,146 @@
+// Decode kernel microbenchmark: for every field type and byte order, decodes one column out
+// of datagrams full of structs through an ExtractionPlan with each instruction set's
+// kernels, against a per-value std::function converter like the one the receive path used
+// before. Reports values/s for a field among others (strided loads) and for structs that
+// are just the field (dense). Every decoded value is checked against the reference.
+//
+// Usage: decode_bench [datagrams, default 20000] [datagram bytes, 8192] [struct bytes, 24]
+#include "ExtractionPlan.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TypeCase {
+    const char* name;
+    ScalarType type;
+};
+
+const TypeCase TYPES[] = {
+    {"int8_t", ScalarType::Int8},     {"uint8_t", ScalarType::UInt8},   {"int16_t", ScalarType::Int16},
+    {"uint16_t", ScalarType::UInt16}, {"int32_t", ScalarType::Int32},   {"uint32_t", ScalarType::UInt32},
+    {"int64_t", ScalarType::Int64},   {"uint64_t", ScalarType::UInt64}, {"float", ScalarType::Float32},
+    {"double", ScalarType::Float64},
+};
+
+template <typename T>
+float referenceValue(const char* p, bool swap) {
+    unsigned char bytes[sizeof(T)];
+    memcpy(bytes, p, sizeof(T));
+    if (swap) std::reverse(bytes, bytes + sizeof(T));
+    T v;
+    memcpy(&v, bytes, sizeof(T));
+    return static_cast<float>(v);
+}
+
+// The per-value converter the plan replaced: type erased, with the swap decided per call
+std::function<float(const char*, bool)> referenceFor(ScalarType type) {
+    switch (type) {
+    case ScalarType::Int8: return referenceValue<int8_t>;
+    case ScalarType::UInt8: return referenceValue<uint8_t>;
+    case ScalarType::Int16: return referenceValue<int16_t>;
+    case ScalarType::UInt16: return referenceValue<uint16_t>;
+    case ScalarType::Int32: return referenceValue<int32_t>;
+    case ScalarType::UInt32: return referenceValue<uint32_t>;
+    case ScalarType::Int64: return referenceValue<int64_t>;
+    case ScalarType::UInt64: return referenceValue<uint64_t>;
+    case ScalarType::Float32: return referenceValue<float>;
+    case ScalarType::Float64: return referenceValue<double>;
+    }
+    return nullptr;
+}
+
+const DecodeIsa ISAS[] = {DecodeIsa::Scalar, DecodeIsa::Sse41, DecodeIsa::Avx2};
+
+struct Result {
+    double referenceRate = 0;
+    double planRate[3] = {0, 0, 0}; // Per ISAS entry, 0 where this CPU lacks it
+    size_t errors = 0;
+};
+
+template <typename F>
+double valuesPerSecond(size_t values, int datagrams, F decodeOne) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int d = 0; d < datagrams; ++d) decodeOne();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(values) * datagrams / seconds;
+}
+
+Result run(ScalarType type, bool swap, size_t stride, size_t offset, const std::vector<char>& datagram,
+           int datagrams) {
+    auto reference = referenceFor(type);
+    size_t structs = datagram.size() / stride;
+    std::vector<float> expected;
+    expected.reserve(structs);
+    Result result;
+
+    result.referenceRate = valuesPerSecond(structs, datagrams, [&]() {
+        expected.clear();
+        for (size_t s = 0; s < structs; ++s) expected.push_back(reference(datagram.data() + s * stride + offset, swap));
+    });
+
+    for (size_t k = 0; k < sizeof(ISAS) / sizeof(ISAS[0]); ++k) {
+        if (ISAS[k] > detectDecodeIsa()) break;
+        ExtractionPlan plan({{static_cast<uint32_t>(offset), type, 0, 0}}, stride, swap, ISAS[k]);
+        ColumnBuffers columns;
+        result.planRate[k] = valuesPerSecond(structs, datagrams, [&]() {
+            columns.clear();
+            plan.decode(datagram.data(), datagram.size(), columns);
+        });
+        // Same bits as the reference, NaNs included
+        if (columns.rows() != structs) {
+            result.errors += structs;
+            continue;
+        }
+        for (size_t s = 0; s < structs; ++s) {
+            if (memcmp(&expected[s], columns.column(0) + s, sizeof(float)) != 0) result.errors++;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int datagrams = argc > 1 ? std::max(1, atoi(argv[1])) : 20000;
+    size_t bytes = argc > 2 ? std::max<size_t>(64, strtoul(argv[2], nullptr, 10)) : 8192;
+    size_t stride = argc > 3 ? std::max<size_t>(8, strtoul(argv[3], nullptr, 10)) : 24;
+
+    std::vector<char> datagram(bytes);
+    std::mt19937 random(1);
+    for (char& c : datagram) c = static_cast<char>(random());
+
+    printf("%d datagrams of %zu bytes, best kernels: %s. Million values/s: the std::function per value\n"
+           "reference, then the plan's kernels for a field in %zu-byte structs and for a dense array\n",
+           datagrams, bytes, decodeIsaName(detectDecodeIsa()), stride);
+    printf("%-9s %-7s %9s %29s %29s\n", "", "", "", "----------- strided -----------", "------------ dense ------------");
+    printf("%-9s %-7s %9s %9s %9s %9s %9s %9s %9s\n", "type", "order", "reference", "scalar", "SSE4.1", "AVX2", "scalar",
+           "SSE4.1", "AVX2");
+    size_t errors = 0;
+    for (const TypeCase& t : TYPES) {
+        for (bool swap : {false, true}) {
+            if (swap && scalarSize(t.type) == 1) continue;
+            // The field one element in, as in a struct with a header field before it, if it fits
+            size_t size = scalarSize(t.type);
+            Result strided = run(t.type, swap, stride, stride >= 2 * size ? size : stride - size, datagram, datagrams);
+            Result dense = run(t.type, swap, scalarSize(t.type), 0, datagram, datagrams);
+            printf("%-9s %-7s %9.0f", t.name, swap ? "swapped" : "native", strided.referenceRate / 1e6);
+            for (const Result* result : {&strided, &dense}) {
+                for (double rate : result->planRate) {
+                    if (rate > 0) printf(" %9.0f", rate / 1e6);
+                    else printf(" %9s", "-");
+                }
+            }
+            if (strided.errors + dense.errors) printf("  %zu BAD", strided.errors + dense.errors);
+            printf("\n");
+            errors += strided.errors + dense.errors;
+        }
+    }
+    return errors ? 1 : 0;
+}
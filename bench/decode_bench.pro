@@ -0,0 +1,18 @@
+# ExtractionPlan decode kernel microbenchmark, no Qt needed: qmake decode_bench.pro && make && ./decode_bench
+TARGET = decode_bench
+TEMPLATE = app
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+SOURCES += \
+        decode_bench.cpp \
+        ../ChannelProgram.cpp \
+        ../DecodeKernels.cpp \
+        ../ExtractionPlan.cpp
+
+HEADERS += \
+        ../ChannelProgram.h \
+        ../DecodeKernels.h \
+        ../DecoderPluginApi.h \
+        ../ExtractionPlan.h
@@ -0,0 +1,136 @@
+// Derived channel benchmark: decodes datagrams of an ADC/IQ struct with a set of derived
+// channels (scaling, calibration polynomial and table, I/Q magnitude and phase) computed by
+// their compiled programs, against decoding the fields alone and against the same formulas
+// written out in C++ per struct. Reports million structs/s for each, and the largest
+// difference between a channel and its C++ formula.
+//
+// Usage: derived_bench [datagrams, 20000] [structs per datagram, 64]
+#include "CStructParser.h"
+#include "CompiledLayout.h"
+#include "DerivedChannel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* const STRUCT = R"(#pragma pack(push, 1)
+typedef struct {
+    uint32_t seq;
+    int16_t raw;
+    int16_t i;
+    int16_t q;
+    uint8_t flags : 4;
+    uint8_t gain : 4;
+    float temp_counts;
+    int16_t samples[4];
+} Packet;
+#pragma pack(pop))";
+
+const char* const CHANNELS = R"(# One of each kind of expression
+volts = raw * 0.000152 - 2.5
+magnitude = sqrt(i^2 + q^2)
+phase = atan2(q, i) * 180 / pi
+power_db = 10 * log10(magnitude^2 + 1e-12)
+temp_c = poly(temp_counts, -40, 0.125, 1e-5)
+level = lut(raw, -32768, 0, 0, 50, 32767, 100)
+mean = (samples[0] + samples[1] + samples[2] + samples[3]) / 4
+scaled = clamp(volts * gain, -1, 1))";
+
+constexpr int CHANNEL_COUNT = 8;
+
+// The channels above, one struct at a time, from its values in field order
+void reference(const float* v, float* out) {
+    const float pi = static_cast<float>(M_PI);
+    float raw = v[1], i = v[2], q = v[3], gain = v[5], temp = v[6];
+    out[0] = raw * 0.000152f - 2.5f;
+    out[1] = std::sqrt(i * i + q * q);
+    out[2] = std::atan2(q, i) * 180 / pi;
+    out[3] = 10 * std::log10(out[1] * out[1] + 1e-12f);
+    out[4] = -40 + temp * (0.125f + temp * 1e-5f);
+    out[5] = raw <= 0 ? (raw + 32768) * 50 / 32768 : 50 + raw * 50 / 32767;
+    out[6] = (v[7] + v[8] + v[9] + v[10]) / 4;
+    out[7] = std::max(std::min(out[0] * gain, 1.0f), -1.0f);
+}
+
+template <typename F>
+double structsPerSecond(size_t structs, int datagrams, F decodeOne) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int d = 0; d < datagrams; ++d) decodeOne();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(structs) * datagrams / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int datagrams = argc > 1 ? std::max(1, atoi(argv[1])) : 20000;
+    size_t structs = argc > 2 ? std::max<size_t>(1, strtoul(argv[2], nullptr, 10)) : 64;
+
+    QList<FieldDef> fields = parseCStruct(STRUCT);
+    CompiledLayout layout(fields);
+    QList<DerivedChannel> channels = parseDerivedChannels(CHANNELS, fields);
+    QVector<QPair<int, int>> selection;
+    for (int d = 0; d < channels.size(); ++d) {
+        if (!channels[d].error.isEmpty()) {
+            fprintf(stderr, "%s: %s\n", qPrintable(channels[d].name), qPrintable(channels[d].error));
+            return 2;
+        }
+        selection.append(qMakePair(layout.fieldCount() + d, 0));
+    }
+    ExtractionPlan fieldsOnly = layout.plan({}, false);
+    ExtractionPlan derived = planChannels(layout, channels, selection, false);
+
+    std::vector<char> datagram(structs * static_cast<size_t>(layout.size()));
+    std::mt19937 random(1);
+    for (char& c : datagram) c = static_cast<char>(random());
+    // Plausible temperature counts rather than random float bits
+    for (size_t s = 0; s < structs; ++s) {
+        float counts = static_cast<float>(random() % 4096);
+        memcpy(datagram.data() + s * layout.size() + 11, &counts, sizeof(counts));
+    }
+
+    printf("%d datagrams of %zu %d-byte structs, %d derived channels. Million structs/s:\n", datagrams, structs,
+           layout.size(), CHANNEL_COUNT);
+    ColumnBuffers values, computed;
+    double fieldRate = structsPerSecond(structs, datagrams, [&]() {
+        values.clear();
+        fieldsOnly.decode(datagram.data(), datagram.size(), values);
+    });
+    std::vector<float> row(static_cast<size_t>(layout.valueCount())), expected(structs * CHANNEL_COUNT);
+    double referenceRate = structsPerSecond(structs, datagrams, [&]() {
+        values.clear();
+        fieldsOnly.decode(datagram.data(), datagram.size(), values);
+        for (size_t s = 0; s < structs; ++s) {
+            for (size_t c = 0; c < row.size(); ++c) row[c] = values.column(c)[s];
+            reference(row.data(), &expected[s * CHANNEL_COUNT]);
+        }
+    });
+    double derivedRate = structsPerSecond(structs, datagrams, [&]() {
+        computed.clear();
+        derived.decode(datagram.data(), datagram.size(), computed);
+    });
+    printf("%-22s %8.1f\n%-22s %8.1f\n%-22s %8.1f\n", "fields only", fieldRate / 1e6, "fields + C++ formulas",
+           referenceRate / 1e6, "fields + channels", derivedRate / 1e6);
+
+    size_t errors = 0;
+    for (int d = 0; d < CHANNEL_COUNT; ++d) {
+        int c = derived.find(layout.fieldCount() + d, 0);
+        double worst = 0;
+        for (size_t s = 0; c >= 0 && s < structs; ++s) {
+            double want = expected[s * CHANNEL_COUNT + d];
+            double diff = std::fabs(computed.column(c)[s] - want) / std::max(1.0, std::fabs(want));
+            worst = std::max(worst, diff);
+        }
+        bool bad = c < 0 || worst > 1e-4;
+        errors += bad ? 1 : 0;
+        printf("  %-10s %3zu instructions, largest relative difference %.2g%s\n", qPrintable(channels[d].name),
+               channels[d].program->size(), worst, bad ? "  BAD" : "");
+    }
+    return errors ? 1 : 0;
+}
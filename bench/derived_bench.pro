@@ -0,0 +1,27 @@
+# Derived channel benchmark, compiled channel programs against the same formulas in C++; Qt
+# core only: qmake derived_bench.pro && make && ./derived_bench
+TARGET = derived_bench
+TEMPLATE = app
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+SOURCES += \
+        derived_bench.cpp \
+        ../ChannelProgram.cpp \
+        ../CStructParser.cpp \
+        ../CompiledLayout.cpp \
+        ../DecodeKernels.cpp \
+        ../DerivedChannel.cpp \
+        ../ExtractionPlan.cpp
+
+HEADERS += \
+        ../ChannelProgram.h \
+        ../CStructParser.h \
+        ../CompiledLayout.h \
+        ../DecodeKernels.h \
+        ../DerivedChannel.h \
+        ../DecoderPluginApi.h \
+        ../ExtractionPlan.h \
+        ../FieldDef.h
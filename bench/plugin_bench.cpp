@@ -0,0 +1,168 @@
+// Decoder plugin benchmark: generates the plugin for a struct, builds it with the system
+// compiler (or takes one already built), and decodes datagrams full of the struct both
+// through the generic CompiledLayout path and through the plugin: the first field alone,
+// every value of every field, every field whole (arrays as sample frames), and CSV rows as
+// the logger writes them. Reports million structs/s for each; every column and row is
+// checked to be identical between the two.
+//
+// Usage: plugin_bench [struct file, default the test_struct_layout.py packet] [datagrams, 20000]
+//                     [structs per datagram, 64] [plugin library, default built with c++ -O3]
+#include "CStructParser.h"
+#include "CompiledLayout.h"
+#include "DecoderPlugin.h"
+#include <QDir>
+#include <QFile>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+const char* const DEFAULT_STRUCT = R"(#pragma pack(push, 1)
+typedef enum { MODE_IDLE, MODE_RUN, MODE_FAULT } Mode;
+typedef struct {
+    uint32_t seq;
+    uint16_t source;
+} Header;
+typedef struct {
+    Header hdr;
+    Mode mode;
+    uint8_t ready : 1;
+    uint8_t error : 1;
+    uint8_t channel : 6;
+    int16_t temp : 12;
+    uint16_t level : 4;
+    float value;
+    int16_t samples[4];
+} Packet;
+#pragma pack(pop))";
+
+template <typename F>
+double structsPerSecond(size_t structs, int datagrams, F decodeOne) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int d = 0; d < datagrams; ++d) decodeOne();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return double(structs) * datagrams / seconds;
+}
+
+// Both plans over the datagram: structs/s of each, and the columns compared bit for bit
+size_t comparePlans(const char* name, bool swap, const ExtractionPlan& generic, const ExtractionPlan& plugin,
+                    const std::vector<char>& datagram, size_t structs, int datagrams) {
+    ColumnBuffers a, b;
+    double genericRate = structsPerSecond(structs, datagrams, [&]() {
+        a.clear();
+        generic.decode(datagram.data(), datagram.size(), a);
+    });
+    double pluginRate = structsPerSecond(structs, datagrams, [&]() {
+        b.clear();
+        plugin.decode(datagram.data(), datagram.size(), b);
+    });
+    size_t errors = a.columnCount() == b.columnCount() && a.rows() == b.rows() ? 0 : 1;
+    for (size_t c = 0; !errors && c < a.columnCount(); ++c) {
+        if (a.size(c) != b.size(c) || memcmp(a.column(c), b.column(c), a.size(c) * sizeof(float)) != 0) errors++;
+    }
+    printf("%-12s %-7s %8zu %10.1f %10.1f %7.1fx%s\n", name, swap ? "swapped" : "native", generic.columnCount(),
+           genericRate / 1e6, pluginRate / 1e6, pluginRate / genericRate, errors ? "  BAD" : "");
+    return errors;
+}
+
+size_t compareRows(bool swap, const CompiledLayout& generic, const CompiledLayout& plugin,
+                   const std::vector<char>& datagram, size_t structs, int datagrams) {
+    const size_t size = static_cast<size_t>(generic.size());
+    std::vector<char> a(generic.maxCsvRowBytes() + 1), b(a.size());
+    double genericRate = structsPerSecond(structs, datagrams, [&]() {
+        for (size_t s = 0; s < structs; ++s) generic.formatCsvRow(datagram.data() + s * size, size, swap, a.data());
+    });
+    double pluginRate = structsPerSecond(structs, datagrams, [&]() {
+        for (size_t s = 0; s < structs; ++s) plugin.formatCsvRow(datagram.data() + s * size, size, swap, b.data());
+    });
+    size_t errors = 0;
+    for (size_t s = 0; s < structs; ++s) {
+        // Every struct, and the last one cut short at each length
+        for (size_t available = s + 1 < structs ? size : 0; available <= size; ++available) {
+            size_t la = generic.formatCsvRow(datagram.data() + s * size, available, swap, a.data());
+            size_t lb = plugin.formatCsvRow(datagram.data() + s * size, available, swap, b.data());
+            if (la != lb || memcmp(a.data(), b.data(), la) != 0) errors++;
+        }
+    }
+    printf("%-12s %-7s %8d %10.1f %10.1f %7.1fx%s\n", "CSV rows", swap ? "swapped" : "native", generic.valueCount(),
+           genericRate / 1e6, pluginRate / 1e6, pluginRate / genericRate, errors ? "  BAD" : "");
+    return errors;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    QString structText = DEFAULT_STRUCT;
+    if (argc > 1) {
+        QFile file(argv[1]);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            fprintf(stderr, "Cannot read %s\n", argv[1]);
+            return 2;
+        }
+        structText = QString::fromUtf8(file.readAll());
+    }
+    int datagrams = argc > 2 ? std::max(1, atoi(argv[2])) : 20000;
+    size_t structs = argc > 3 ? std::max<size_t>(1, strtoul(argv[3], nullptr, 10)) : 64;
+
+    QList<FieldDef> fields = parseCStruct(structText);
+    CompiledLayout generic(fields);
+    if (generic.size() == 0) {
+        fprintf(stderr, "No fields in the struct\n");
+        return 2;
+    }
+    QString library;
+    if (argc > 4) {
+        library = argv[4];
+    } else {
+        QString source = QDir(QDir::tempPath()).filePath(decoderPluginName(generic) + ".cpp");
+        library = QDir(QDir::tempPath()).filePath("lib" + decoderPluginName(generic) + ".so");
+        QFile file(source);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            fprintf(stderr, "Cannot write %s\n", qPrintable(source));
+            return 2;
+        }
+        file.write(generateDecoderPlugin(fields).toUtf8());
+        file.close();
+        QString command = QString("c++ -std=c++17 -O3 -shared -fPIC %1 -o %2").arg(source, library);
+        printf("%s\n", qPrintable(command));
+        if (std::system(qPrintable(command)) != 0) {
+            fprintf(stderr, "Building the plugin failed; build it by hand and pass the library\n");
+            return 2;
+        }
+    }
+    QString error;
+    CompiledLayout compiled(fields);
+    if (!compiled.setPlugin(loadDecoderPlugin(library, generic, &error))) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+
+    std::vector<char> datagram(structs * static_cast<size_t>(generic.size()));
+    std::mt19937 random(1);
+    for (char& c : datagram) c = static_cast<char>(random());
+
+    printf("%d datagrams of %zu %d-byte structs (%d fields, %d values each). Million structs/s:\n", datagrams, structs,
+           generic.size(), generic.fieldCount(), generic.valueCount());
+    printf("%-12s %-7s %8s %10s %10s %8s\n", "", "order", "columns", "generic", "plugin", "speedup");
+    size_t errors = 0;
+    QVector<QPair<int, int>> first{qMakePair(0, 0)};
+    QVector<QPair<int, int>> whole;
+    for (int f = generic.fieldCount() - 1; f >= 0; --f) {
+        if (generic.field(f).known) first[0] = qMakePair(f, 0);
+        whole.prepend(qMakePair(f, -1));
+    }
+    for (bool swap : {false, true}) {
+        errors += comparePlans("first field", swap, generic.plan(first, swap), compiled.plan(first, swap), datagram,
+                               structs, datagrams);
+        errors += comparePlans("every value", swap, generic.plan({}, swap), compiled.plan({}, swap), datagram, structs,
+                               datagrams);
+        errors += comparePlans("whole fields", swap, generic.plan(whole, swap), compiled.plan(whole, swap), datagram,
+                               structs, datagrams);
+        errors += compareRows(swap, generic, compiled, datagram, structs, std::max(1, datagrams / 16));
+    }
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+# Decoder plugin benchmark, generic CompiledLayout decoding against a generated plugin; Qt
+# core only: qmake plugin_bench.pro && make && ./plugin_bench
+TARGET = plugin_bench
+TEMPLATE = app
+CONFIG += console c++17 release
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+SOURCES += \
+        plugin_bench.cpp \
+        ../ChannelProgram.cpp \
+        ../CStructParser.cpp \
+        ../CompiledLayout.cpp \
+        ../DecodeKernels.cpp \
+        ../DecoderPlugin.cpp \
+        ../ExtractionPlan.cpp
+
+HEADERS += \
+        ../ChannelProgram.h \
+        ../CStructParser.h \
+        ../CompiledLayout.h \
+        ../DecodeKernels.h \
+        ../DecoderPlugin.h \
+        ../DecoderPluginApi.h \
+        ../ExtractionPlan.h \
+        ../FieldDef.h
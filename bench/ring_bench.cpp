@@ -0,0 +1,200 @@
+// PacketRing microbenchmark: one producer thread, one consumer thread, moving fixed-size
+// packets through the ring one at a time (push/pop) and in batches (reserve/commit,
+// popBatch). Reports packets/s and, where perf_event_open is permitted, the cache misses
+// of both threads together. Every packet carries its index, which the consumer checks.
+//
+// Usage: ring_bench [packets, default 20000000] [payload bytes, 64] [batch, 32] [ring MB, 16]
+#include "PacketRing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+// Hardware counters for this process and the threads it starts afterwards
+class CacheCounters {
+public:
+    CacheCounters() {
+#ifdef __linux__
+        misses = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        l1Misses = open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+    }
+    ~CacheCounters() {
+#ifdef __linux__
+        if (misses >= 0) close(misses);
+        if (l1Misses >= 0) close(l1Misses);
+#endif
+    }
+    bool available() const { return misses >= 0; }
+    const std::string& problem() const { return error; }
+    void start() {
+#ifdef __linux__
+        for (int fd : {misses, l1Misses}) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    // Last-level and L1 data read misses since start(), -1 where not counted
+    void stop(long long& llc, long long& l1) {
+        llc = read(misses);
+        l1 = read(l1Misses);
+    }
+
+private:
+#ifdef __linux__
+    int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1; // Count the producer and consumer threads too
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd < 0 && error.empty()) error = std::string("perf_event_open: ") + strerror(errno);
+        return fd;
+    }
+#endif
+    long long read(int fd) {
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long value = 0;
+        if (::read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+        return value;
+#else
+        (void)fd;
+        return -1;
+#endif
+    }
+
+    int misses = -1;
+    int l1Misses = -1;
+#ifdef __linux__
+    std::string error;
+#else
+    std::string error = "needs Linux";
+#endif
+};
+
+void pinToCpu(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= static_cast<int>(std::thread::hardware_concurrency())) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+struct Result {
+    double seconds = 0;
+    long long llcMisses = -1;
+    long long l1Misses = -1;
+    uint64_t errors = 0;
+};
+
+Result run(bool batched, uint64_t packets, size_t payload, int batch, size_t ringBytes, CacheCounters& counters) {
+    PacketRing ring(ringBytes, payload);
+    ring.setConsumerAttached(true);
+    ring.growReserveSize(payload);
+    Result result;
+
+    counters.start();
+    auto begin = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        pinToCpu(0);
+        std::vector<char> packet(payload, 0x5a);
+        std::vector<char*> regions(batch);
+        uint64_t sent = 0;
+        while (sent < packets) {
+            if (!batched) {
+                memcpy(packet.data(), &sent, sizeof(sent));
+                if (ring.push(packet.data(), payload, 0)) sent++;
+                else std::this_thread::yield();
+                continue;
+            }
+            int n = ring.reserve(regions.data(), static_cast<int>(std::min<uint64_t>(batch, packets - sent)));
+            if (n == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (int i = 0; i < n; ++i, ++sent) {
+                memcpy(regions[i], packet.data(), payload);
+                memcpy(regions[i], &sent, sizeof(sent));
+                ring.commit(i, payload, 0);
+            }
+        }
+    });
+
+    std::thread consumer([&]() {
+        pinToCpu(1);
+        std::vector<PacketRing::Packet> out(batch);
+        uint64_t received = 0;
+        while (received < packets) {
+            int n = batched ? ring.popBatch(out.data(), batch) : ring.pop(out[0]) ? 1 : 0;
+            if (n == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (int i = 0; i < n; ++i, ++received) {
+                uint64_t index;
+                memcpy(&index, out[i].data, sizeof(index));
+                if (index != received || out[i].size != payload) result.errors++;
+            }
+        }
+    });
+    producer.join();
+    consumer.join();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    counters.stop(result.llcMisses, result.l1Misses);
+    return result;
+}
+
+void report(const char* name, uint64_t packets, const Result& result) {
+    printf("%-8s %12.0f packets/s", name, packets / result.seconds);
+    if (result.llcMisses >= 0) printf("  %7.3f cache misses/packet", double(result.llcMisses) / packets);
+    if (result.l1Misses >= 0) printf("  %7.3f L1D read misses/packet", double(result.l1Misses) / packets);
+    if (result.errors) printf("  %llu BAD", static_cast<unsigned long long>(result.errors));
+    printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t packets = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    size_t payload = argc > 2 ? std::max<size_t>(sizeof(uint64_t), strtoul(argv[2], nullptr, 10)) : 64;
+    int batch = argc > 3 ? std::max(1, atoi(argv[3])) : 32;
+    size_t ringBytes = (argc > 4 ? strtoul(argv[4], nullptr, 10) : 16) << 20;
+
+    printf("%llu packets of %zu bytes, batch %d, ring %zu MB, %u CPUs\n", static_cast<unsigned long long>(packets),
+           payload, batch, ringBytes >> 20, std::thread::hardware_concurrency());
+    CacheCounters counters;
+    if (!counters.available()) printf("Cache misses not counted (%s)\n", counters.problem().c_str());
+
+    Result single = run(false, packets, payload, batch, ringBytes, counters);
+    report("single", packets, single);
+    Result batched = run(true, packets, payload, batch, ringBytes, counters);
+    report("batched", packets, batched);
+    return single.errors || batched.errors ? 1 : 0;
+}
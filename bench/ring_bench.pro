@@ -0,0 +1,19 @@
+# PacketRing microbenchmark, no Qt needed: qmake ring_bench.pro && make && ./ring_bench
+TARGET = ring_bench
+TEMPLATE = app
+CONFIG += console c++17 release
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+SOURCES += \
+        ring_bench.cpp \
+        ../PacketMemory.cpp \
+        ../PacketRing.cpp \
+        ../SpillFile.cpp
+
+HEADERS += \
+        ../PacketMemory.h \
+        ../PacketRing.h \
+        ../SpillFile.h
+
+unix: LIBS += -pthread
@@ -32,6 +32,13 @@ echo
 echo "Memory:"
 free -h
 echo
+# Huge pages and locked memory for the Huge pages / Lock memory options
+echo "Packet memory:"
+echo "Reserved hugetlb pages: $(sysctl -n vm.nr_hugepages 2>/dev/null || echo 'Not available')"
+echo "Transparent huge pages: $(cat /sys/kernel/mm/transparent_hugepage/enabled 2>/dev/null || echo 'Not available')"
+echo "Locked memory limit (ulimit -l): $(ulimit -l)"
+echo "NUMA nodes: $(ls -d /sys/devices/system/node/node* 2>/dev/null | wc -l)"
+echo
 
 # Check disk I/O
 echo "Disk I/O (if available):"
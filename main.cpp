@@ -2,6 +2,7 @@
 #include <QApplication>
 #include <QMetaType>
 #include "FieldDef.h"
+#include "StreamConfig.h"
 #include <QHostAddress>
 
 #ifdef Q_OS_WIN
@@ -23,6 +24,7 @@ int main(int argc, char *argv[])
 
     qRegisterMetaType<QList<FieldDef>>("QList<FieldDef>");
     qRegisterMetaType<QHostAddress>("QHostAddress");
+    qRegisterMetaType<QList<StreamConfig>>("QList<StreamConfig>");
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
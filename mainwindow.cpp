@@ -1,6 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "CustomCommandDialog.h"
+#include "StreamDialog.h"
 #include <QHostAddress>
 #include <QMessageBox>
 #include <QDebug>
@@ -10,7 +11,6 @@
 #include <QtCharts/QValueAxis>
 #include <limits>
 #include <QtEndian>
-#include <QRegularExpression>
 #include <cmath>
 #include <algorithm> // For std::minmax_element
 #include <QJsonDocument>
@@ -29,33 +29,18 @@
 #include <QInputDialog>
 #include <QFileDialog>
 #include "FieldDef.h"
+#include "CStructParser.h"
+#include "CompiledLayout.h"
+#include "DerivedChannel.h"
+#include "DecoderPlugin.h"
 #include "UdpWorker.h"
 #include <QThread>
 
 QT_CHARTS_USE_NAMESPACE
 
-// Simple C struct parser
-QList<FieldDef> parseCStruct(const QString &structText) {
-    QList<FieldDef> fields;
-    QStringList lines = structText.split('\n');
-    QRegularExpression re(R"((\w+_t|\w+)\s+(\w+)(\[(\d+)\])?;?)");
-    for (const QString &line : lines) {
-        QString trimmed = line.trimmed();
-        if (trimmed.isEmpty() || trimmed.startsWith("//") || trimmed.startsWith("typedef") || trimmed.startsWith("{") || trimmed.startsWith("}"))
-            continue;
-        QRegularExpressionMatch match = re.match(trimmed);
-        if (match.hasMatch()) {
-            FieldDef field;
-            field.type = match.captured(1);
-            field.name = match.captured(2);
-            field.count = match.captured(4).isEmpty() ? 1 : match.captured(4).toInt();
-            fields.append(field);
-    #ifdef ENABLE_DEBUG
-        qDebug() << "[parseCStruct] Found field:" << field.type << field.name << "count:" << field.count;
-#endif
-        }
-    }
-    return fields;
+// Size of a parsed struct as laid out by parseCStruct(), padding included
+int structSizeOf(const QList<FieldDef> &fields) {
+    return CompiledLayout(fields).size();
 }
 
 // Helper to swap endianness for various types
@@ -96,19 +81,7 @@ MainWindow::MainWindow(QWidget *parent)
         // Recalculate packet length as if struct was just parsed
         QString structText = ui->structTextEdit->toPlainText();
         QList<FieldDef> fields = parseCStruct(structText);
-        auto typeSize = [](const QString &type) -> int {
-            if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-            if (type == "int16_t" || type == "uint16_t") return 2;
-            if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-            if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-            return 0;
-        };
-        int structSize = 0;
-        for (const FieldDef &field : fields) {
-            int sz = typeSize(field.type);
-            if (sz == 0) continue;
-            structSize += sz * field.count;
-        }
+        int structSize = structSizeOf(fields);
         int structCount = ui->structCountSpinBox->value();
         int totalSize = structSize * structCount;
         if (totalSize > 0) {
@@ -250,8 +223,73 @@ MainWindow::MainWindow(QWidget *parent)
     connect(this, &MainWindow::startUdp, udpWorker, &UdpWorker::start);
     connect(this, &MainWindow::stopUdp, udpWorker, &UdpWorker::stop);
     connect(this, &MainWindow::updateUdpConfig, udpWorker, &UdpWorker::updateConfig);
-    connect(udpWorker, &UdpWorker::dataReceived, this, &MainWindow::handleUdpData, Qt::QueuedConnection);
     connect(this, &MainWindow::sendCustomDatagram, udpWorker, &UdpWorker::sendDatagram);
+    connect(this, &MainWindow::setUdpReceiveMode, udpWorker, &UdpWorker::setReceiveMode);
+    connect(this, &MainWindow::setUdpShardCount, udpWorker, &UdpWorker::setShardCount);
+    connect(this, &MainWindow::setUdpRingCapacity, udpWorker, &UdpWorker::setRingCapacity);
+    connect(this, &MainWindow::setUdpMemoryPolicy, udpWorker, &UdpWorker::setMemoryPolicy);
+    connect(this, &MainWindow::setUdpOverflowPolicy, udpWorker, &UdpWorker::setOverflowPolicy);
+    connect(this, &MainWindow::setUdpPreRoll, udpWorker, &UdpWorker::setPreRoll);
+    connect(this, &MainWindow::setUdpCaptureBackend, udpWorker, &UdpWorker::setCaptureBackend);
+    connect(this, &MainWindow::setUdpStreams, udpWorker, &UdpWorker::setStreams);
+    connect(this, &MainWindow::setUdpGro, udpWorker, &UdpWorker::setUdpGro);
+    connect(this, &MainWindow::setUdpSequenceField, udpWorker, &UdpWorker::setSequenceField);
+    connect(this, &MainWindow::setUdpDerivedChannels, udpWorker, &UdpWorker::setDerivedChannels);
+    connect(this, &MainWindow::setUdpForwardTarget, udpWorker, &UdpWorker::setForwardTarget);
+    connect(udpWorker, &UdpWorker::errorOccurred, this, [this](const QString &msg) {
+        ui->statusbar->showMessage(msg, 5000);
+    });
+    rxRateLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxRateLabel);
+    connect(udpWorker, &UdpWorker::receiveRateUpdated, this, [this](double pps, double mbps) {
+        rxRateLabel->setText(QString("Rx: %1 pkt/s, %2 Mb/s").arg(pps, 0, 'f', 0).arg(mbps, 0, 'f', 2));
+    });
+    rxLoadLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxLoadLabel);
+    connect(udpWorker, &UdpWorker::receiveLoadUpdated, this, [this](double cpuPercent, double avgUs, double maxUs) {
+        rxLoadLabel->setText(QString("CPU: %1%  Latency: %2 us avg, %3 us max")
+            .arg(cpuPercent, 0, 'f', 1).arg(avgUs, 0, 'f', 1).arg(maxUs, 0, 'f', 1));
+    });
+    rxDropLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxDropLabel);
+    connect(udpWorker, &UdpWorker::dropStatsUpdated, this, [this](quint64 kernel, quint64 ringFull, quint64 oversized, quint64 shortReads) {
+        rxDropLabel->setText(QString("Drops: %1 kernel, %2 ring full, %3 oversized, %4 short")
+            .arg(kernel).arg(ringFull).arg(oversized).arg(shortReads));
+    });
+    rxSequenceLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxSequenceLabel);
+    connect(udpWorker, &UdpWorker::sequenceStatsUpdated, this, [this](quint64 lost, quint64 duplicates, quint64 reordered, quint64 late) {
+        rxSequenceLabel->setText(QString("Seq: %1 lost, %2 dup, %3 reordered, %4 late")
+            .arg(lost).arg(duplicates).arg(reordered).arg(late));
+    });
+    rxForwardLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxForwardLabel);
+    connect(udpWorker, &UdpWorker::forwardStatsUpdated, this, [this](quint64 forwarded, quint64 skipped) {
+        rxForwardLabel->setText(QString("Fwd: %1 sent, %2 skipped").arg(forwarded).arg(skipped));
+    });
+    rxOverflowLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(rxOverflowLabel);
+    connect(udpWorker, &UdpWorker::overflowStatsUpdated, this, [this](quint64 evicted, quint64 blocked, quint64 blockTimeouts,
+                                                                      quint64 spilled, quint64 spillPending, quint64 spillFailures) {
+        // Only the active policy's counters; Drop Newest is the "ring full" drop count
+        switch (ui->overflowComboBox->currentIndex()) {
+        case 1:
+            rxOverflowLabel->setText(QString("Evicted: %1").arg(evicted));
+            break;
+        case 2:
+            rxOverflowLabel->setText(QString("Blocked: %1, %2 timed out").arg(blocked).arg(blockTimeouts));
+            break;
+        case 3:
+            rxOverflowLabel->setText(QString("Spilled: %1, %2 pending, %3 failed").arg(spilled).arg(spillPending).arg(spillFailures));
+            break;
+        default:
+            rxOverflowLabel->clear();
+            break;
+        }
+    });
+    connect(udpWorker, &UdpWorker::memoryReportReady, this, [this](const QString& report) {
+        ui->statusbar->showMessage(tr("Packet memory: %1").arg(report), 10000);
+    });
     udpThread->start();
     udpThread->setPriority(QThread::HighPriority); // Set UDP thread to high priority
     emit startUdp(ui->portSpinBox->value());
@@ -313,29 +351,15 @@ void MainWindow::on_parseStructButton_clicked()
 {
     QString structText = ui->structTextEdit->toPlainText();
     QList<FieldDef> fields = parseCStruct(structText);
+    QString derivedText = ui->derivedTextEdit->toPlainText();
+    QList<DerivedChannel> channels = parseDerivedChannels(derivedText, fields);
 
-    // Helper: map type string to size in bytes
-    auto typeSize = [](const QString &type) -> int {
-        if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        return 0; // Unknown type
-    };
+    CompiledLayout layout(fields);
 
-    // Print parsed fields and sizes
 #ifdef ENABLE_DEBUG
-    qDebug() << "Parsed struct fields:";
+    qDebug() << "Parsed struct fields:" << fields.size() << "size:" << layout.size();
 #endif
-    int structSize = 0;
-    for (const FieldDef &field : fields) {
-        int sz = typeSize(field.type);
-#ifdef ENABLE_DEBUG
-        qDebug() << field.type << field.name << "count:" << field.count << "size:" << sz * field.count;
-#endif
-        if (sz == 0) continue; // skip unknown types
-        structSize += sz * field.count;
-    }
+    int structSize = layout.size();
     int structCount = ui->structCountSpinBox->value();
     int totalSize = structSize * structCount;
     if (totalSize > 0) {
@@ -344,9 +368,9 @@ void MainWindow::on_parseStructButton_clicked()
 
     // Display in table
     ui->fieldTableWidget->clear();
-    ui->fieldTableWidget->setColumnCount(4);
-    ui->fieldTableWidget->setHorizontalHeaderLabels({"Real Time Graph", "Type", "Name", "Count"});
-    ui->fieldTableWidget->setRowCount(fields.size());
+    ui->fieldTableWidget->setColumnCount(5);
+    ui->fieldTableWidget->setHorizontalHeaderLabels({"Real Time Graph", "Type", "Name", "Count", "Offset"});
+    ui->fieldTableWidget->setRowCount(fields.size() + channels.size());
     for (int i = 0; i < fields.size(); ++i) {
         // Checkbox item
         QTableWidgetItem *checkItem = new QTableWidgetItem();
@@ -355,11 +379,54 @@ void MainWindow::on_parseStructButton_clicked()
         ui->fieldTableWidget->setItem(i, 0, checkItem);
 
         // Other columns
-        ui->fieldTableWidget->setItem(i, 1, new QTableWidgetItem(fields[i].type));
+        ui->fieldTableWidget->setItem(i, 1, new QTableWidgetItem(fields[i].declaredType.isEmpty() ? fields[i].type : fields[i].declaredType));
         ui->fieldTableWidget->setItem(i, 2, new QTableWidgetItem(fields[i].name));
         ui->fieldTableWidget->setItem(i, 3, new QTableWidgetItem(QString::number(fields[i].count)));
+        // Byte offset in the struct; a bitfield's bits counted from its unit's least significant
+        const CompiledLayout::Field &placed = layout.field(i);
+        QString offset = QString::number(placed.offset);
+        if (placed.bitWidth > 1) offset += QString(" bits %1-%2").arg(placed.bitShift).arg(placed.bitShift + placed.bitWidth - 1);
+        else if (placed.bitWidth == 1) offset += QString(" bit %1").arg(placed.bitShift);
+        ui->fieldTableWidget->setItem(i, 4, new QTableWidgetItem(offset));
+    }
+    // Derived channels after the fields, selectable the same way unless they failed to compile
+    QString derivedError;
+    for (int d = 0; d < channels.size(); ++d) {
+        int row = fields.size() + d;
+        const DerivedChannel &channel = channels[d];
+        QTableWidgetItem *checkItem = new QTableWidgetItem();
+        Qt::ItemFlags flags = Qt::ItemIsUserCheckable;
+        if (channel.program) flags |= Qt::ItemIsEnabled;
+        checkItem->setFlags(flags);
+        checkItem->setCheckState(Qt::Unchecked);
+        ui->fieldTableWidget->setItem(row, 0, checkItem);
+        ui->fieldTableWidget->setItem(row, 1, new QTableWidgetItem("derived"));
+        ui->fieldTableWidget->setItem(row, 2, new QTableWidgetItem(channel.name));
+        ui->fieldTableWidget->setItem(row, 3, new QTableWidgetItem("1"));
+        ui->fieldTableWidget->setItem(row, 4, new QTableWidgetItem(channel.program ? "= " + channel.expression : channel.error));
+        if (!channel.program && derivedError.isEmpty()) derivedError = QString("%1: %2").arg(channel.name, channel.error);
     }
     ui->fieldTableWidget->resizeColumnsToContents();
+    if (!derivedError.isEmpty()) {
+        ui->statusbar->showMessage(tr("Derived channel %1").arg(derivedError), 5000);
+    } else if (findDecoderPlugin(layout)) {
+        ui->statusbar->showMessage(tr("Decoding through plugin %1").arg(decoderPluginName(layout)), 5000);
+    }
+
+    // Sequence field candidates: scalar integer fields, keeping the current choice by name
+    QString sequenceName = ui->sequenceFieldComboBox->currentText();
+    ui->sequenceFieldComboBox->blockSignals(true);
+    ui->sequenceFieldComboBox->clear();
+    ui->sequenceFieldComboBox->addItem("(none)", -1);
+    for (int i = 0; i < fields.size(); ++i) {
+        if (!layout.isSequenceCandidate(i)) continue;
+        ui->sequenceFieldComboBox->addItem(fields[i].name, i);
+    }
+    int sequenceIndex = ui->sequenceFieldComboBox->findText(sequenceName);
+    ui->sequenceFieldComboBox->setCurrentIndex(sequenceIndex > 0 ? sequenceIndex : 0);
+    ui->sequenceFieldComboBox->blockSignals(false);
+    emit setUdpSequenceField(ui->sequenceFieldComboBox->currentData().toInt());
+    emit setUdpDerivedChannels(derivedText);
     
     // Auto-select first field for simple structs (1-2 fields)
     if (fields.size() <= 2 && fields.size() > 0) {
@@ -382,7 +449,7 @@ void MainWindow::on_parseStructButton_clicked()
             selectedField = row;
             selectedFieldCount = ui->fieldTableWidget->item(row, 3)->text().toInt();
 #ifdef ENABLE_DEBUG
-            qDebug() << "[MainWindow] Selected field:" << row << "name:" << fields[row].name << "count:" << selectedFieldCount;
+            qDebug() << "[MainWindow] Selected field:" << row << "name:" << ui->fieldTableWidget->item(row, 2)->text() << "count:" << selectedFieldCount;
 #endif
             break;
         }
@@ -553,21 +620,7 @@ void MainWindow::processFftAndPlot() {
 // Helper: calculate struct size from parsed struct
 int MainWindow::getStructSize() {
     QString structText = ui->structTextEdit->toPlainText();
-    QList<FieldDef> fields = parseCStruct(structText);
-    auto typeSize = [](const QString &type) -> int {
-        if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        return 0;
-    };
-    int structSize = 0;
-    for (const FieldDef &field : fields) {
-        int sz = typeSize(field.type);
-        if (sz == 0) continue;
-        structSize += sz * field.count;
-    }
-    return structSize;
+    return structSizeOf(parseCStruct(structText));
 }
 
 void MainWindow::on_fieldTableWidget_itemChanged(QTableWidgetItem *item)
@@ -591,7 +644,7 @@ void MainWindow::on_fieldTableWidget_itemChanged(QTableWidgetItem *item)
         if (count > 1) {
             ui->label_arrayIndex->setVisible(true);
             ui->arrayIndexSpinBox->setVisible(true);
-            ui->arrayIndexSpinBox->setMinimum(0);
+            ui->arrayIndexSpinBox->setMinimum(UdpWorker::ALL_ELEMENTS); // "All": the array as a sample stream
             ui->arrayIndexSpinBox->setMaximum(count - 1);
         } else {
             ui->label_arrayIndex->setVisible(false);
@@ -603,19 +656,7 @@ void MainWindow::on_fieldTableWidget_itemChanged(QTableWidgetItem *item)
         // Emit updateUdpConfig
         QString structText = ui->structTextEdit->toPlainText();
         QList<FieldDef> fields = parseCStruct(structText);
-        int structSize = 0;
-        auto typeSize = [](const QString &type) -> int {
-            if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-            if (type == "int16_t" || type == "uint16_t") return 2;
-            if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-            if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-            return 0;
-        };
-        for (const FieldDef &field : fields) {
-            int sz = typeSize(field.type);
-            if (sz == 0) continue;
-            structSize += sz * field.count;
-        }
+        int structSize = structSizeOf(fields);
         int selectedField = selectedRow;
         int selectedArrayIndex = 0;
         int selectedFieldCount = count;
@@ -629,6 +670,7 @@ void MainWindow::on_fieldTableWidget_itemChanged(QTableWidgetItem *item)
 
 // Throttled plot update
 void MainWindow::updatePlot() {
+    drainSamples();
     if (ui->applyFftCheckBox->isChecked()) {
         // FFT mode - do nothing (handled by processFftAndPlot)
         return;
@@ -653,7 +695,9 @@ void MainWindow::updatePlot() {
     }
 }
 
-void MainWindow::handleUdpData(QVector<float> values) {
+void MainWindow::drainSamples() {
+    // The worker never queues more than the ring holds, however fast data arrives
+    SpscRing<float>& samples = udpWorker->plotSamples();
     // Check if a field is selected
     int selectedField = -1;
     for (int row = 0; row < ui->fieldTableWidget->rowCount(); ++row) {
@@ -665,38 +709,43 @@ void MainWindow::handleUdpData(QVector<float> values) {
     }
     if (selectedField == -1) {
 #ifdef ENABLE_DEBUG
-        qDebug() << "[handleUdpData] No field selected, clearing plot.";
+        qDebug() << "[drainSamples] No field selected, clearing plot.";
 #endif
+        samples.skip(samples.size());
         valueHistory.clear();
         auto *series = static_cast<QLineSeries*>(ui->chartView->chart()->series().at(0));
         series->clear();
         return;
     }
-    #ifdef ENABLE_DEBUG
-        qDebug() << "[handleUdpData] Received values for field" << selectedField << ":" << values;
-#endif
 
     if (ui->applyFftCheckBox->isChecked()) {
         // FFT mode: fill fftBuffer and process when enough samples are collected
-        for (float value : values) {
-            fftBuffer.push_back(value);
-            if ((int)fftBuffer.size() == ui->fftLengthSpinBox->value()) {
-                processFftAndPlot();
-                // fftBuffer is cleared inside processFftAndPlot()
+        size_t n;
+        while ((n = samples.pop(sampleBuffer.data(), sampleBuffer.size())) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                fftBuffer.push_back(sampleBuffer[i]);
+                if ((int)fftBuffer.size() == ui->fftLengthSpinBox->value()) {
+                    processFftAndPlot();
+                    // fftBuffer is cleared inside processFftAndPlot()
+                }
             }
         }
         return; // Don't update time-domain plot
     }
 
-    // Time-domain mode (existing code)
-    // For high-rate data, limit the number of points to prevent memory issues
-    const int maxPoints = std::min(xDiv, 10000); // Cap at 10k points for high-rate data
-    
-    for (float value : values) {
-        if (valueHistory.size() >= maxPoints) valueHistory.pop_front();
-        valueHistory.append(QPointF(sampleIndex++, value));
+    // Time-domain mode: only the newest maxPoints can be shown, older samples just move the X axis
+    const int maxPoints = std::min(xDiv, MAX_PLOT_POINTS);
+    size_t queued = samples.size();
+    if (queued > size_t(maxPoints)) sampleIndex += samples.skip(queued - maxPoints);
+    int n = static_cast<int>(samples.pop(sampleBuffer.data(), maxPoints));
+    int excess = valueHistory.size() + n - maxPoints;
+    if (excess > 0) valueHistory.remove(0, std::min(excess, int(valueHistory.size())));
+#ifdef ENABLE_DEBUG
+    if (n > 0) qDebug() << "[drainSamples]" << n << "samples for field" << selectedField << ", dropped so far:" << samples.dropped();
+#endif
+    for (int i = 0; i < n; ++i) {
+        valueHistory.append(QPointF(sampleIndex++, sampleBuffer[i]));
     }
-    // Do not call updatePlot() here; let plotUpdateTimer control refresh
 }
 
 // Helper: collect all UI state into a QJsonObject
@@ -705,6 +754,7 @@ QJsonObject MainWindow::collectPreset() const {
     preset["daq_ip"] = ui->ipLineEdit->text();
     preset["daq_port"] = ui->portSpinBox->value();
     preset["struct_def"] = ui->structTextEdit->toPlainText();
+    preset["derived_channels"] = ui->derivedTextEdit->toPlainText();
     preset["fft_length"] = ui->fftLengthSpinBox->value();
     preset["apply_fft"] = ui->applyFftCheckBox->isChecked();
     preset["x_div"] = ui->xDivSlider->value();
@@ -716,6 +766,22 @@ QJsonObject MainWindow::collectPreset() const {
     preset["selected_field"] = ui->fieldTableWidget->currentRow();
     preset["array_index"] = ui->arrayIndexSpinBox->value();
     preset["structs_per_packet"] = ui->structCountSpinBox->value();
+    preset["receive_mode"] = ui->receiveModeComboBox->currentIndex();
+    preset["shard_count"] = ui->shardCountSpinBox->value();
+    preset["ring_mb"] = ui->ringCapacitySpinBox->value();
+    preset["huge_pages"] = ui->hugePagesCheckBox->isChecked();
+    preset["lock_memory"] = ui->lockMemoryCheckBox->isChecked();
+    preset["numa_local"] = ui->numaLocalCheckBox->isChecked();
+    preset["overflow_policy"] = ui->overflowComboBox->currentIndex();
+    preset["block_timeout_ms"] = ui->blockTimeoutSpinBox->value();
+    preset["pre_roll_s"] = ui->preRollSpinBox->value();
+    preset["pre_roll_mb"] = ui->preRollMbSpinBox->value();
+    preset["capture_backend"] = ui->captureBackendComboBox->currentIndex();
+    preset["capture_interface"] = ui->captureInterfaceLineEdit->text();
+    preset["streams"] = streamArray;
+    preset["udp_gro"] = ui->udpGroCheckBox->isChecked();
+    preset["sequence_field"] = ui->sequenceFieldComboBox->currentIndex() > 0 ? ui->sequenceFieldComboBox->currentText() : QString();
+    preset["forward_to"] = ui->forwardLineEdit->text();
     return preset;
 }
 
@@ -724,6 +790,7 @@ void MainWindow::applyPreset(const QJsonObject &preset) {
     if (preset.contains("daq_ip")) ui->ipLineEdit->setText(preset["daq_ip"].toString());
     if (preset.contains("daq_port")) ui->portSpinBox->setValue(preset["daq_port"].toInt());
     if (preset.contains("struct_def")) ui->structTextEdit->setPlainText(preset["struct_def"].toString());
+    if (preset.contains("derived_channels")) ui->derivedTextEdit->setPlainText(preset["derived_channels"].toString());
     if (preset.contains("fft_length")) ui->fftLengthSpinBox->setValue(preset["fft_length"].toInt());
     if (preset.contains("apply_fft")) ui->applyFftCheckBox->setChecked(preset["apply_fft"].toBool());
     if (preset.contains("x_div")) ui->xDivSlider->setValue(preset["x_div"].toInt());
@@ -742,6 +809,34 @@ void MainWindow::applyPreset(const QJsonObject &preset) {
     }
     if (preset.contains("array_index")) ui->arrayIndexSpinBox->setValue(preset["array_index"].toInt());
     if (preset.contains("structs_per_packet")) ui->structCountSpinBox->setValue(preset["structs_per_packet"].toInt());
+    if (preset.contains("receive_mode")) ui->receiveModeComboBox->setCurrentIndex(preset["receive_mode"].toInt());
+    if (preset.contains("shard_count")) ui->shardCountSpinBox->setValue(preset["shard_count"].toInt());
+    if (preset.contains("ring_mb")) ui->ringCapacitySpinBox->setValue(preset["ring_mb"].toInt());
+    if (preset.contains("huge_pages")) ui->hugePagesCheckBox->setChecked(preset["huge_pages"].toBool());
+    if (preset.contains("lock_memory")) ui->lockMemoryCheckBox->setChecked(preset["lock_memory"].toBool());
+    if (preset.contains("numa_local")) ui->numaLocalCheckBox->setChecked(preset["numa_local"].toBool());
+    if (preset.contains("block_timeout_ms")) ui->blockTimeoutSpinBox->setValue(preset["block_timeout_ms"].toInt());
+    if (preset.contains("overflow_policy")) ui->overflowComboBox->setCurrentIndex(preset["overflow_policy"].toInt());
+    if (preset.contains("pre_roll_mb")) ui->preRollMbSpinBox->setValue(preset["pre_roll_mb"].toInt());
+    if (preset.contains("pre_roll_s")) ui->preRollSpinBox->setValue(preset["pre_roll_s"].toInt());
+    if (preset.contains("capture_interface")) {
+        ui->captureInterfaceLineEdit->setText(preset["capture_interface"].toString());
+        on_captureInterfaceLineEdit_editingFinished();
+    }
+    if (preset.contains("capture_backend")) ui->captureBackendComboBox->setCurrentIndex(preset["capture_backend"].toInt());
+    if (preset.contains("udp_gro")) ui->udpGroCheckBox->setChecked(preset["udp_gro"].toBool());
+    if (preset.contains("sequence_field")) {
+        int index = ui->sequenceFieldComboBox->findText(preset["sequence_field"].toString());
+        ui->sequenceFieldComboBox->setCurrentIndex(index > 0 ? index : 0);
+    }
+    if (preset.contains("forward_to")) {
+        ui->forwardLineEdit->setText(preset["forward_to"].toString());
+        on_forwardLineEdit_editingFinished();
+    }
+    if (preset.contains("streams")) {
+        streamArray = preset["streams"].toArray();
+        applyStreams();
+    }
 }
 
 // Helper: update the preset combo box from file
@@ -900,6 +995,49 @@ void MainWindow::on_editCommandsButton_clicked() {
     }
 }
 
+void MainWindow::on_exportDecoderButton_clicked() {
+    QList<FieldDef> fields = parseCStruct(ui->structTextEdit->toPlainText());
+    CompiledLayout layout(fields);
+    if (fields.isEmpty() || layout.size() == 0) {
+        QMessageBox::warning(this, "Error", "Invalid struct definition");
+        return;
+    }
+    QString name = decoderPluginName(layout);
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export Decoder Plugin"), name + ".cpp", tr("C++ Files (*.cpp)"));
+    if (filename.isEmpty()) return;
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::warning(this, "Error", tr("Cannot write %1").arg(filename));
+        return;
+    }
+    file.write(generateDecoderPlugin(fields).toUtf8());
+    file.close();
+    QMessageBox::information(this, tr("Export Decoder Plugin"),
+                             tr("Build it as the shared library %1 in\n%2\n(the commands are at the top of the file).\n\n"
+                                "Receiving and logging this struct then decode through it; any change to the struct "
+                                "needs a new plugin.").arg(name, decoderPluginDirectory()));
+}
+
+void MainWindow::on_editStreamsButton_clicked() {
+    StreamDialog dlg(streamArray, this);
+    if (dlg.exec() == QDialog::Accepted) {
+        streamArray = dlg.getStreams();
+        applyStreams();
+        ui->statusbar->showMessage(tr("%1 additional stream(s); save a preset to keep them").arg(streamArray.size()), 3000);
+    }
+}
+
+void MainWindow::applyStreams() {
+    QList<StreamConfig> streams;
+    for (const QJsonValue &val : streamArray) {
+        StreamConfig stream = StreamConfig::fromJson(val.toObject());
+        stream.fields = parseCStruct(stream.structText);
+        stream.structSize = structSizeOf(stream.fields);
+        streams.append(stream);
+    }
+    emit setUdpStreams(streams);
+}
+
 void MainWindow::updateCustomCommandsUI() {
     // Remove old widget if present
     if (customCommandsWidget) {
@@ -1142,23 +1280,113 @@ void MainWindow::on_binaryLoggingCheckBox_toggled(bool checked) {
     }
 }
 
+void MainWindow::on_receiveModeComboBox_currentIndexChanged(int index) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Receive mode changed to" << ui->receiveModeComboBox->itemText(index);
+#endif
+    emit setUdpReceiveMode(index);
+    ui->statusbar->showMessage(tr("Receive mode: %1").arg(ui->receiveModeComboBox->itemText(index)), 3000);
+}
+
+void MainWindow::on_shardCountSpinBox_valueChanged(int value) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Shard count changed to" << value;
+#endif
+    emit setUdpShardCount(value);
+}
+
+void MainWindow::on_ringCapacitySpinBox_valueChanged(int value) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Ring capacity changed to" << value << "MB";
+#endif
+    emit setUdpRingCapacity(value);
+}
+
+void MainWindow::on_hugePagesCheckBox_toggled(bool checked) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Huge pages" << (checked ? "enabled" : "disabled");
+#endif
+    emit setUdpMemoryPolicy(checked, ui->lockMemoryCheckBox->isChecked(), ui->numaLocalCheckBox->isChecked());
+}
+
+void MainWindow::on_lockMemoryCheckBox_toggled(bool checked) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Lock memory" << (checked ? "enabled" : "disabled");
+#endif
+    emit setUdpMemoryPolicy(ui->hugePagesCheckBox->isChecked(), checked, ui->numaLocalCheckBox->isChecked());
+}
+
+void MainWindow::on_numaLocalCheckBox_toggled(bool checked) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] NUMA local memory" << (checked ? "enabled" : "disabled");
+#endif
+    emit setUdpMemoryPolicy(ui->hugePagesCheckBox->isChecked(), ui->lockMemoryCheckBox->isChecked(), checked);
+}
+
+void MainWindow::on_overflowComboBox_currentIndexChanged(int index) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Ring overflow policy changed to" << ui->overflowComboBox->itemText(index);
+#endif
+    ui->blockTimeoutSpinBox->setEnabled(index == 2);
+    emit setUdpOverflowPolicy(index, ui->blockTimeoutSpinBox->value());
+}
+
+void MainWindow::on_blockTimeoutSpinBox_valueChanged(int value) {
+    emit setUdpOverflowPolicy(ui->overflowComboBox->currentIndex(), value);
+}
+
+void MainWindow::on_preRollSpinBox_valueChanged(int value) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Pre-roll changed to" << value << "s";
+#endif
+    ui->preRollMbSpinBox->setEnabled(value > 0);
+    emit setUdpPreRoll(value, ui->preRollMbSpinBox->value());
+}
+
+void MainWindow::on_preRollMbSpinBox_valueChanged(int value) {
+    emit setUdpPreRoll(ui->preRollSpinBox->value(), value);
+}
+
+void MainWindow::on_udpGroCheckBox_toggled(bool checked) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] UDP GRO" << (checked ? "enabled" : "disabled");
+#endif
+    emit setUdpGro(checked);
+}
+
+void MainWindow::on_sequenceFieldComboBox_currentIndexChanged(int index) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Sequence field changed to" << ui->sequenceFieldComboBox->itemText(index);
+#endif
+    emit setUdpSequenceField(ui->sequenceFieldComboBox->itemData(index).toInt());
+    if (index <= 0) rxSequenceLabel->clear();
+}
+
+void MainWindow::on_forwardLineEdit_editingFinished() {
+    QString target = ui->forwardLineEdit->text().trimmed();
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Forward target changed to" << target;
+#endif
+    emit setUdpForwardTarget(target);
+    if (target.isEmpty()) rxForwardLabel->clear();
+}
+
+void MainWindow::on_captureBackendComboBox_currentIndexChanged(int index) {
+#ifdef ENABLE_DEBUG
+    qDebug() << "[MainWindow] Capture backend changed to" << ui->captureBackendComboBox->itemText(index);
+#endif
+    emit setUdpCaptureBackend(index, ui->captureInterfaceLineEdit->text().trimmed());
+}
+
+void MainWindow::on_captureInterfaceLineEdit_editingFinished() {
+    emit setUdpCaptureBackend(ui->captureBackendComboBox->currentIndex(), ui->captureInterfaceLineEdit->text().trimmed());
+}
+
 void MainWindow::on_arrayIndexSpinBox_valueChanged(int value)
 {
     QString structText = ui->structTextEdit->toPlainText();
     QList<FieldDef> fields = parseCStruct(structText);
-    int structSize = 0;
-    auto typeSize = [](const QString &type) -> int {
-        if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        return 0;
-    };
-    for (const FieldDef &field : fields) {
-        int sz = typeSize(field.type);
-        if (sz == 0) continue;
-        structSize += sz * field.count;
-    }
+    int structSize = structSizeOf(fields);
     int selectedField = -1;
     int selectedArrayIndex = 0;
     int selectedFieldCount = 1;
@@ -1188,19 +1416,7 @@ void MainWindow::on_arrayIndexSpinBox_valueChanged(int value)
 void MainWindow::on_endiannessCheckBox_toggled(bool checked) {
     QString structText = ui->structTextEdit->toPlainText();
     QList<FieldDef> fields = parseCStruct(structText);
-    int structSize = 0;
-    auto typeSize = [](const QString &type) -> int {
-        if (type == "int8_t" || type == "uint8_t" || type == "char") return 1;
-        if (type == "int16_t" || type == "uint16_t") return 2;
-        if (type == "int32_t" || type == "uint32_t" || type == "float") return 4;
-        if (type == "int64_t" || type == "uint64_t" || type == "double") return 8;
-        return 0;
-    };
-    for (const FieldDef &field : fields) {
-        int sz = typeSize(field.type);
-        if (sz == 0) continue;
-        structSize += sz * field.count;
-    }
+    int structSize = structSizeOf(fields);
     int selectedField = -1;
     int selectedArrayIndex = 0;
     int selectedFieldCount = 1;
@@ -11,6 +11,7 @@
 #include <vector>
 #include <complex>
 #include <QJsonObject>
+#include <QJsonArray>
 #include <QDialog>
 #include "UdpWorker.h"
 #include <QThread>
@@ -34,6 +35,7 @@ private slots:
     void on_ipLineEdit_editingFinished();
     void on_portSpinBox_editingFinished();
     void on_parseStructButton_clicked();
+    void on_exportDecoderButton_clicked();
     void on_fieldTableWidget_itemChanged(QTableWidgetItem *item);
     // Optionally, slot for FFT controls
     void on_applyFftCheckBox_stateChanged(int state);
@@ -45,16 +47,43 @@ private slots:
     void on_presetComboBox_currentIndexChanged(int index);
     void on_editCommandsButton_clicked();
     void on_logToCsvButton_clicked();
-    void handleUdpData(QVector<float> values);
     void on_arrayIndexSpinBox_valueChanged(int value);
     void on_endiannessCheckBox_toggled(bool checked);
     void on_binaryLoggingCheckBox_toggled(bool checked);  // New slot for binary logging
+    void on_receiveModeComboBox_currentIndexChanged(int index);
+    void on_shardCountSpinBox_valueChanged(int value);
+    void on_ringCapacitySpinBox_valueChanged(int value);
+    void on_hugePagesCheckBox_toggled(bool checked);
+    void on_lockMemoryCheckBox_toggled(bool checked);
+    void on_numaLocalCheckBox_toggled(bool checked);
+    void on_overflowComboBox_currentIndexChanged(int index);
+    void on_blockTimeoutSpinBox_valueChanged(int value);
+    void on_preRollSpinBox_valueChanged(int value);
+    void on_preRollMbSpinBox_valueChanged(int value);
+    void on_captureBackendComboBox_currentIndexChanged(int index);
+    void on_captureInterfaceLineEdit_editingFinished();
+    void on_editStreamsButton_clicked();
+    void on_udpGroCheckBox_toggled(bool checked);
+    void on_sequenceFieldComboBox_currentIndexChanged(int index);
+    void on_forwardLineEdit_editingFinished();
 
 signals:
     void startUdp(quint16 port);
     void stopUdp();
     void updateUdpConfig(const QString &structText, const QList<FieldDef> &fields, int structSize, bool endianness, int selectedField, int selectedArrayIndex, int selectedFieldCount);
     void sendCustomDatagram(const QByteArray &data, const QHostAddress &addr, quint16 port);
+    void setUdpReceiveMode(int mode);
+    void setUdpShardCount(int count);
+    void setUdpRingCapacity(int megabytes);
+    void setUdpMemoryPolicy(bool hugePages, bool lockMemory, bool numaLocal);
+    void setUdpOverflowPolicy(int policy, int blockTimeoutMs);
+    void setUdpPreRoll(int seconds, int megabytes);
+    void setUdpCaptureBackend(int backend, const QString &interfaceName);
+    void setUdpStreams(const QList<StreamConfig> &streams);
+    void setUdpGro(bool enable);
+    void setUdpSequenceField(int field);
+    void setUdpDerivedChannels(const QString &text);
+    void setUdpForwardTarget(const QString &target);
 
 private:
     Ui::MainWindow *ui;
@@ -77,6 +106,10 @@ private:
     // Time series buffer for plotting
     QVector<QPointF> valueHistory;
     int maxHistory = 256;
+    static constexpr int MAX_PLOT_POINTS = 10000;
+    // Drains UdpWorker::plotSamples() on the plot timer, into valueHistory or fftBuffer
+    void drainSamples();
+    std::vector<float> sampleBuffer = std::vector<float>(MAX_PLOT_POINTS);
 
     // Add for oscilloscope-style axis scaling
     int xDiv = 256; // default time window (samples)
@@ -98,10 +131,18 @@ private:
     void applyPreset(const QJsonObject &preset);
     void showCustomCommandDialog();
     void updateCustomCommandsUI();
+    QJsonArray streamArray; // Additional streams of the current preset (StreamConfig JSON)
+    void applyStreams();
     LoggingManager* loggingManager = nullptr;
 
     QThread *udpThread = nullptr;
     UdpWorker *udpWorker = nullptr;
+    QLabel *rxRateLabel = nullptr; // Permanent status bar readout of the receive rate
+    QLabel *rxLoadLabel = nullptr; // Receive thread CPU and kernel-to-user latency
+    QLabel *rxDropLabel = nullptr; // Per-stage drop totals since start
+    QLabel *rxSequenceLabel = nullptr; // Sequence gaps, duplicates and reordering
+    QLabel *rxForwardLabel = nullptr; // Forwarded and skipped datagrams
+    QLabel *rxOverflowLabel = nullptr; // Counters of the ring overflow policy
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
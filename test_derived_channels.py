@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Derived channel sender for SpectraDAQ's derived channels
+
+Sends struct { uint32_t seq; int16_t raw; int16_t i; int16_t q; } 64 to a
+datagram, where raw is a slow triangle in ADC counts and (i, q) turns at a
+steady rate with an amplitude of 10000 counts. With the channels below, volts
+plots the triangle between -2.5 and about 2.5, magnitude a flat 10000, and
+phase a sawtooth from -180 to 180 degrees.
+
+Usage:
+  1. Start SpectraDAQ, set struct:  uint32_t seq;  int16_t raw;  int16_t i;  int16_t q;
+     and derived channels:
+         volts = raw * 0.000152 - 2.5
+         magnitude = sqrt(i^2 + q^2)
+         phase = atan2(q, i) * 180 / pi
+     then Parse and select one of them
+  2. Run: python test_derived_channels.py send <seconds> <datagrams/s>
+  3. Log to CSV while sending, then check the channel columns against the fields:
+     python test_derived_channels.py check capture.csv
+"""
+import csv
+import math
+import socket
+import struct
+import sys
+import time
+
+STRUCTS = 64
+PACKET = struct.Struct('<Ihhhxx')  # Padded to 12 bytes, as the compiler pads the struct
+
+def send(duration=10, rate=1000, host='127.0.0.1', port=2023):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    interval = 1.0 / rate
+    print(f"Sending {rate:,} datagrams/s of {STRUCTS} {PACKET.size}-byte structs to {host}:{port} for {duration} s")
+    start = time.perf_counter()
+    seq = 0
+    sent = 0
+    while time.perf_counter() - start < duration:
+        due = start + sent * interval
+        while time.perf_counter() < due:
+            pass
+        data = bytearray()
+        for _ in range(STRUCTS):
+            raw = abs((seq * 16) % 65536 - 32768) - 1  # -1..32767 and back
+            angle = 2 * math.pi * seq / 1000
+            data += PACKET.pack(seq & 0xFFFFFFFF, raw, round(10000 * math.cos(angle)), round(10000 * math.sin(angle)))
+            seq += 1
+        sock.sendto(data, (host, port))
+        sent += 1
+    print(f"Sent {sent:,} datagrams, {seq:,} structs")
+
+def check(filename):
+    # Each derived column against its formula over the row's fields, in float precision
+    formulas = {
+        'volts': lambda r: r['raw'] * 0.000152 - 2.5,
+        'magnitude': lambda r: math.hypot(r['i'], r['q']),
+        'phase': lambda r: math.degrees(math.atan2(r['q'], r['i'])),
+    }
+    rows = 0
+    worst = {name: 0.0 for name in formulas}
+    with open(filename, newline='') as f:
+        reader = csv.DictReader(f)
+        missing = [name for name in formulas if name not in reader.fieldnames]
+        if missing:
+            print(f"No column for {', '.join(missing)}: define the channels before logging")
+            return 1
+        for row in reader:
+            values = {k: float(v) for k, v in row.items() if v not in ('', None)}
+            for name, formula in formulas.items():
+                want = formula(values)
+                worst[name] = max(worst[name], abs(values[name] - want) / max(1.0, abs(want)))
+            rows += 1
+    print(f"{rows:,} rows")
+    for name, diff in worst.items():
+        print(f"  {name:10s} largest relative difference {diff:.2g}{'  BAD' if diff > 1e-4 else ''}")
+    return 1 if any(diff > 1e-4 for diff in worst.values()) else 0
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3 or sys.argv[1] not in ('send', 'check'):
+        print(__doc__)
+        sys.exit(0)
+    if sys.argv[1] == 'send':
+        send(float(sys.argv[2]), int(sys.argv[3]) if len(sys.argv) > 3 else 1000)
+    else:
+        sys.exit(check(sys.argv[2]))
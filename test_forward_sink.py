@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Receiving end for SpectraDAQ's "Forward to" option
+
+Listens on a UDP port and prints, once a second, how many datagrams and bytes
+the forwarder re-sent there. With test_sequence_sender.py as the source it also
+checks the seq counter: forwarding reads the ring without holding it back, so
+under load it may skip packets ("Fwd: N skipped"), but what arrives must be in
+order and unaltered.
+
+Usage:
+  1. Start SpectraDAQ, set "Forward to" to 127.0.0.1:2030 and press Enter
+  2. Run: python test_forward_sink.py 2030 <seconds>
+  3. Send to SpectraDAQ, e.g. python test_sequence_sender.py 10 20000 0
+"""
+import socket
+import struct
+import sys
+import time
+
+def receive_forwarded(port=2030, duration_sec=15):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 8 * 1024 * 1024)
+    sock.bind(('0.0.0.0', port))
+    sock.settimeout(0.2)
+    total = total_bytes = gaps = out_of_order = 0
+    last_seq = None
+    window = window_bytes = 0
+
+    print(f"Listening on port {port} for {duration_sec} s")
+    print("-" * 50)
+    start_time = time.perf_counter()
+    next_report = start_time + 1
+    while True:
+        now = time.perf_counter()
+        if now - start_time >= duration_sec:
+            break
+        if now >= next_report:
+            print(f"{window:,} packets/s, {window_bytes * 8 / 1e6:.2f} Mb/s")
+            window = window_bytes = 0
+            next_report += 1
+        try:
+            data = sock.recv(65536)
+        except socket.timeout:
+            continue
+        total += 1
+        total_bytes += len(data)
+        window += 1
+        window_bytes += len(data)
+        if len(data) == 8:  # test_sequence_sender.py: uint32_t seq; float value;
+            seq, value = struct.unpack('<If', data)
+            if last_seq is not None:
+                if seq < last_seq:
+                    out_of_order += 1
+                elif seq > last_seq + 1:
+                    gaps += 1
+            last_seq = seq
+
+    print("-" * 50)
+    print(f"Received {total:,} datagrams, {total_bytes:,} bytes")
+    if last_seq is not None:
+        print(f"Sequence: {gaps:,} gaps (skipped by the forwarder or lost), {out_of_order:,} out of order")
+
+if __name__ == '__main__':
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 2030
+    duration = int(sys.argv[2]) if len(sys.argv) > 2 else 15
+    receive_forwarded(port, duration)
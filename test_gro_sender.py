@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+GSO sender for testing SpectraDAQ's UDP GRO receive path (Linux only)
+
+Sends the same 8-byte uint64_t counter datagrams as test_high_rate.py, but
+hands the kernel many of them per send() with UDP_SEGMENT (UDP GSO). On
+loopback the coalesced packet reaches a UDP_GRO socket intact, so SpectraDAQ
+splits it back into datagrams itself; without GRO the kernel splits it first.
+
+Usage:
+  1. Start SpectraDAQ, set struct: uint64_t data;
+  2. Pick recvmmsg or an Engine Thread receive mode
+  3. Run: python test_gro_sender.py <seconds> [datagrams per send]
+  4. Compare the Rx pkt/s and receive CPU readouts with "UDP GRO" on and off
+"""
+import socket
+import struct
+import sys
+import time
+
+UDP_SEGMENT = 103  # linux/udp.h
+DATAGRAM_SIZE = 8
+
+def send_gso(host='127.0.0.1', port=2023, duration_sec=10, per_send=64):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.setsockopt(socket.SOL_UDP, UDP_SEGMENT, DATAGRAM_SIZE)
+    except OSError as e:
+        print(f"UDP_SEGMENT not supported: {e}")
+        return
+    sock.connect((host, port))
+
+    print(f"Sending {per_send} x {DATAGRAM_SIZE}-byte datagrams per send() to {host}:{port} for {duration_sec} s")
+    print("-" * 50)
+    counter = 0
+    start_time = time.perf_counter()
+    last_report = start_time
+    last_count = 0
+    try:
+        while True:
+            now = time.perf_counter()
+            if now - start_time >= duration_sec:
+                break
+            payload = struct.pack(f'<{per_send}Q', *range(counter, counter + per_send))
+            try:
+                sock.send(payload)
+                counter += per_send
+            except (BlockingIOError, ConnectionRefusedError):
+                pass  # Nobody listening yet; keep going
+            if now - last_report >= 1.0:
+                print(f"{counter - last_count:>12,} datagrams/s")
+                last_report = now
+                last_count = counter
+    except KeyboardInterrupt:
+        print("\nStopped by user")
+    finally:
+        sock.close()
+
+    elapsed = time.perf_counter() - start_time
+    print("-" * 50)
+    print(f"Sent {counter:,} datagrams in {elapsed:.1f} s ({counter / elapsed:,.0f}/s)")
+
+if __name__ == "__main__":
+    duration = float(sys.argv[1]) if len(sys.argv) > 1 else 10
+    per_send = int(sys.argv[2]) if len(sys.argv) > 2 else 64
+    send_gso(duration_sec=duration, per_send=per_send)
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Multi-stream sender for SpectraDAQ's additional streams
+
+Sends several paced streams at once, each to its own port or multicast group,
+with a distinct payload so the per-stream log files can be told apart:
+stream k sends struct { uint32_t stream; uint32_t counter; } with stream = k.
+
+Usage:
+  1. Start SpectraDAQ; in "Edit Streams" add one stream per target below
+     with struct:  uint32_t stream;  uint32_t counter;
+  2. Run: python test_multi_stream.py <seconds> <packets/s per stream> <target> [<target> ...]
+     where a target is PORT (unicast to 127.0.0.1) or GROUP:PORT (multicast, sent on lo)
+     e.g. python test_multi_stream.py 10 20000 2023 2024 239.1.2.3:2025
+  3. Log to CSV and check each <name>_<stream>.csv holds only its own stream id
+     with no gaps in counter
+"""
+import multiprocessing
+import socket
+import struct
+import sys
+import time
+
+def send_stream(stream_id, target, packets_per_second, duration_sec):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    if ':' in target:
+        host, port = target.split(':')
+        # Keep the group on loopback so a local SpectraDAQ (interface "lo") receives it
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton('127.0.0.1'))
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    else:
+        host, port = '127.0.0.1', target
+    address = (host, int(port))
+    interval = 1.0 / packets_per_second
+
+    start_time = time.perf_counter()
+    next_send = start_time
+    counter = 0
+    while True:
+        now = time.perf_counter()
+        if now - start_time >= duration_sec:
+            break
+        while next_send <= now:
+            sock.sendto(struct.pack('<II', stream_id, counter), address)
+            counter += 1
+            next_send += interval
+        time.sleep(0.0005)
+    sock.close()
+    print(f"Stream {stream_id} -> {host}:{port}: sent {counter:,} packets")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 4:
+        print(__doc__)
+        sys.exit(1)
+    duration = float(sys.argv[1])
+    rate = int(sys.argv[2])
+    targets = sys.argv[3:]
+
+    print(f"Sending {rate:,} packets/s to each of {len(targets)} streams for {duration} s")
+    print("-" * 50)
+    senders = [multiprocessing.Process(target=send_stream, args=(k, t, rate, duration))
+               for k, t in enumerate(targets)]
+    for p in senders:
+        p.start()
+    for p in senders:
+        p.join()
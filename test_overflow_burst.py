@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+Overflow policy check for SpectraDAQ's packet ring ("When full" setting)
+
+Sends numbered bursts faster than the logger writes, so the ring fills, then
+reads the resulting binary log and tells where packets went missing. What to
+expect per policy:
+  Drop Newest    gaps inside each burst, towards its end; the burst's start is kept
+  Drop Oldest    the newest packets of each burst kept; gaps earlier in the burst
+  Block          no gaps while the bursts fit in the socket buffer and the timeout
+  Spill to Disk  no gaps and in order; "Spilled: N, 0 pending" once drained
+The status bar shows the active policy's counters next to the drop counters.
+
+Usage:
+  1. Start SpectraDAQ, set struct:  uint32_t seq;  uint32_t burst;  char pad[1400];
+     set Ring MB to 16, pick a "When full" policy, check 'Binary Logging' and log
+  2. Run: python test_overflow_burst.py send <bursts> <packets per burst> [pause ms]
+  3. Stop logging, then: python test_overflow_burst.py check <capture.bin>
+"""
+import socket
+import struct
+import sys
+import time
+
+PACKET = struct.Struct('<II')  # seq, burst; followed by padding
+PAD = bytes(1400)
+HEADER = struct.Struct('<IIIIQQ')  # See test_packet_timing.py
+RECORD = struct.Struct('<qQ')
+
+def send_bursts(bursts=10, per_burst=200000, pause_ms=2000, host='127.0.0.1', port=2023):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, 8 * 1024 * 1024)
+    seq = 0
+    for burst in range(bursts):
+        start = time.perf_counter()
+        for _ in range(per_burst):
+            try:
+                sock.sendto(PACKET.pack(seq, burst) + PAD, (host, port))
+            except BlockingIOError:
+                pass
+            seq += 1
+        elapsed = time.perf_counter() - start
+        print(f"Burst {burst}: {per_burst:,} packets in {elapsed:.2f} s ({per_burst / elapsed:,.0f} packets/s)")
+        time.sleep(pause_ms / 1000.0)  # Let the logger catch up (and a spill drain)
+    print(f"Sent {seq:,} packets in {bursts} bursts")
+
+def check_log(path):
+    received = {}  # burst -> list of seq in log order
+    order = []
+    with open(path, 'rb') as f:
+        magic = HEADER.unpack(f.read(HEADER.size))[0]
+        if magic != 0x12345678:
+            raise ValueError("Not a SpectraDAQ binary log")
+        while True:
+            record = f.read(RECORD.size)
+            if len(record) < RECORD.size:
+                break
+            _, size = RECORD.unpack(record)
+            payload = f.read(size)
+            if len(payload) < PACKET.size:
+                continue
+            seq, burst = PACKET.unpack_from(payload)
+            received.setdefault(burst, []).append(seq)
+            order.append(seq)
+
+    backwards = sum(1 for a, b in zip(order, order[1:]) if b <= a)
+    print(f"{path}: {len(order):,} packets, {backwards} out of order")
+    print("-" * 50)
+    for burst in sorted(received):
+        seqs = sorted(set(received[burst]))
+        first, last = seqs[0], seqs[-1]
+        missing = (last - first + 1) - len(seqs)
+        # Where the loss sits within the burst: in its first or second half
+        middle = (first + last) / 2
+        early = sum(1 for a, b in zip(seqs, seqs[1:]) if b - a > 1 and a < middle)
+        late = sum(1 for a, b in zip(seqs, seqs[1:]) if b - a > 1 and a >= middle)
+        print(f"Burst {burst}: {len(seqs):,} kept, seq {first}..{last}, {missing:,} missing "
+              f"({early} gaps in the first half, {late} in the second)")
+
+if __name__ == "__main__":
+    if len(sys.argv) >= 3 and sys.argv[1] == 'check':
+        check_log(sys.argv[2])
+    elif len(sys.argv) >= 2 and sys.argv[1] == 'send':
+        bursts = int(sys.argv[2]) if len(sys.argv) > 2 else 10
+        per_burst = int(sys.argv[3]) if len(sys.argv) > 3 else 200000
+        pause = int(sys.argv[4]) if len(sys.argv) > 4 else 2000
+        send_bursts(bursts, per_burst, pause)
+    else:
+        print(__doc__)
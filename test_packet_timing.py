@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""
+Inter-packet timing analysis of a SpectraDAQ binary log
+
+Reads the per-packet receive timestamps from a .bin file and prints
+inter-arrival statistics. Version 2 logs carry kernel receive timestamps
+(SO_TIMESTAMPNS) in nanoseconds when an Engine Thread or recvmmsg mode is
+used; QUdpSocket mode stamps once per read batch.
+
+Usage:
+  1. Start SpectraDAQ, set struct: uint64_t data;
+  2. Check 'Binary Logging', pick a Receive Mode and start logging
+  3. Send a paced stream: python test_receive_engine.py 10000 5
+  4. Run: python test_packet_timing.py <capture.bin> [expected packets/s]
+"""
+import struct
+import sys
+
+HEADER = struct.Struct('<IIIIQQ')  # magic, version, structSize, fieldCount, startTimestamp, packetCount
+RECORD = struct.Struct('<qQ')      # receive timestamp, payload size
+
+def read_timestamps(path):
+    with open(path, 'rb') as f:
+        magic, version, struct_size, field_count, start, count = HEADER.unpack(f.read(HEADER.size))
+        if magic != 0x12345678:
+            raise ValueError("Not a SpectraDAQ binary log")
+        scale = 1 if version >= 2 else 1000000  # Version 1 stamped milliseconds
+        stamps = []
+        while True:
+            record = f.read(RECORD.size)
+            if len(record) < RECORD.size:
+                break
+            timestamp, size = RECORD.unpack(record)
+            f.seek(size, 1)
+            stamps.append(timestamp * scale)
+    return version, stamps
+
+def percentile(sorted_values, p):
+    return sorted_values[min(len(sorted_values) - 1, int(p / 100.0 * len(sorted_values)))]
+
+def analyze(path, expected_rate=None):
+    version, stamps = read_timestamps(path)
+    print(f"{path}: version {version}, {len(stamps):,} packets")
+    if len(stamps) < 2:
+        return
+    gaps = [(b - a) / 1000.0 for a, b in zip(stamps, stamps[1:])]  # us
+    backwards = sum(1 for g in gaps if g < 0)
+    gaps.sort()
+    mean = sum(gaps) / len(gaps)
+    jitter = (sum((g - mean) ** 2 for g in gaps) / len(gaps)) ** 0.5
+    span = (stamps[-1] - stamps[0]) / 1e9
+
+    print("-" * 50)
+    print(f"Capture span:       {span:.3f} s ({(len(stamps) - 1) / span:,.0f} packets/s)" if span > 0 else "Capture span: 0 s")
+    print(f"Inter-arrival mean: {mean:.2f} us, stddev {jitter:.2f} us")
+    print(f"  min {gaps[0]:.2f}  p50 {percentile(gaps, 50):.2f}  p99 {percentile(gaps, 99):.2f}  max {gaps[-1]:.2f} us")
+    print(f"Out-of-order stamps: {backwards}")
+    if expected_rate:
+        expected_us = 1e6 / expected_rate
+        late = sum(1 for g in gaps if g > 2 * expected_us)
+        print(f"Gaps over 2x the {expected_us:.1f} us send interval: {late}")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    rate = int(sys.argv[2]) if len(sys.argv) > 2 else None
+    analyze(sys.argv[1], rate)
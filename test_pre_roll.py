@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+Retroactive capture check for SpectraDAQ ("Pre-roll" setting)
+
+Sends a paced, numbered stream with each packet's send time, so that a log
+started in the middle of it can be checked for how far back it reaches and
+whether the pre-roll joins the live data without a gap.
+
+Usage:
+  1. Start SpectraDAQ, set struct:  uint32_t seq;  uint32_t pad;  double sent;
+     set Pre-roll to e.g. 5 s, check 'Binary Logging'
+  2. Run: python test_pre_roll.py send <seconds> <packets/s>
+     and press Log to CSV some seconds into it
+  3. Stop logging, then: python test_pre_roll.py check <capture.bin>
+"""
+import socket
+import struct
+import sys
+import time
+
+PACKET = struct.Struct('<IId')  # seq, pad, send time (s since the epoch)
+HEADER = struct.Struct('<IIIIQQ')  # See test_packet_timing.py
+RECORD = struct.Struct('<qQ')
+
+def send_stream(duration=30, rate=10000, host='127.0.0.1', port=2023):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    interval = 1.0 / rate
+    start = time.perf_counter()
+    seq = 0
+    while time.perf_counter() - start < duration:
+        due = start + seq * interval
+        while time.perf_counter() < due:
+            pass
+        sock.sendto(PACKET.pack(seq, 0, time.time()), (host, port))
+        seq += 1
+        if seq % rate == 0:
+            print(f"{seq // rate} s: {seq:,} packets sent")
+    print(f"Sent {seq:,} packets")
+
+def check_log(path):
+    with open(path, 'rb') as f:
+        magic, version, _, _, start_ns, _ = HEADER.unpack(f.read(HEADER.size))
+        if magic != 0x12345678 or version < 2:
+            raise ValueError("Not a SpectraDAQ binary log (version 2 or later)")
+        seqs = []
+        stamps = []
+        while True:
+            record = f.read(RECORD.size)
+            if len(record) < RECORD.size:
+                break
+            timestamp_ns, size = RECORD.unpack(record)
+            payload = f.read(size)
+            if len(payload) < PACKET.size:
+                continue
+            seqs.append(PACKET.unpack_from(payload)[0])
+            stamps.append(timestamp_ns)
+
+    if not seqs:
+        print(f"{path}: no packets")
+        return
+    before = sum(1 for t in stamps if t < start_ns)
+    gaps = [(a, b) for a, b in zip(seqs, seqs[1:]) if b != a + 1]
+    print(f"{path}: {len(seqs):,} packets, seq {seqs[0]}..{seqs[-1]}")
+    print(f"Logging started at {start_ns / 1e9:.3f}; the first packet arrived "
+          f"{(start_ns - stamps[0]) / 1e9:.3f} s before that")
+    print(f"Pre-roll: {before:,} packets, then {len(seqs) - before:,} live")
+    print(f"Sequence breaks: {len(gaps)}" + (f", first {gaps[0][0]} -> {gaps[0][1]}" if gaps else ""))
+
+if __name__ == "__main__":
+    if len(sys.argv) >= 3 and sys.argv[1] == 'check':
+        check_log(sys.argv[2])
+    elif len(sys.argv) >= 2 and sys.argv[1] == 'send':
+        duration = float(sys.argv[2]) if len(sys.argv) > 2 else 30
+        rate = int(sys.argv[3]) if len(sys.argv) > 3 else 10000
+        send_stream(duration, rate)
+    else:
+        print(__doc__)
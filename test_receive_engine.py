@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""
+Latency/CPU comparison of SpectraDAQ receive modes
+
+Sends a paced stream of uint64_t packets and, when given SpectraDAQ's PID,
+samples the process CPU usage from /proc while it runs (Linux only).
+
+Usage:
+  1. Start SpectraDAQ, set struct: uint64_t data;
+  2. Pick a Receive Mode (QUdpSocket, recvmmsg, Engine Thread: ...)
+  3. Run: python test_receive_engine.py <packets/s> <seconds> [pid]
+  4. Read the receive-thread "CPU" and "Latency" readouts in the status bar
+     and the process CPU printed here; repeat for each mode
+
+Latency is kernel receive timestamp -> user space, measured by SpectraDAQ.
+"""
+import os
+import socket
+import struct
+import time
+import sys
+
+def process_cpu_seconds(pid):
+    """utime + stime of a process in seconds, or None if unavailable"""
+    try:
+        with open(f"/proc/{pid}/stat") as f:
+            fields = f.read().rsplit(')', 1)[1].split()
+        ticks = int(fields[11]) + int(fields[12])  # utime, stime
+        return ticks / os.sysconf('SC_CLK_TCK')
+    except (OSError, IndexError, ValueError):
+        return None
+
+def run_paced(host='127.0.0.1', port=2023, packets_per_second=100000, duration_sec=10, pid=None):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    interval = 1.0 / packets_per_second
+
+    print(f"Sending {packets_per_second:,} packets/s to {host}:{port} for {duration_sec} s")
+    if pid:
+        print(f"Sampling CPU of PID {pid}")
+    print("-" * 50)
+
+    cpu_start = process_cpu_seconds(pid) if pid else None
+    start_time = time.perf_counter()
+    next_send = start_time
+    last_report = start_time
+    last_cpu = cpu_start
+    packet_count = 0
+
+    try:
+        while True:
+            now = time.perf_counter()
+            if now - start_time >= duration_sec:
+                break
+            # Catch up in small bursts when the interpreter falls behind the schedule
+            while next_send <= now:
+                sock.sendto(struct.pack('<Q', packet_count), (host, port))
+                packet_count += 1
+                next_send += interval
+            if pid and now - last_report >= 1.0:
+                cpu = process_cpu_seconds(pid)
+                if cpu is not None and last_cpu is not None:
+                    print(f"Sent {packet_count:,} packets, SpectraDAQ CPU: {100.0 * (cpu - last_cpu) / (now - last_report):.1f}%")
+                last_cpu = cpu
+                last_report = now
+    except KeyboardInterrupt:
+        print("\nStopped by user")
+
+    elapsed = time.perf_counter() - start_time
+    print("-" * 50)
+    print(f"Total packets sent: {packet_count:,}")
+    print(f"Achieved rate: {packet_count/elapsed:,.0f} packets/s")
+    if pid:
+        cpu_end = process_cpu_seconds(pid)
+        if cpu_start is not None and cpu_end is not None:
+            print(f"Average SpectraDAQ CPU: {100.0 * (cpu_end - cpu_start) / elapsed:.1f}%")
+    sock.close()
+
+if __name__ == "__main__":
+    rate = 100000
+    duration = 10
+    pid = None
+
+    if len(sys.argv) > 1:
+        rate = int(sys.argv[1])
+    if len(sys.argv) > 2:
+        duration = int(sys.argv[2])
+    if len(sys.argv) > 3:
+        pid = int(sys.argv[3])
+
+    print("SpectraDAQ Receive Engine Benchmark")
+    print("=" * 40)
+
+    run_paced(packets_per_second=rate, duration_sec=duration, pid=pid)
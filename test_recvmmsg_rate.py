@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Saturating UDP sender for comparing SpectraDAQ receive modes (packets/s)
+
+Usage:
+  1. Start SpectraDAQ, set struct: uint64_t data;
+  2. Select "QUdpSocket" as Receive Mode and run this script
+  3. Note the "Rx: ... pkt/s" readout in the status bar
+  4. Select "recvmmsg Batch (Linux)" and run the script again
+
+The sender uses several processes so it can outrun a single receiving thread.
+Compare the sent rate printed here with the Rx rate shown by SpectraDAQ
+for each mode; the gap is what the receiver lost.
+"""
+import socket
+import struct
+import time
+import sys
+from multiprocessing import Process, Value
+
+def blast(host, port, duration_sec, payload_size, counter):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, 4 * 1024 * 1024)
+    padding = b'\0' * max(0, payload_size - 8)
+    sent = 0
+    end_time = time.time() + duration_sec
+    while time.time() < end_time:
+        # 256 packets between clock checks keeps the loop tight
+        for _ in range(256):
+            try:
+                sock.sendto(struct.pack('<Q', sent) + padding, (host, port))
+                sent += 1
+            except BlockingIOError:
+                pass
+    with counter.get_lock():
+        counter.value += sent
+    sock.close()
+
+def run_benchmark(host='127.0.0.1', port=2023, duration_sec=10, senders=4, payload_size=8):
+    print(f"Blasting {host}:{port} with {senders} sender processes for {duration_sec} s")
+    print(f"Payload size: {payload_size} bytes")
+    print("-" * 50)
+
+    counter = Value('Q', 0)
+    procs = [Process(target=blast, args=(host, port, duration_sec, payload_size, counter))
+             for _ in range(senders)]
+    start_time = time.time()
+    for p in procs:
+        p.start()
+    for p in procs:
+        p.join()
+    elapsed = time.time() - start_time
+
+    total = counter.value
+    print("-" * 50)
+    print(f"Total packets sent: {total:,}")
+    print(f"Send rate: {total/elapsed:,.0f} packets/s")
+    print(f"Send rate: {total*payload_size*8/(elapsed*1e6):.2f} Mbps")
+    print("Compare with the Rx pkt/s readout in SpectraDAQ's status bar.")
+
+if __name__ == "__main__":
+    duration = 10
+    senders = 4
+    payload = 8
+
+    if len(sys.argv) > 1:
+        duration = int(sys.argv[1])
+    if len(sys.argv) > 2:
+        senders = int(sys.argv[2])
+    if len(sys.argv) > 3:
+        payload = int(sys.argv[3])
+
+    print("SpectraDAQ Receive Mode Benchmark")
+    print("=" * 40)
+
+    run_benchmark(duration_sec=duration, senders=senders, payload_size=payload)
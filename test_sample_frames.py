@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+Sample frame sender for SpectraDAQ's whole-array plotting (Array Index "All")
+
+Sends struct { uint32_t frame; int16_t samples[512]; } where the samples of
+consecutive frames continue one sine wave without a break, so that plotting
+the array with Array Index set to All shows a continuous sine, and Apply FFT
+a single peak at bin (FFT length * cycles per sample). Plotting one element
+instead shows an aliased, much slower wave.
+
+Usage:
+  1. Start SpectraDAQ, set struct:  uint32_t frame;  int16_t samples[512];
+     select "samples" and set Array Index to All
+  2. Run: python test_sample_frames.py <seconds> <frames/s> [cycles per sample, e.g. 0.03125] [--big-endian]
+     (with --big-endian, check "Change Endianness")
+"""
+import math
+import socket
+import struct
+import sys
+import time
+
+SAMPLES = 512
+
+def send_frames(duration=10, rate=1000, cycles=1 / 32, big_endian=False, host='127.0.0.1', port=2023):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    order = '>' if big_endian else '<'
+    frame_struct = struct.Struct(f'{order}I{SAMPLES}h')
+    interval = 1.0 / rate
+    print(f"Sending {rate:,} frames/s ({rate * SAMPLES:,} samples/s) of {frame_struct.size} bytes "
+          f"to {host}:{port} for {duration} s, {cycles} cycles per sample")
+    start = time.perf_counter()
+    frame = 0
+    while time.perf_counter() - start < duration:
+        due = start + frame * interval
+        while time.perf_counter() < due:
+            pass
+        base = frame * SAMPLES
+        samples = [int(20000 * math.sin(2 * math.pi * cycles * (base + i))) for i in range(SAMPLES)]
+        sock.sendto(frame_struct.pack(frame, *samples), (host, port))
+        frame += 1
+    print(f"Sent {frame:,} frames, {frame * SAMPLES:,} samples")
+
+if __name__ == "__main__":
+    args = [a for a in sys.argv[1:] if not a.startswith('--')]
+    if not args:
+        print(__doc__)
+        sys.exit(0)
+    duration = float(args[0])
+    rate = int(args[1]) if len(args) > 1 else 1000
+    cycles = float(args[2]) if len(args) > 2 else 1 / 32
+    send_frames(duration, rate, cycles, '--big-endian' in sys.argv)
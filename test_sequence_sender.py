@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Sequence-counter sender for SpectraDAQ's sequence tracking and reorder window
+
+Sends struct { uint32_t seq; float value; } with a per-packet counter and,
+at the given rate each, drops a packet, sends one twice, or swaps it with the
+next one. Prints how many of each it injected so the status bar readout
+("Seq: N lost, N dup, N reordered, N late") can be checked against it.
+
+Usage:
+  1. Start SpectraDAQ, set struct:  uint32_t seq;  float value;
+     and pick "seq" as the Sequence Field
+  2. Run: python test_sequence_sender.py <seconds> <packets/s> [fault rate, e.g. 0.01]
+  3. Optionally log to CSV: the seq column should be in order, with gaps only
+     where packets were dropped
+"""
+import random
+import socket
+import struct
+import sys
+import time
+
+def send_sequence(host='127.0.0.1', port=2023, duration_sec=10, packets_per_second=20000, fault_rate=0.01):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    address = (host, port)
+    interval = 1.0 / packets_per_second
+    dropped = duplicated = swapped = sent = 0
+    seq = 0
+    held = None  # Packet held back to be sent after its successor
+
+    def send(s):
+        nonlocal sent
+        sock.sendto(struct.pack('<If', s & 0xffffffff, float(s % 1000)), address)
+        sent += 1
+
+    print(f"Sending {packets_per_second:,} packets/s to {host}:{port} for {duration_sec} s, fault rate {fault_rate}")
+    print("-" * 50)
+    start_time = time.perf_counter()
+    next_send = start_time
+    try:
+        while True:
+            now = time.perf_counter()
+            if now - start_time >= duration_sec:
+                break
+            while next_send <= now:
+                r = random.random()
+                if held is None and r < fault_rate:
+                    dropped += 1
+                elif held is None and r < 2 * fault_rate:
+                    send(seq)
+                    send(seq)
+                    duplicated += 1
+                elif held is None and r < 3 * fault_rate:
+                    held = seq
+                else:
+                    send(seq)
+                    if held is not None:
+                        send(held)
+                        held = None
+                        swapped += 1
+                seq += 1
+                next_send += interval
+            time.sleep(0.0005)
+    except KeyboardInterrupt:
+        print("\nStopped by user")
+    finally:
+        if held is not None:
+            send(held)
+        sock.close()
+
+    print("-" * 50)
+    print(f"Sent {sent:,} datagrams for {seq:,} sequence numbers")
+    print(f"Injected: {dropped:,} lost, {duplicated:,} duplicates, {swapped:,} reordered")
+
+if __name__ == "__main__":
+    duration = float(sys.argv[1]) if len(sys.argv) > 1 else 10
+    rate = int(sys.argv[2]) if len(sys.argv) > 2 else 20000
+    faults = float(sys.argv[3]) if len(sys.argv) > 3 else 0.01
+    send_sequence(duration_sec=duration, packets_per_second=rate, fault_rate=faults)
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Firmware-style struct sender for SpectraDAQ's struct layout engine
+
+Sends the packed struct below, with a nested header, an enum, status bitfields (one of
+them, temp, straddling a byte) and an array, laid out byte for byte as GCC lays it out.
+After Parse Struct the Offset column should read: hdr.seq 0, hdr.source 4, mode 6,
+ready 10 bit 0, error 10 bit 1, channel 10 bits 2-7, temp 11 bits 0-11, level 12 bits 4-7,
+value 13, samples 17, and the packet length 25 times the struct count.
+
+Plot any field: seq counts up, mode cycles 0-2, ready/error toggle, channel counts 0-63,
+temp is a signed triangle from -2048 to 2047, level counts 0-15, value is a sine and the
+samples are seq, -seq, 2*seq and -2*seq (16-bit).
+
+Usage:
+  1. Start SpectraDAQ and paste the struct (printed by running without arguments)
+  2. Run: python test_struct_layout.py <seconds> [packets/s]
+"""
+import math
+import socket
+import struct
+import sys
+import time
+
+STRUCT_TEXT = """#pragma pack(push, 1)
+typedef enum { MODE_IDLE, MODE_RUN, MODE_FAULT } Mode;
+typedef struct {
+    uint32_t seq;
+    uint16_t source;
+} Header;
+typedef struct {
+    Header hdr;
+    Mode mode;
+    uint8_t ready : 1;
+    uint8_t error : 1;
+    uint8_t channel : 6;
+    int16_t temp : 12;
+    uint16_t level : 4;
+    float value;
+    int16_t samples[4];
+} Packet;
+#pragma pack(pop)"""
+
+PACKET = struct.Struct('<IHiBHf4h')  # 25 bytes, no padding: the status bits are the B and the H
+
+def make_packet(seq):
+    mode = seq % 3
+    ready, error, channel = seq & 1, (seq >> 1) & 1, seq % 64
+    phase = seq % 4096
+    temp = (phase if phase < 2048 else 4095 - phase) * 2 - 2048
+    level = seq % 16
+    status = ready | (error << 1) | (channel << 2)
+    thermal = (temp & 0xfff) | (level << 12)
+    samples = [((v + 0x8000) & 0xffff) - 0x8000 for v in (seq, -seq, 2 * seq, -2 * seq)]
+    return PACKET.pack(seq, 7, mode, status, thermal, math.sin(seq / 50), *samples)
+
+def send_packets(duration=10, rate=1000, host='127.0.0.1', port=2023):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    interval = 1.0 / rate
+    print(f"Sending {rate:,} packets/s of {PACKET.size} bytes to {host}:{port} for {duration} s")
+    start = time.perf_counter()
+    seq = 0
+    while time.perf_counter() - start < duration:
+        due = start + seq * interval
+        while time.perf_counter() < due:
+            pass
+        sock.sendto(make_packet(seq), (host, port))
+        seq += 1
+    print(f"Sent {seq:,} packets")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        print(STRUCT_TEXT)
+        sys.exit(0)
+    send_packets(float(sys.argv[1]), int(sys.argv[2]) if len(sys.argv) > 2 else 1000)